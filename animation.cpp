@@ -0,0 +1,691 @@
+#include "animation.hpp"
+
+namespace rf
+{
+namespace
+{
+float constexpr kQuatComponentRange = 0.70710678f;
+uint32_t constexpr kQuatComponentMax = (1u << 15) - 1;
+float constexpr kValueMax = 65535.0f;
+
+uint16_t QuantizeUnit(float v, float maxValue)
+{
+  return static_cast<uint16_t>(std::lround(glm::clamp(v, 0.0f, 1.0f) * maxValue));
+}
+}  // namespace
+
+void PackQuaternion(glm::quat const & q, uint16_t * packed)
+{
+  float c[4] = {q.x, q.y, q.z, q.w};
+  uint32_t largest = 0;
+  for (uint32_t i = 1; i < 4; ++i)
+  {
+    if (std::fabs(c[i]) > std::fabs(c[largest]))
+      largest = i;
+  }
+
+  // q and -q are the same rotation, so the largest component is always positive.
+  float const sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+  uint16_t v[3];
+  for (uint32_t i = 0, j = 0; i < 4; ++i)
+  {
+    if (i == largest)
+      continue;
+    float const n = (sign * c[i] / kQuatComponentRange) * 0.5f + 0.5f;
+    v[j++] = QuantizeUnit(n, static_cast<float>(kQuatComponentMax));
+  }
+  packed[0] = static_cast<uint16_t>(((largest >> 1) << 15) | v[0]);
+  packed[1] = static_cast<uint16_t>(((largest & 1) << 15) | v[1]);
+  packed[2] = v[2];
+}
+
+glm::quat UnpackQuaternion(uint16_t const * packed)
+{
+  uint32_t const largest = ((packed[0] >> 15) << 1) | (packed[1] >> 15);
+  float const scale = 2.0f * kQuatComponentRange / kQuatComponentMax;
+  float const a = (packed[0] & kQuatComponentMax) * scale - kQuatComponentRange;
+  float const b = (packed[1] & kQuatComponentMax) * scale - kQuatComponentRange;
+  float const c = (packed[2] & kQuatComponentMax) * scale - kQuatComponentRange;
+  float const d = std::sqrt(std::max(1.0f - a * a - b * b - c * c, 0.0f));
+
+  // The largest component is inserted to its place, the others keep their order.
+  float r[4];
+  r[0] = largest == 0 ? d : a;
+  r[1] = largest == 0 ? a : (largest == 1 ? d : b);
+  r[2] = largest <= 1 ? b : (largest == 2 ? d : c);
+  r[3] = largest == 3 ? d : c;
+  return glm::quat(r[3], r[0], r[1], r[2]);
+}
+
+namespace
+{
+template <typename TKeys, typename GetError>
+void ReduceTrack(TKeys & keys, float tolerance, size_t maxSegmentLength,
+                 GetError const & getError)
+{
+  if (keys.size() < 2)
+    return;
+
+  bool constant = true;
+  for (size_t i = 1; i < keys.size() && constant; ++i)
+    constant = getError(keys[0].second, keys[i].second) <= tolerance;
+  if (constant)
+  {
+    keys.resize(1);
+    keys.shrink_to_fit();
+    return;
+  }
+
+  // Greedy: the segment from the last kept key grows while it reconstructs all the keys inside
+  // and it's not longer than maxSegmentLength.
+  auto isReconstructed = [&](size_t anchor, size_t end)
+  {
+    for (size_t i = anchor + 1; i < end; ++i)
+    {
+      double const k = (keys[i].first - keys[anchor].first) /
+                       (keys[end].first - keys[anchor].first);
+      using Value = typename TKeys::value_type::second_type;
+      Value v;
+      if constexpr(std::is_same<glm::quat, Value>::value)
+        v = glm::slerp(keys[anchor].second, keys[end].second, static_cast<float>(k));
+      else
+        v = glm::mix(keys[anchor].second, keys[end].second, static_cast<float>(k));
+      if (getError(v, keys[i].second) > tolerance)
+        return false;
+    }
+    return true;
+  };
+
+  TKeys result;
+  result.push_back(keys[0]);
+  size_t anchor = 0;
+  for (size_t i = 2; i < keys.size(); ++i)
+  {
+    if (i - anchor > maxSegmentLength || !isReconstructed(anchor, i))
+    {
+      anchor = i - 1;
+      result.push_back(keys[anchor]);
+    }
+  }
+  result.push_back(keys.back());
+  keys.swap(result);
+}
+}  // namespace
+
+void ReduceKeys(BoneAnimation & boneAnimation, KeyframeReduction const & reduction)
+{
+  if (!reduction.m_enabled)
+    return;
+
+  auto const maxSegmentLength = std::max<size_t>(reduction.m_maxSegmentLength, 1);
+  auto vectorError = [](glm::vec3 const & v1, glm::vec3 const & v2)
+  {
+    return glm::length(v1 - v2);
+  };
+  ReduceTrack(boneAnimation.m_translationKeys, reduction.m_translationTolerance,
+              maxSegmentLength, vectorError);
+  ReduceTrack(boneAnimation.m_scaleKeys, reduction.m_scaleTolerance, maxSegmentLength,
+              vectorError);
+  ReduceTrack(boneAnimation.m_rotationKeys, reduction.m_rotationTolerance, maxSegmentLength,
+              [](glm::quat const & q1, glm::quat const & q2)
+  {
+    // Angle of the relative rotation, atan2 keeps the precision for the small angles.
+    auto const r = glm::conjugate(q1) * q2;
+    return 2.0f * std::atan2(glm::length(glm::vec3(r.x, r.y, r.z)), std::fabs(r.w));
+  });
+}
+
+void CompressedAnimation::Compress(std::vector<BoneAnimation> const & boneAnimations)
+{
+  Clear();
+
+  bool wholeTicks = true;
+  auto checkTimes = [&wholeTicks](auto const & keys)
+  {
+    for (auto const & k : keys)
+    {
+      if (k.first < 0.0 || k.first > std::numeric_limits<uint16_t>::max() ||
+          k.first != std::floor(k.first))
+      {
+        wholeTicks = false;
+        return;
+      }
+    }
+  };
+  for (auto const & boneAnim : boneAnimations)
+  {
+    checkTimes(boneAnim.m_translationKeys);
+    checkTimes(boneAnim.m_rotationKeys);
+    checkTimes(boneAnim.m_scaleKeys);
+  }
+
+  std::map<std::vector<float>, uint32_t> timeTracks;
+  m_channels.resize(boneAnimations.size());
+  for (size_t i = 0; i < boneAnimations.size(); ++i)
+  {
+    auto & tracks = m_channels[i];
+    CompressTrack(boneAnimations[i].m_translationKeys, timeTracks,
+                  tracks[AnimationCursor::Translation]);
+    CompressTrack(boneAnimations[i].m_rotationKeys, timeTracks, tracks[AnimationCursor::Rotation]);
+    CompressTrack(boneAnimations[i].m_scaleKeys, timeTracks, tracks[AnimationCursor::Scale]);
+  }
+
+  if (wholeTicks)
+  {
+    m_times.assign(m_floatTimes.begin(), m_floatTimes.end());
+    std::vector<float>().swap(m_floatTimes);
+  }
+  m_times.shrink_to_fit();
+  m_floatTimes.shrink_to_fit();
+  m_values.shrink_to_fit();
+  m_ranges.shrink_to_fit();
+}
+
+template <typename TKeys>
+void CompressedAnimation::CompressTrack(TKeys const & keys,
+                                        std::map<std::vector<float>, uint32_t> & timeTracks,
+                                        Track & track)
+{
+  track.m_keysCount = static_cast<uint32_t>(keys.size());
+  if (keys.empty())
+    return;
+
+  std::vector<float> times(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i)
+    times[i] = static_cast<float>(keys[i].first);
+
+  auto const it = timeTracks.find(times);
+  if (it != timeTracks.end())
+  {
+    track.m_timesOffset = it->second;
+  }
+  else
+  {
+    track.m_timesOffset = static_cast<uint32_t>(m_floatTimes.size());
+    m_floatTimes.insert(m_floatTimes.end(), times.begin(), times.end());
+    timeTracks.insert(std::make_pair(std::move(times), track.m_timesOffset));
+  }
+
+  track.m_valuesOffset = static_cast<uint32_t>(m_values.size());
+  if constexpr(std::is_same<glm::quat, typename TKeys::value_type::second_type>::value)
+  {
+    m_values.resize(m_values.size() + 3 * keys.size());
+    uint16_t * values = m_values.data() + track.m_valuesOffset;
+    for (size_t i = 0; i < keys.size(); ++i)
+      PackQuaternion(keys[i].second, values + 3 * i);
+  }
+  else
+  {
+    glm::vec3 minValue = keys[0].second;
+    glm::vec3 maxValue = keys[0].second;
+    bool uniform = true;
+    for (auto const & k : keys)
+    {
+      minValue = glm::min(minValue, k.second);
+      maxValue = glm::max(maxValue, k.second);
+      uniform = uniform && k.second.x == k.second.y && k.second.x == k.second.z;
+    }
+    glm::vec3 const extent = maxValue - minValue;
+
+    uint32_t const componentsCount = uniform ? 1 : 3;
+    track.m_componentsCount = static_cast<uint8_t>(componentsCount);
+    track.m_rangeOffset = static_cast<uint32_t>(m_ranges.size());
+    for (uint32_t c = 0; c < componentsCount; ++c)
+      m_ranges.push_back(minValue[c]);
+    for (uint32_t c = 0; c < componentsCount; ++c)
+      m_ranges.push_back(extent[c]);
+
+    m_values.resize(m_values.size() + componentsCount * keys.size());
+    uint16_t * values = m_values.data() + track.m_valuesOffset;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+      for (uint32_t c = 0; c < componentsCount; ++c)
+      {
+        float const n = extent[c] > 0.0f ? (keys[i].second[c] - minValue[c]) / extent[c] : 0.0f;
+        values[componentsCount * i + c] = QuantizeUnit(n, kValueMax);
+      }
+    }
+  }
+}
+
+void CompressedAnimation::Clear()
+{
+  m_channels.clear();
+  m_times.clear();
+  m_floatTimes.clear();
+  m_values.clear();
+  m_ranges.clear();
+}
+
+template <typename TTime>
+bool CompressedAnimation::FindKeys(TTime const * times, Track const & track, double animTime,
+                                   uint32_t & cursor, size_t & startIndex, size_t & endIndex,
+                                   float & k) const
+{
+  times += track.m_timesOffset;
+  if (!FindInterpolationIndices(animTime, track.m_keysCount,
+                                [times](size_t i) { return static_cast<double>(times[i]); },
+                                cursor, startIndex, endIndex))
+  {
+    return false;
+  }
+
+  k = 0.0f;
+  if (startIndex != endIndex)
+  {
+    double const t0 = times[startIndex];
+    k = static_cast<float>((animTime - t0) / (static_cast<double>(times[endIndex]) - t0));
+    k = glm::clamp(k, 0.0f, 1.0f);
+  }
+  return true;
+}
+
+bool CompressedAnimation::FindKeys(Track const & track, double animTime, uint32_t & cursor,
+                                   size_t & startIndex, size_t & endIndex, float & k) const
+{
+  if (!m_times.empty())
+    return FindKeys(m_times.data(), track, animTime, cursor, startIndex, endIndex, k);
+  return FindKeys(m_floatTimes.data(), track, animTime, cursor, startIndex, endIndex, k);
+}
+
+glm::vec3 CompressedAnimation::GetVector(Track const & track, double animTime,
+                                         glm::vec3 const & defaultValue, uint32_t & cursor) const
+{
+  size_t startIndex = 0;
+  size_t endIndex = 0;
+  float k = 0.0f;
+  if (!FindKeys(track, animTime, cursor, startIndex, endIndex, k))
+    return defaultValue;
+
+  // Both keys are dequantized by the same multiply-add.
+  uint32_t const n = track.m_componentsCount;
+  uint16_t const * values0 = m_values.data() + track.m_valuesOffset + n * startIndex;
+  uint16_t const * values1 = m_values.data() + track.m_valuesOffset + n * endIndex;
+  float const * range = m_ranges.data() + track.m_rangeOffset;
+  glm::vec3 result;
+  for (uint32_t c = 0; c < 3; ++c)
+  {
+    auto const i = n == 1 ? 0 : c;
+    auto const v = glm::mix(static_cast<float>(values0[i]), static_cast<float>(values1[i]), k);
+    result[c] = range[i] + v * (range[n + i] / kValueMax);
+  }
+  return result;
+}
+
+glm::vec3 CompressedAnimation::GetTranslation(size_t channelIndex, double animTime,
+                                              uint32_t & cursor) const
+{
+  return GetVector(m_channels[channelIndex][AnimationCursor::Translation], animTime, glm::vec3(),
+                   cursor);
+}
+
+glm::vec3 CompressedAnimation::GetScale(size_t channelIndex, double animTime,
+                                        uint32_t & cursor) const
+{
+  return GetVector(m_channels[channelIndex][AnimationCursor::Scale], animTime,
+                   glm::vec3(1.0f, 1.0f, 1.0f), cursor);
+}
+
+glm::quat CompressedAnimation::GetRotation(size_t channelIndex, double animTime,
+                                           uint32_t & cursor) const
+{
+  auto const & track = m_channels[channelIndex][AnimationCursor::Rotation];
+  size_t startIndex = 0;
+  size_t endIndex = 0;
+  float k = 0.0f;
+  if (!FindKeys(track, animTime, cursor, startIndex, endIndex, k))
+    return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+  uint16_t const * values = m_values.data() + track.m_valuesOffset;
+  auto const q0 = UnpackQuaternion(values + 3 * startIndex);
+  if (startIndex == endIndex)
+    return q0;
+  return glm::slerp(q0, UnpackQuaternion(values + 3 * endIndex), k);
+}
+
+size_t CompressedAnimation::GetSizeInBytes() const
+{
+  return sizeof(CompressedAnimation) + m_channels.size() * sizeof(m_channels[0]) +
+         (m_times.size() + m_values.size()) * sizeof(uint16_t) +
+         (m_floatTimes.size() + m_ranges.size()) * sizeof(float);
+}
+
+void MeshAnimation::Compress()
+{
+  m_compressed.Compress(m_boneAnimations);
+  for (auto & boneAnim : m_boneAnimations)
+  {
+    std::vector<std::pair<double, glm::vec3>>().swap(boneAnim.m_translationKeys);
+    std::vector<std::pair<double, glm::vec3>>().swap(boneAnim.m_scaleKeys);
+    std::vector<std::pair<double, glm::quat>>().swap(boneAnim.m_rotationKeys);
+  }
+}
+
+glm::mat4x4 MeshAnimation::CalculateBoneTransform(size_t channelIndex, double animTime,
+                                                  AnimationCursor * cursor) const
+{
+  glm::vec3 pos;
+  glm::quat rotation;
+  glm::vec3 sc;
+  CalculateBoneTransform(channelIndex, animTime, cursor, pos, rotation, sc);
+  return ComposeTransform(pos, rotation, sc);
+}
+
+void MeshAnimation::CalculateBoneTransform(size_t channelIndex, double animTime,
+                                           AnimationCursor * cursor, glm::vec3 & pos,
+                                           glm::quat & rotation, glm::vec3 & sc) const
+{
+  uint32_t keys[AnimationCursor::KeyTypesCount] = {0, 0, 0};
+  auto getKey = [&](AnimationCursor::KeyType keyType) -> uint32_t &
+  {
+    return cursor != nullptr ? cursor->GetKey(channelIndex, keyType) : keys[keyType];
+  };
+
+  if (!m_compressed.IsEmpty())
+  {
+    pos = m_compressed.GetTranslation(channelIndex, animTime,
+                                      getKey(AnimationCursor::Translation));
+    rotation = m_compressed.GetRotation(channelIndex, animTime, getKey(AnimationCursor::Rotation));
+    sc = m_compressed.GetScale(channelIndex, animTime, getKey(AnimationCursor::Scale));
+  }
+  else
+  {
+    auto const & boneAnim = m_boneAnimations[channelIndex];
+    rotation = InterpolateKeys(animTime, boneAnim.m_rotationKeys,
+                               glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                               getKey(AnimationCursor::Rotation));
+    pos = InterpolateKeys(animTime, boneAnim.m_translationKeys, glm::vec3(),
+                          getKey(AnimationCursor::Translation));
+    sc = InterpolateKeys(animTime, boneAnim.m_scaleKeys, glm::vec3(1.0f, 1.0f, 1.0f),
+                         getKey(AnimationCursor::Scale));
+  }
+}
+
+glm::mat4x4 ComposeTransform(glm::vec3 const & translation, glm::quat const & rotation,
+                             glm::vec3 const & scale)
+{
+  glm::mat4x4 m = glm::mat4_cast(rotation);
+  m[0] *= scale.x;
+  m[1] *= scale.y;
+  m[2] *= scale.z;
+  m[3] = glm::vec4(translation, 1.0f);
+  return m;
+}
+
+void DecomposeTransform(glm::mat4x4 const & m, glm::vec3 & translation, glm::quat & rotation,
+                        glm::vec3 & scale)
+{
+  translation = glm::vec3(m[3]);
+  scale = glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])),
+                    glm::length(glm::vec3(m[2])));
+  glm::mat3x3 r(glm::vec3(m[0]) / scale.x, glm::vec3(m[1]) / scale.y, glm::vec3(m[2]) / scale.z);
+  // Mirroring is kept in the scale.
+  if (glm::determinant(r) < 0.0f)
+  {
+    scale.x = -scale.x;
+    r[0] = -r[0];
+  }
+  rotation = glm::normalize(glm::quat_cast(r));
+}
+
+void CrossFadePoses(AnimationPose const * const * poses, float const * weights, size_t posesCount,
+                    AnimationPose & result)
+{
+  if (posesCount == 0)
+    return;
+
+  float weightsSum = 0.0f;
+  for (size_t j = 0; j < posesCount; ++j)
+    weightsSum += weights[j];
+  float const invWeightsSum = weightsSum > 0.0f ? 1.0f / weightsSum : 0.0f;
+
+  auto const nodesCount = poses[0]->GetSize();
+  for (size_t i = 0; i < nodesCount; ++i)
+  {
+    glm::vec3 t(0.0f);
+    glm::vec3 s(0.0f);
+    glm::quat r(0.0f, 0.0f, 0.0f, 0.0f);
+    glm::quat const & q0 = poses[0]->m_rotations[i];
+    for (size_t j = 0; j < posesCount; ++j)
+    {
+      float const w = weights[j] * invWeightsSum;
+      t += poses[j]->m_translations[i] * w;
+      s += poses[j]->m_scales[i] * w;
+      // Quaternions are accumulated in the hemisphere of the first one (nlerp).
+      auto const & q = poses[j]->m_rotations[i];
+      r += q * (glm::dot(q0, q) < 0.0f ? -w : w);
+    }
+    result.m_translations[i] = t;
+    result.m_scales[i] = s;
+    float const len = glm::length(r);
+    result.m_rotations[i] = len > 0.0f ? r / len : q0;
+  }
+}
+
+void BlendPoses(AnimationPose const & base, AnimationPose const & layer, float weight,
+                BoneMask const * mask, AnimationPose & result)
+{
+  auto const nodesCount = base.GetSize();
+  for (size_t i = 0; i < nodesCount; ++i)
+  {
+    float const w = mask != nullptr ? weight * (*mask)[i] : weight;
+    result.m_translations[i] = glm::mix(base.m_translations[i], layer.m_translations[i], w);
+    result.m_rotations[i] = glm::slerp(base.m_rotations[i], layer.m_rotations[i], w);
+    result.m_scales[i] = glm::mix(base.m_scales[i], layer.m_scales[i], w);
+  }
+}
+
+void AddPose(AnimationPose const & base, AnimationPose const & additive,
+             AnimationPose const & reference, float weight, BoneMask const * mask,
+             AnimationPose & result)
+{
+  glm::quat const identity(1.0f, 0.0f, 0.0f, 0.0f);
+  auto const nodesCount = base.GetSize();
+  for (size_t i = 0; i < nodesCount; ++i)
+  {
+    float const w = mask != nullptr ? weight * (*mask)[i] : weight;
+    auto const deltaT = additive.m_translations[i] - reference.m_translations[i];
+    auto const deltaR = glm::inverse(reference.m_rotations[i]) * additive.m_rotations[i];
+    auto const deltaS = additive.m_scales[i] / reference.m_scales[i];
+    result.m_translations[i] = base.m_translations[i] + deltaT * w;
+    result.m_rotations[i] = glm::normalize(base.m_rotations[i] * glm::slerp(identity, deltaR, w));
+    result.m_scales[i] = base.m_scales[i] * glm::mix(glm::vec3(1.0f), deltaS, w);
+  }
+}
+
+void PackMatrix3x4(glm::mat4x4 const & m, float * packed)
+{
+  for (int r = 0; r < 3; ++r)
+  {
+    for (int c = 0; c < 4; ++c)
+      packed[r * 4 + c] = m[c][r];
+  }
+}
+
+glm::mat4x4 UnpackMatrix3x4(float const * packed)
+{
+  glm::mat4x4 m;
+  for (int r = 0; r < 3; ++r)
+  {
+    for (int c = 0; c < 4; ++c)
+      m[c][r] = packed[r * 4 + c];
+  }
+  return m;
+}
+
+void PackDualQuaternion(glm::mat4x4 const & m, float * packed)
+{
+  auto const real = glm::normalize(glm::quat_cast(glm::mat3x3(m)));
+  auto const dual = 0.5f * glm::quat(0.0f, m[3][0], m[3][1], m[3][2]) * real;
+  packed[0] = real.x;
+  packed[1] = real.y;
+  packed[2] = real.z;
+  packed[3] = real.w;
+  packed[4] = dual.x;
+  packed[5] = dual.y;
+  packed[6] = dual.z;
+  packed[7] = dual.w;
+}
+
+glm::mat4x4 UnpackDualQuaternion(float const * packed)
+{
+  glm::quat const real(packed[3], packed[0], packed[1], packed[2]);
+  glm::quat const dual(packed[7], packed[4], packed[5], packed[6]);
+  // Blended dual quaternions are not unit ones.
+  float const invLength = 1.0f / glm::length(real);
+  auto const r = real * invLength;
+  auto const t = 2.0f * (dual * invLength) * glm::conjugate(r);
+  glm::mat4x4 m(glm::mat3_cast(r));
+  m[3] = glm::vec4(t.x, t.y, t.z, 1.0f);
+  return m;
+}
+
+uint32_t GetBoneSize(BonesFormat format)
+{
+  switch (format)
+  {
+    case BonesFormat::Matrix4x4:
+      return 16;
+    case BonesFormat::Matrix3x4:
+      return 12;
+    case BonesFormat::DualQuaternion:
+      return 8;
+  }
+  CHECK(false, "Unknown bones format.");
+  return 0;
+}
+
+void PackBoneTransform(glm::mat4x4 const & m, BonesFormat format, float * packed)
+{
+  switch (format)
+  {
+    case BonesFormat::Matrix4x4:
+      for (int c = 0; c < 4; ++c)
+      {
+        for (int r = 0; r < 4; ++r)
+          packed[c * 4 + r] = m[c][r];
+      }
+      break;
+    case BonesFormat::Matrix3x4:
+      PackMatrix3x4(m, packed);
+      break;
+    case BonesFormat::DualQuaternion:
+      PackDualQuaternion(m, packed);
+      break;
+  }
+}
+
+glm::mat4x4 UnpackBoneTransform(float const * packed, BonesFormat format)
+{
+  switch (format)
+  {
+    case BonesFormat::Matrix4x4:
+    {
+      glm::mat4x4 m;
+      for (int c = 0; c < 4; ++c)
+      {
+        for (int r = 0; r < 4; ++r)
+          m[c][r] = packed[c * 4 + r];
+      }
+      return m;
+    }
+    case BonesFormat::Matrix3x4:
+      return UnpackMatrix3x4(packed);
+    case BonesFormat::DualQuaternion:
+      return UnpackDualQuaternion(packed);
+  }
+  CHECK(false, "Unknown bones format.");
+  return glm::mat4x4();
+}
+
+void PackBonesTransforms(glm::mat4x4 const * transforms, uint32_t bonesCount, BonesFormat format,
+                         float * packed)
+{
+  auto const boneSize = GetBoneSize(format);
+  for (uint32_t i = 0; i < bonesCount; ++i)
+    PackBoneTransform(transforms[i], format, packed + i * boneSize);
+}
+
+void BakedAnimation::Initialize(Format format, uint32_t bonesCount, uint32_t framesCount,
+                                float framesPerSecond, double durationInSeconds)
+{
+  m_format = format;
+  m_bonesCount = bonesCount;
+  m_framesCount = framesCount;
+  m_framesPerSecond = framesPerSecond;
+  m_duration = durationInSeconds;
+  m_data.assign(static_cast<size_t>(framesCount) * bonesCount * GetBoneSize(format), 0.0f);
+}
+
+void BakedAnimation::SetBoneTransform(uint32_t frameIndex, uint32_t boneIndex,
+                                      glm::mat4x4 const & transform)
+{
+  float * packed = m_data.data() +
+    (static_cast<size_t>(frameIndex) * m_bonesCount + boneIndex) * GetBoneSize(m_format);
+  PackBoneTransform(transform, m_format, packed);
+}
+
+void BakedAnimation::FindFrames(double timeSinceStart, bool cycled, uint32_t & frame1,
+                                uint32_t & frame2, float & k) const
+{
+  frame1 = 0;
+  frame2 = 0;
+  k = 0.0f;
+  if (m_framesCount == 0)
+    return;
+
+  double const t = (cycled && m_duration > 0.0) ? std::fmod(timeSinceStart, m_duration)
+                                                : std::min(timeSinceStart, m_duration);
+  double const time = std::max(t, 0.0);
+  auto const lastFrame = m_framesCount - 1;
+  frame1 = std::min(static_cast<uint32_t>(time * m_framesPerSecond), lastFrame);
+  frame2 = std::min(frame1 + 1, lastFrame);
+  if (frame1 == frame2)
+    return;
+
+  // The last frame is at the end of the animation, so the last interval can be shorter.
+  double const time1 = frame1 / static_cast<double>(m_framesPerSecond);
+  double const time2 = std::min(frame2 / static_cast<double>(m_framesPerSecond), m_duration);
+  if (time2 > time1)
+    k = static_cast<float>(std::min((time - time1) / (time2 - time1), 1.0));
+}
+
+void BakedAnimation::GetBonesTransforms(double timeSinceStart, bool cycled, bool interpolate,
+                                        std::vector<glm::mat4x4> & bonesTransforms) const
+{
+  bonesTransforms.resize(m_bonesCount);
+  uint32_t frame1 = 0;
+  uint32_t frame2 = 0;
+  float k = 0.0f;
+  FindFrames(timeSinceStart, cycled, frame1, frame2, k);
+  if (m_framesCount == 0)
+  {
+    std::fill(bonesTransforms.begin(), bonesTransforms.end(), glm::mat4x4());
+    return;
+  }
+
+  if (!interpolate)
+  {
+    frame1 = k < 0.5f ? frame1 : frame2;
+    k = 0.0f;
+  }
+
+  auto const boneSize = GetBoneSize(m_format);
+  float const * data1 = GetFrame(frame1);
+  float const * data2 = GetFrame(frame2);
+  float packed[16];
+  for (uint32_t i = 0; i < m_bonesCount; ++i)
+  {
+    float const * p1 = data1 + i * boneSize;
+    float const * p2 = data2 + i * boneSize;
+    // Dual quaternions are blended linearly in the same hemisphere and normalized by unpacking.
+    float const sign = (m_format == Format::DualQuaternion &&
+                        p1[0] * p2[0] + p1[1] * p2[1] + p1[2] * p2[2] + p1[3] * p2[3] < 0.0f)
+                       ? -1.0f : 1.0f;
+    for (uint32_t j = 0; j < boneSize; ++j)
+      packed[j] = p1[j] + (sign * p2[j] - p1[j]) * k;
+
+    bonesTransforms[i] = UnpackBoneTransform(packed, m_format);
+  }
+}
+}  // namespace rf
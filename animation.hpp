@@ -0,0 +1,368 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace rf
+{
+// Key indices where the playback was on the previous evaluation, one per channel and key type.
+// Every playback instance keeps its own cursor, so the keys of the sequential playback are found
+// in amortized O(1) and random seeks cost O(log n).
+class AnimationCursor
+{
+public:
+  enum KeyType : uint32_t
+  {
+    Translation = 0,
+    Rotation,
+    Scale,
+
+    KeyTypesCount
+  };
+
+  // Resets the cursor if it was used for another animation.
+  void Prepare(size_t animIndex, size_t channelsCount)
+  {
+    if (m_animIndex == animIndex && m_keys.size() == channelsCount * KeyTypesCount)
+      return;
+    m_animIndex = animIndex;
+    m_keys.assign(channelsCount * KeyTypesCount, 0);
+  }
+
+  uint32_t & GetKey(size_t channelIndex, KeyType keyType)
+  {
+    return m_keys[channelIndex * KeyTypesCount + keyType];
+  }
+
+private:
+  size_t m_animIndex = std::numeric_limits<size_t>::max();
+  std::vector<uint32_t> m_keys;
+};
+
+// Finds the first pair of keys with animTime <= getTime(endIndex), the times before the first
+// key are in the first pair. cursor is the start index of the previous search, it is checked
+// first together with the next pair.
+template <typename TTime, typename GetTime>
+bool FindInterpolationIndices(TTime animTime, size_t keysCount, GetTime const & getTime,
+                              uint32_t & cursor, size_t & startIndex, size_t & endIndex)
+{
+  if (keysCount == 0)
+    return false;
+
+  if (keysCount == 1)
+  {
+    startIndex = 0;
+    endIndex = 0;
+    return true;
+  }
+
+  auto const lastPair = keysCount - 2;
+  auto isPair = [&](size_t i)
+  {
+    return animTime <= getTime(i + 1) && (i == 0 || animTime > getTime(i));
+  };
+
+  size_t i = cursor;
+  if (i > lastPair || !isPair(i))
+  {
+    if (i + 1 <= lastPair && isPair(i + 1))
+    {
+      ++i;
+    }
+    else
+    {
+      // The first key in [1, keysCount) with time >= animTime.
+      size_t first = 1;
+      size_t count = keysCount - 1;
+      while (count > 0)
+      {
+        auto const step = count / 2;
+        if (getTime(first + step) < animTime)
+        {
+          first += step + 1;
+          count -= step + 1;
+        }
+        else
+        {
+          count = step;
+        }
+      }
+      if (first == keysCount)
+        return false;
+      i = first - 1;
+    }
+  }
+
+  cursor = static_cast<uint32_t>(i);
+  startIndex = i;
+  endIndex = i + 1;
+  return true;
+}
+
+template <typename TKeys>
+bool FindInterpolationIndices(double animTime, TKeys const & keys, uint32_t & cursor,
+                              size_t & startIndex, size_t & endIndex)
+{
+  return FindInterpolationIndices(animTime, keys.size(),
+                                  [&keys](size_t i) { return keys[i].first; },
+                                  cursor, startIndex, endIndex);
+}
+
+template <typename TKeys, typename TResult>
+TResult InterpolateKeys(double animTime, TKeys const & keys, TResult const & defaultValue,
+                        uint32_t & cursor)
+{
+  size_t startIndex = 0;
+  size_t endIndex = 0;
+  if (FindInterpolationIndices(animTime, keys, cursor, startIndex, endIndex))
+  {
+    TResult result;
+    if (startIndex == endIndex)
+    {
+      result = keys[startIndex].second;
+    }
+    else
+    {
+      double const delta = keys[endIndex].first - keys[startIndex].first;
+      double const k = (animTime - keys[startIndex].first) / delta;
+      if constexpr(std::is_same<glm::quat, TResult>::value)
+        result = glm::slerp(keys[startIndex].second, keys[endIndex].second, static_cast<float>(k));
+      else
+        result = glm::mix(keys[startIndex].second, keys[endIndex].second, static_cast<float>(k));
+    }
+    return result;
+  }
+  return defaultValue;
+}
+
+// Smallest three encoding in 48 bits: 2 bits of the index of the largest component and 15 bits
+// per each of the other components.
+void PackQuaternion(glm::quat const & q, uint16_t * packed);
+glm::quat UnpackQuaternion(uint16_t const * packed);
+
+// The transform is translation * rotation * scale.
+glm::mat4x4 ComposeTransform(glm::vec3 const & translation, glm::quat const & rotation,
+                             glm::vec3 const & scale);
+void DecomposeTransform(glm::mat4x4 const & m, glm::vec3 & translation, glm::quat & rotation,
+                        glm::vec3 & scale);
+
+// Rows of the upper 3x4 part of the transform.
+void PackMatrix3x4(glm::mat4x4 const & m, float * packed);
+glm::mat4x4 UnpackMatrix3x4(float const * packed);
+
+// Real (xyzw) and dual (xyzw) parts of the unit dual quaternion of the transform. Only rigid
+// transforms are representable, the scale is lost.
+void PackDualQuaternion(glm::mat4x4 const & m, float * packed);
+glm::mat4x4 UnpackDualQuaternion(float const * packed);
+
+// Layout of the skinning transforms for the GPU. Every layout is a whole number of RGBA32F texels.
+enum class BonesFormat : uint8_t
+{
+  // Column-major matrix, 16 floats.
+  Matrix4x4,
+  // PackMatrix3x4, 12 floats.
+  Matrix3x4,
+  // PackDualQuaternion, 8 floats. Skinning by blending of dual quaternions keeps the volume
+  // of the twisted joints, but it doesn't support scaled bones.
+  DualQuaternion
+};
+
+// Number of floats per bone.
+uint32_t GetBoneSize(BonesFormat format);
+void PackBoneTransform(glm::mat4x4 const & m, BonesFormat format, float * packed);
+glm::mat4x4 UnpackBoneTransform(float const * packed, BonesFormat format);
+void PackBonesTransforms(glm::mat4x4 const * transforms, uint32_t bonesCount, BonesFormat format,
+                         float * packed);
+
+struct BoneAnimation
+{
+  uint32_t m_boneIndex = 0;
+  std::vector<std::pair<double, glm::vec3>> m_translationKeys;
+  std::vector<std::pair<double, glm::vec3>> m_scaleKeys;
+  std::vector<std::pair<double, glm::quat>> m_rotationKeys;
+};
+
+// Tolerances of the keyframe reduction, keys are dropped if the linear (slerp for rotations)
+// interpolation of their neighbours reconstructs them within the tolerance. The reduction is
+// lossy, so it's opt-in.
+struct KeyframeReduction
+{
+  bool m_enabled = false;
+  // Maximum number of source keys between two kept ones, bounds the cost of the reduction by
+  // O(keys * m_maxSegmentLength) per channel.
+  uint32_t m_maxSegmentLength = 128;
+  // In the units of the mesh.
+  float m_translationTolerance = 1e-4f;
+  // In radians.
+  float m_rotationTolerance = 1e-4f;
+  float m_scaleTolerance = 1e-4f;
+};
+
+// Channels which are constant within the tolerance are collapsed to a single key.
+void ReduceKeys(BoneAnimation & boneAnimation, KeyframeReduction const & reduction);
+
+// Keys of all the channels of an animation in shared SoA arrays. Times are stored in 16 bits if
+// all of them are whole ticks (as in the baked clips) and in floats otherwise, identical time
+// tracks are stored once. Rotations are packed by PackQuaternion, translations and scales are
+// quantized to 16 bits in the range of the track. Vectors with equal components in all the keys
+// (uniform scales) are stored as one component.
+class CompressedAnimation
+{
+public:
+  void Compress(std::vector<BoneAnimation> const & boneAnimations);
+  void Clear();
+  bool IsEmpty() const { return m_channels.empty(); }
+
+  glm::vec3 GetTranslation(size_t channelIndex, double animTime, uint32_t & cursor) const;
+  glm::quat GetRotation(size_t channelIndex, double animTime, uint32_t & cursor) const;
+  glm::vec3 GetScale(size_t channelIndex, double animTime, uint32_t & cursor) const;
+
+  size_t GetSizeInBytes() const;
+
+private:
+  struct Track
+  {
+    uint32_t m_timesOffset = 0;
+    uint32_t m_valuesOffset = 0;
+    uint32_t m_keysCount = 0;
+    // Translations and scales only: the minimum and the extent of every component in m_ranges.
+    uint32_t m_rangeOffset = 0;
+    uint8_t m_componentsCount = 3;
+  };
+
+  template <typename TKeys>
+  void CompressTrack(TKeys const & keys, std::map<std::vector<float>, uint32_t> & timeTracks,
+                     Track & track);
+  template <typename TTime>
+  bool FindKeys(TTime const * times, Track const & track, double animTime, uint32_t & cursor,
+                size_t & startIndex, size_t & endIndex, float & k) const;
+  glm::vec3 GetVector(Track const & track, double animTime, glm::vec3 const & defaultValue,
+                      uint32_t & cursor) const;
+  bool FindKeys(Track const & track, double animTime, uint32_t & cursor, size_t & startIndex,
+                size_t & endIndex, float & k) const;
+
+  std::vector<std::array<Track, AnimationCursor::KeyTypesCount>> m_channels;
+  // Only one of the times arrays is used.
+  std::vector<uint16_t> m_times;
+  std::vector<float> m_floatTimes;
+  std::vector<uint16_t> m_values;
+  std::vector<float> m_ranges;
+};
+
+struct MeshAnimation
+{
+  std::string m_name;
+  double m_durationInTicks = 0.0;
+  double m_ticksPerSecond = 0.0;
+  // Channels, their keys are cleared when the animation is compressed.
+  std::vector<BoneAnimation> m_boneAnimations;
+  CompressedAnimation m_compressed;
+  // Index of the channel in m_boneAnimations per bone index, -1 for the bones without a channel.
+  std::vector<int32_t> m_channelsByBone;
+
+  void BuildChannelsTable(size_t bonesCount)
+  {
+    m_channelsByBone.assign(bonesCount, -1);
+    for (size_t i = 0; i < m_boneAnimations.size(); ++i)
+    {
+      auto const boneIndex = m_boneAnimations[i].m_boneIndex;
+      if (boneIndex < bonesCount && m_channelsByBone[boneIndex] < 0)
+        m_channelsByBone[boneIndex] = static_cast<int32_t>(i);
+    }
+  }
+
+  int32_t FindChannel(uint32_t boneIndex) const
+  {
+    return boneIndex < m_channelsByBone.size() ? m_channelsByBone[boneIndex] : -1;
+  }
+
+  // Replaces the keys of the channels by the compressed ones.
+  void Compress();
+
+  // Transform of the bone relative to its parent. Without a cursor the keys are found by the
+  // binary search.
+  glm::mat4x4 CalculateBoneTransform(size_t channelIndex, double animTime,
+                                     AnimationCursor * cursor) const;
+  void CalculateBoneTransform(size_t channelIndex, double animTime, AnimationCursor * cursor,
+                              glm::vec3 & translation, glm::quat & rotation,
+                              glm::vec3 & scale) const;
+};
+
+// Local transforms of the skeleton nodes in SoA. Poses are allocated once by
+// BaseMesh::InitializePose, sampling and blending don't allocate.
+struct AnimationPose
+{
+  std::vector<glm::vec3> m_translations;
+  std::vector<glm::quat> m_rotations;
+  std::vector<glm::vec3> m_scales;
+
+  void Resize(size_t nodesCount)
+  {
+    m_translations.resize(nodesCount);
+    m_rotations.resize(nodesCount);
+    m_scales.resize(nodesCount);
+  }
+  size_t GetSize() const { return m_rotations.size(); }
+};
+
+// Weights of a layer per skeleton node, see BaseMesh::GetBoneMask.
+using BoneMask = std::vector<float>;
+
+// The result of the blending may be one of the source poses, all the poses must have the same
+// size.
+// Weighted average of the poses (N-way cross-fade), the weights are normalized.
+void CrossFadePoses(AnimationPose const * const * poses, float const * weights, size_t posesCount,
+                    AnimationPose & result);
+// The layer overrides the base pose with the weight, multiplied by the mask if it's not null.
+void BlendPoses(AnimationPose const & base, AnimationPose const & layer, float weight,
+                BoneMask const * mask, AnimationPose & result);
+// The difference of the additive pose from the reference one is applied on top of the base pose.
+void AddPose(AnimationPose const & base, AnimationPose const & additive,
+             AnimationPose const & reference, float weight, BoneMask const * mask,
+             AnimationPose & result);
+
+using MeshAnimations = std::vector<std::unique_ptr<MeshAnimation>>;
+
+// Skinning transforms of an animation sampled at a fixed rate, the frames are stored one after
+// another, the bones of a frame are in the order of the bone indices. The first frame is at the
+// start and the last one is at the end of the animation. The data can be uploaded to a RGBA32F
+// buffer texture as is, e.g. a bone takes 3 texels as a 3x4 matrix or 2 texels as a dual
+// quaternion.
+class BakedAnimation
+{
+public:
+  using Format = BonesFormat;
+
+  void Initialize(Format format, uint32_t bonesCount, uint32_t framesCount,
+                  float framesPerSecond, double durationInSeconds);
+
+  // Frames to blend at the time, k is the weight of the second one.
+  void FindFrames(double timeSinceStart, bool cycled, uint32_t & frame1, uint32_t & frame2,
+                  float & k) const;
+  // Without interpolation the nearest frame is used.
+  void GetBonesTransforms(double timeSinceStart, bool cycled, bool interpolate,
+                          std::vector<glm::mat4x4> & bonesTransforms) const;
+
+  void SetBoneTransform(uint32_t frameIndex, uint32_t boneIndex, glm::mat4x4 const & transform);
+
+  float const * GetFrame(uint32_t frameIndex) const
+  {
+    return m_data.data() + static_cast<size_t>(frameIndex) * m_bonesCount * GetBoneSize(m_format);
+  }
+  std::vector<float> const & GetData() const { return m_data; }
+  size_t GetSizeInBytes() const { return m_data.size() * sizeof(float); }
+
+  Format GetFormat() const { return m_format; }
+  uint32_t GetBonesCount() const { return m_bonesCount; }
+  uint32_t GetFramesCount() const { return m_framesCount; }
+  float GetFramesPerSecond() const { return m_framesPerSecond; }
+  double GetDuration() const { return m_duration; }
+
+private:
+  Format m_format = Format::Matrix3x4;
+  uint32_t m_bonesCount = 0;
+  uint32_t m_framesCount = 0;
+  float m_framesPerSecond = 0.0f;
+  double m_duration = 0.0;
+  std::vector<float> m_data;
+};
+}  // namespace rf
@@ -0,0 +1,169 @@
+#include "animation_lod.hpp"
+#include "camera.hpp"
+
+namespace rf
+{
+namespace
+{
+// The invisible instances are still updated under the budget, but after the visible ones.
+float constexpr kMinImportance = 1e-3f;
+
+void InterpolateTransforms(AnimationLodState const & state, glm::mat4x4 * bonesTransforms)
+{
+  // The current transforms are reached by the next update.
+  float const k = std::min(static_cast<float>(state.m_framesSinceUpdate + 1) /
+                           static_cast<float>(std::max(state.m_updateInterval, 1u)), 1.0f);
+  for (size_t i = 0; i < state.m_current.size(); ++i)
+  {
+    for (int c = 0; c < 4; ++c)
+      bonesTransforms[i][c] = glm::mix(state.m_previous[i][c], state.m_current[i][c], k);
+  }
+}
+}  // namespace
+
+AnimationLod::AnimationLod(AnimationLodSettings const & settings)
+  : m_settings(settings)
+{}
+
+// static
+float AnimationLod::GetScreenSize(Camera const & camera, AABB const & box)
+{
+  if (box.isNull())
+    return 0.0f;
+
+  float const radius = 0.5f * glm::length(box.getDiagonal());
+  float const distance = glm::length(box.getCenter() - camera.GetPosition());
+  if (distance <= radius)
+    return 1.0f;
+  return std::min(radius / (distance * std::tan(0.5f * camera.GetFov())), 1.0f);
+}
+
+uint32_t AnimationLod::SelectLevel(Camera const & camera, AABB const & box) const
+{
+  auto const levelsCount = static_cast<uint32_t>(m_settings.m_levels.size());
+  if (levelsCount == 0 || !camera.IsBoxInFrustum(box))
+    return levelsCount;
+
+  auto const screenSize = GetScreenSize(camera, box);
+  for (uint32_t i = 0; i < levelsCount; ++i)
+  {
+    if (screenSize >= m_settings.m_levels[i].m_minScreenSize)
+      return i;
+  }
+  return levelsCount - 1;
+}
+
+AnimationLodLevel const & AnimationLod::GetLevel(uint32_t level) const
+{
+  return level < m_settings.m_levels.size() ? m_settings.m_levels[level]
+                                            : m_settings.m_invisibleLevel;
+}
+
+void AnimationLod::Update(Camera const & camera, std::vector<Request> const & requests,
+                          std::vector<glm::mat4x4> & bonesTransforms,
+                          std::vector<uint32_t> & offsets)
+{
+  auto const requestsCount = static_cast<uint32_t>(requests.size());
+  offsets.resize(requestsCount + 1);
+  offsets[0] = 0;
+  for (uint32_t i = 0; i < requestsCount; ++i)
+  {
+    auto const * mesh = requests[i].m_bones.m_mesh;
+    offsets[i + 1] = offsets[i] + (mesh != nullptr ? mesh->GetBonesCount() : 0);
+  }
+  bonesTransforms.resize(offsets.back());
+
+  m_dueRequests.clear();
+  m_updatedRequests.clear();
+  for (uint32_t i = 0; i < requestsCount; ++i)
+  {
+    auto const & r = requests[i];
+    if (r.m_bones.m_mesh == nullptr)
+      continue;
+
+    auto * state = r.m_state;
+    if (state == nullptr)
+    {
+      m_updatedRequests.push_back(i);
+      continue;
+    }
+
+    state->m_level = SelectLevel(camera, r.m_boundingBox);
+    state->m_framesSinceUpdate++;
+
+    // The instances without the transforms can't be postponed.
+    auto const bonesCount = offsets[i + 1] - offsets[i];
+    if (state->m_current.size() != bonesCount || state->m_previous.size() != bonesCount)
+    {
+      m_updatedRequests.push_back(i);
+      continue;
+    }
+
+    auto const updateInterval = std::max(GetLevel(state->m_level).m_updateInterval, 1u);
+    if (state->m_framesSinceUpdate < updateInterval)
+      continue;
+
+    // The postponed instances gain the importance, so they are not starved.
+    float const screenSize = state->m_level < m_settings.m_levels.size()
+                             ? GetScreenSize(camera, r.m_boundingBox) : 0.0f;
+    float const overdue = static_cast<float>(state->m_framesSinceUpdate) / updateInterval;
+    m_dueRequests.emplace_back((screenSize + kMinImportance) * overdue, i);
+  }
+
+  auto const budget = m_settings.m_maxUpdatesPerFrame;
+  if (budget > 0)
+  {
+    auto const available = budget > m_updatedRequests.size()
+                           ? budget - m_updatedRequests.size() : 0;
+    if (m_dueRequests.size() > available)
+    {
+      std::nth_element(m_dueRequests.begin(), m_dueRequests.begin() + available,
+                       m_dueRequests.end(), std::greater<>());
+      m_dueRequests.resize(available);
+    }
+  }
+  for (auto const & [importance, i] : m_dueRequests)
+    m_updatedRequests.push_back(i);
+
+  m_evaluations.clear();
+  m_evaluations.reserve(m_updatedRequests.size());
+  for (auto const i : m_updatedRequests)
+  {
+    m_evaluations.push_back(requests[i].m_bones);
+    if (requests[i].m_state != nullptr)
+    {
+      m_evaluations.back().m_skippedLevels =
+        GetLevel(requests[i].m_state->m_level).m_skippedLevels;
+    }
+  }
+  BaseMesh::GetBonesTransforms(m_evaluations, m_evaluatedTransforms, m_evaluatedOffsets);
+  m_updatesCount = static_cast<uint32_t>(m_updatedRequests.size());
+
+  for (size_t k = 0; k < m_updatedRequests.size(); ++k)
+  {
+    auto const i = m_updatedRequests[k];
+    auto const begin = m_evaluatedTransforms.begin() + m_evaluatedOffsets[k];
+    auto const end = m_evaluatedTransforms.begin() + m_evaluatedOffsets[k + 1];
+    auto * state = requests[i].m_state;
+    if (state == nullptr)
+    {
+      std::copy(begin, end, bonesTransforms.begin() + offsets[i]);
+      continue;
+    }
+
+    if (state->m_current.size() == static_cast<size_t>(end - begin))
+      state->m_previous.swap(state->m_current);
+    else
+      state->m_previous.assign(begin, end);
+    state->m_current.assign(begin, end);
+    state->m_updateInterval = GetLevel(state->m_level).m_updateInterval;
+    state->m_framesSinceUpdate = 0;
+  }
+
+  for (uint32_t i = 0; i < requestsCount; ++i)
+  {
+    if (requests[i].m_bones.m_mesh != nullptr && requests[i].m_state != nullptr)
+      InterpolateTransforms(*requests[i].m_state, bonesTransforms.data() + offsets[i]);
+  }
+}
+}  // namespace rf
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "base_mesh.hpp"
+
+namespace rf
+{
+class Camera;
+
+struct AnimationLodLevel
+{
+  // The level is used while the bounding sphere of the instance takes at least this fraction of
+  // the screen height.
+  float m_minScreenSize = 0.0f;
+  // The bones transforms are evaluated every m_updateInterval frames.
+  uint32_t m_updateInterval = 1;
+  // See BaseMesh::BonesTransformsRequest::m_skippedLevels.
+  uint32_t m_skippedLevels = 0;
+};
+
+struct AnimationLodSettings
+{
+  // From the most detailed level, the screen sizes must decrease.
+  std::vector<AnimationLodLevel> m_levels = {{0.25f, 1, 0}, {0.1f, 2, 1}, {0.03f, 4, 2},
+                                             {0.0f, 8, 3}};
+  // The instances out of the frustum.
+  AnimationLodLevel m_invisibleLevel = {0.0f, 16, 3};
+  // Budget of the evaluations per frame, 0 is unlimited. The most important of the due instances
+  // are evaluated, the others wait for the next frames.
+  uint32_t m_maxUpdatesPerFrame = 0;
+};
+
+// LOD of an animated instance between the frames, must not be shared between the instances.
+struct AnimationLodState
+{
+  std::vector<glm::mat4x4> m_previous;
+  std::vector<glm::mat4x4> m_current;
+  uint32_t m_level = 0;
+  uint32_t m_updateInterval = 1;
+  uint32_t m_framesSinceUpdate = 0;
+};
+
+// Scales the cost of the animation with the screen importance of the instances instead of their
+// number. The importance is the projected size of the bounding sphere, it selects the update
+// rate and the skeleton LOD of the instance.
+class AnimationLod
+{
+public:
+  struct Request
+  {
+    BaseMesh::BonesTransformsRequest m_bones;
+    // World space bounds of the instance.
+    AABB m_boundingBox;
+    AnimationLodState * m_state = nullptr;
+  };
+
+  AnimationLod() = default;
+  explicit AnimationLod(AnimationLodSettings const & settings);
+
+  void SetSettings(AnimationLodSettings const & settings) { m_settings = settings; }
+  AnimationLodSettings const & GetSettings() const { return m_settings; }
+
+  // Projected diameter of the bounding sphere of the box in fractions of the screen height.
+  static float GetScreenSize(Camera const & camera, AABB const & box);
+  // Index in AnimationLodSettings::m_levels, the size of m_levels for the invisible level.
+  uint32_t SelectLevel(Camera const & camera, AABB const & box) const;
+  AnimationLodLevel const & GetLevel(uint32_t level) const;
+
+  // Must be called once per frame. Evaluates the due instances in parallel, the others are
+  // interpolated between their last two evaluations, so they lag behind by up to an update
+  // interval. Matrices are interpolated linearly, which is acceptable for the small motion
+  // between the updates. The output is the same as of the batched BaseMesh::GetBonesTransforms,
+  // requests without the state are evaluated every frame.
+  void Update(Camera const & camera, std::vector<Request> const & requests,
+              std::vector<glm::mat4x4> & bonesTransforms, std::vector<uint32_t> & offsets);
+
+  // Evaluations in the last Update.
+  uint32_t GetUpdatesCount() const { return m_updatesCount; }
+
+private:
+  AnimationLodSettings m_settings;
+  uint32_t m_updatesCount = 0;
+
+  std::vector<std::pair<float, uint32_t>> m_dueRequests;
+  std::vector<uint32_t> m_updatedRequests;
+  std::vector<BaseMesh::BonesTransformsRequest> m_evaluations;
+  std::vector<glm::mat4x4> m_evaluatedTransforms;
+  std::vector<uint32_t> m_evaluatedOffsets;
+};
+}  // namespace rf
@@ -1,5 +1,7 @@
 #include "base_mesh.hpp"
 #include "mesh_generator.hpp"
+#include "parallel.hpp"
+#include "terrain_quadtree.hpp"
 #include "rf.hpp"
 
 #include <assimp/postprocess.h>
@@ -199,6 +201,33 @@ void CopyVertexBufferPartially(BaseMesh::MeshGroup & group, MeshVertexAttribute
   }
 }
 
+// Tangents are calculated natively instead of aiProcess_CalcTangentSpace, so loaded and
+// generated meshes have the same tangent space.
+std::vector<glm::vec3> CalculateTangents(aiMesh const * mesh)
+{
+  std::vector<glm::vec3> positions(mesh->mNumVertices);
+  std::vector<glm::vec3> normals(mesh->mNumVertices);
+  std::vector<glm::vec2> uv(mesh->mNumVertices);
+  for (uint32_t i = 0; i < mesh->mNumVertices; ++i)
+  {
+    positions[i] = GetVector3(mesh->mVertices[i]);
+    normals[i] = GetVector3(mesh->mNormals[i]);
+    uv[i] = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+  }
+
+  std::vector<uint32_t> indices;
+  indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
+  for (uint32_t i = 0; i < mesh->mNumFaces; ++i)
+  {
+    if (mesh->mFaces[i].mNumIndices == 3)
+      indices.insert(indices.end(), mesh->mFaces[i].mIndices, mesh->mFaces[i].mIndices + 3);
+  }
+
+  std::vector<glm::vec3> tangents;
+  MeshGenerator::CalculateTangents(positions, normals, uv, indices, tangents);
+  return tangents;
+}
+
 void LoadNode(std::unique_ptr<BaseMesh::MeshNode> & meshNode, aiScene const * scene,
               aiNode const * node, uint32_t desiredAttributesMask,
               uint32_t & attributesMask, uint32_t & verticesCount,
@@ -220,8 +249,18 @@ void LoadNode(std::unique_ptr<BaseMesh::MeshNode> & meshNode, aiScene const * sc
     if (mesh->HasNormals() && (desiredAttributesMask & MeshVertexAttribute::Normal))
       CopyVertexBuffer(group, MeshVertexAttribute::Normal, mesh->mNormals, numVertices);
 
-    if (mesh->HasTangentsAndBitangents() && (desiredAttributesMask & MeshVertexAttribute::Tangent))
-      CopyVertexBuffer(group, MeshVertexAttribute::Tangent, mesh->mTangents, numVertices);
+    if (desiredAttributesMask & MeshVertexAttribute::Tangent)
+    {
+      if (mesh->HasNormals() && mesh->HasTextureCoords(0))
+      {
+        auto const tangents = CalculateTangents(mesh);
+        CopyVertexBuffer(group, MeshVertexAttribute::Tangent, tangents.data(), numVertices);
+      }
+      else if (mesh->HasTangentsAndBitangents())
+      {
+        CopyVertexBuffer(group, MeshVertexAttribute::Tangent, mesh->mTangents, numVertices);
+      }
+    }
 
     if (mesh->HasVertexColors(0) && (desiredAttributesMask & MeshVertexAttribute::Color))
       CopyVertexBuffer(group, MeshVertexAttribute::Color, mesh->mColors[0], numVertices);
@@ -247,12 +286,6 @@ void LoadNode(std::unique_ptr<BaseMesh::MeshNode> & meshNode, aiScene const * sc
         if (bonesIndices.find(boneName) == bonesIndices.end())
         {
           auto const newBoneIndex = static_cast<uint32_t>(bonesIndices.size());
-          if (newBoneIndex >= kMaxBonesNumber)
-          {
-            Logger::ToLogWithFormat(Logger::Warning, "Maximum number of bones (%d) is exceeded.",
-                                    kMaxBonesNumber);
-            continue;
-          }
           bonesIndices.insert(std::make_pair(boneName, newBoneIndex));
         }
 
@@ -363,73 +396,35 @@ glm::mat4x4 CalculateTransform(int index, std::unique_ptr<BaseMesh::MeshNode> co
   return t;
 }
 
-template <typename TKeys>
-bool FindInterpolationIndices(double animTime, TKeys const & keys, size_t & startIndex,
-                              size_t & endIndex)
+double GetAnimationTime(MeshAnimation const & animation, double timeSinceStart, bool cycled)
 {
-  if (keys.empty())
-    return false;
-
-  if (keys.size() == 1)
-  {
-    startIndex = 0;
-    endIndex = 0;
-    return true;
-  }
-
-  for (size_t i = 0; i + 1 < keys.size(); i++)
-  {
-    if (animTime <= keys[i + 1].first)
-    {
-      startIndex = i;
-      endIndex = i + 1;
-      return true;
-    }
-  }
-
-  return false;
+  double const timeInTicks = animation.m_ticksPerSecond * timeSinceStart;
+  return cycled ? std::fmod(timeInTicks, animation.m_durationInTicks)
+                : std::min(timeInTicks, animation.m_durationInTicks);
 }
 
-template <typename TKeys, typename TResult>
-TResult InterpolateKeys(double animTime, TKeys const & keys, TResult const & defaultValue)
+void CalculateBonesOffsets(std::vector<BaseMesh::BonesTransformsRequest> const & requests,
+                           std::vector<uint32_t> & offsets)
 {
-  size_t startIndex = 0;
-  size_t endIndex = 0;
-  if (FindInterpolationIndices(animTime, keys, startIndex, endIndex))
+  offsets.resize(requests.size() + 1);
+  offsets[0] = 0;
+  for (size_t i = 0; i < requests.size(); ++i)
   {
-    TResult result;
-    if (startIndex == endIndex)
-    {
-      result = keys[startIndex].second;
-    }
-    else
-    {
-      double const delta = keys[endIndex].first - keys[startIndex].first;
-      double const k = (animTime - keys[startIndex].first) / delta;
-      if constexpr(std::is_same<glm::quat, TResult>::value)
-        result = glm::slerp(keys[startIndex].second, keys[endIndex].second, static_cast<float>(k));
-      else
-        result = glm::mix(keys[startIndex].second, keys[endIndex].second, static_cast<float>(k));
-    }
-    return result;
+    auto const * mesh = requests[i].m_mesh;
+    offsets[i + 1] = offsets[i] + (mesh != nullptr ? mesh->GetBonesCount() : 0);
   }
-  return defaultValue;
 }
 
-glm::mat4x4 CalculateBoneAnimation(BoneAnimation const & boneAnim, double animTime)
+void ForEachRequest(size_t requestsCount, std::function<void(uint32_t index)> const & func)
 {
-  glm::mat4x4 const rotationM(InterpolateKeys(animTime, boneAnim.m_rotationKeys,
-                                              glm::quat(1.0f, 0.0f, 0.0f, 0.0f)));
-
-  glm::vec3 const pos = InterpolateKeys(animTime, boneAnim.m_translationKeys,
-                                        glm::vec3());
-  glm::mat4x4 const translationM = glm::translate(glm::mat4x4(), pos);
-
-  glm::vec3 const sc = InterpolateKeys(animTime, boneAnim.m_scaleKeys,
-                                       glm::vec3(1.0f, 1.0f, 1.0f));
-  glm::mat4x4 const scaleM = glm::scale(glm::mat4x4(), sc);
-
-  return translationM * rotationM * scaleM;
+  uint32_t constexpr kRequestsPerBlock = 16;
+  auto const count = static_cast<uint32_t>(requestsCount);
+  ParallelFor((count + kRequestsPerBlock - 1) / kRequestsPerBlock, [&](uint32_t blockIndex)
+  {
+    uint32_t const endIndex = std::min((blockIndex + 1) * kRequestsPerBlock, count);
+    for (uint32_t i = blockIndex * kRequestsPerBlock; i < endIndex; ++i)
+      func(i);
+  });
 }
 
 bool FindBonesInHierarchy(std::unique_ptr<BaseMesh::MeshNode> const & node,
@@ -523,67 +518,287 @@ size_t BaseMesh::GetAnimationsCount() const
   return m_animations.size();
 }
 
-glm::mat4x4 BaseMesh::FindBoneAnimation(uint32_t boneIndex, size_t animIndex, double animTime,
-                                        bool & found)
+void BaseMesh::CompressAnimations()
+{
+  for (auto & animation : m_animations)
+    animation->Compress();
+}
+
+void BaseMesh::GetBonesTransforms(int groupIndex, size_t animIndex, double timeSinceStart, bool cycled,
+                                  std::vector<glm::mat4x4> & bonesTransforms)
+{
+  bonesTransforms.resize(GetBonesCount());
+  CalculateBonesTransforms(groupIndex, animIndex, timeSinceStart, cycled, nullptr,
+                           bonesTransforms.data());
+}
+
+void BaseMesh::GetBonesTransforms(int groupIndex, size_t animIndex, double timeSinceStart, bool cycled,
+                                  std::vector<glm::mat4x4> & bonesTransforms,
+                                  AnimationCursor & cursor)
+{
+  bonesTransforms.resize(GetBonesCount());
+  CalculateBonesTransforms(groupIndex, animIndex, timeSinceStart, cycled, &cursor,
+                           bonesTransforms.data());
+}
+
+// static
+void BaseMesh::GetBonesTransforms(std::vector<BonesTransformsRequest> const & requests,
+                                  std::vector<glm::mat4x4> & bonesTransforms,
+                                  std::vector<uint32_t> & offsets)
 {
-  for (auto const & boneAnim : m_animations[animIndex]->m_boneAnimations)
+  CalculateBonesOffsets(requests, offsets);
+  bonesTransforms.resize(offsets.back());
+  ForEachRequest(requests.size(), [&](uint32_t i)
   {
-    if (boneAnim.m_boneIndex == boneIndex)
+    auto const & r = requests[i];
+    if (r.m_mesh != nullptr)
     {
-      found = true;
-      return CalculateBoneAnimation(boneAnim, animTime);
+      r.m_mesh->CalculateBonesTransforms(r.m_groupIndex, r.m_animIndex, r.m_timeSinceStart,
+                                         r.m_cycled, r.m_cursor,
+                                         bonesTransforms.data() + offsets[i], r.m_skippedLevels);
     }
-  }
-  found = false;
-  return glm::mat4x4();
+  });
 }
 
-void BaseMesh::CalculateBonesTransform(size_t animIndex, double animTime, BaseMesh::MeshGroup const & group,
-                                       std::unique_ptr<BaseMesh::MeshNode> const & meshNode,
-                                       glm::mat4x4 const & parentTransform,
-                                       std::vector<glm::mat4x4> & bonesTransforms)
+// static
+void BaseMesh::GetBonesTransforms(std::vector<BonesTransformsRequest> const & requests,
+                                  BonesFormat format, std::vector<float> & bonesData,
+                                  std::vector<uint32_t> & offsets)
 {
-  glm::mat4x4 t = parentTransform * meshNode->m_transform;
-  auto it = m_bonesIndices.find(meshNode->m_name);
-  if (it != m_bonesIndices.end())
+  CalculateBonesOffsets(requests, offsets);
+  auto const boneSize = GetBoneSize(format);
+  bonesData.resize(static_cast<size_t>(offsets.back()) * boneSize);
+  ForEachRequest(requests.size(), [&](uint32_t i)
   {
-    bool found = false;
-    glm::mat4x4 boneTransform = FindBoneAnimation(it->second, animIndex, animTime, found);
-    if (found)
-      t = parentTransform * boneTransform;
+    auto const & r = requests[i];
+    if (r.m_mesh == nullptr)
+      return;
+
+    thread_local std::vector<glm::mat4x4> transforms;
+    transforms.resize(r.m_mesh->GetBonesCount());
+    r.m_mesh->CalculateBonesTransforms(r.m_groupIndex, r.m_animIndex, r.m_timeSinceStart,
+                                       r.m_cycled, r.m_cursor, transforms.data(),
+                                       r.m_skippedLevels);
+    PackBonesTransforms(transforms.data(), static_cast<uint32_t>(transforms.size()), format,
+                        bonesData.data() + static_cast<size_t>(offsets[i]) * boneSize);
+  });
+}
 
-    auto const boneOffsetIt = group.m_boneOffsets.find(it->second);
-    if (boneOffsetIt != group.m_boneOffsets.end())
-      bonesTransforms[it->second] = t * boneOffsetIt->second;
+bool BaseMesh::BakeAnimation(int groupIndex, size_t animIndex, float framesPerSecond,
+                             BakedAnimation::Format format,
+                             BakedAnimation & bakedAnimation) const
+{
+  if (animIndex >= m_animations.size() || framesPerSecond <= 0.0f)
+  {
+    Logger::ToLog(Logger::Error, "Invalid parameters of the animation baking.");
+    return false;
   }
 
-  for (auto const & c : meshNode->m_children)
-    CalculateBonesTransform(animIndex, animTime, group, c, t, bonesTransforms);
+  auto const & animation = *m_animations[animIndex];
+  double const duration = animation.m_durationInTicks / animation.m_ticksPerSecond;
+  auto const framesCount = static_cast<uint32_t>(std::ceil(duration * framesPerSecond)) + 1;
+  auto const bonesCount = GetBonesCount();
+  bakedAnimation.Initialize(format, bonesCount, framesCount, framesPerSecond, duration);
+
+  ParallelFor(framesCount, [&](uint32_t frameIndex)
+  {
+    std::vector<glm::mat4x4> transforms(bonesCount);
+    // The last frame is at the end of the animation when the duration isn't a whole number of
+    // frames.
+    double const time = std::min(static_cast<double>(frameIndex) / framesPerSecond, duration);
+    CalculateBonesTransforms(groupIndex, animIndex, time, false /* cycled */, nullptr,
+                             transforms.data());
+    for (uint32_t i = 0; i < bonesCount; ++i)
+      bakedAnimation.SetBoneTransform(frameIndex, i, transforms[i]);
+  });
+  return true;
 }
 
-void BaseMesh::GetBonesTransforms(int groupIndex, size_t animIndex, double timeSinceStart, bool cycled,
-                                  std::vector<glm::mat4x4> & bonesTransforms)
+void BaseMesh::CalculateBonesTransforms(int groupIndex, size_t animIndex, double timeSinceStart,
+                                        bool cycled, AnimationCursor * cursor,
+                                        glm::mat4x4 * bonesTransforms,
+                                        uint32_t skippedLevels) const
+{
+  std::fill(bonesTransforms, bonesTransforms + GetBonesCount(), glm::mat4x4());
+
+  if (animIndex >= m_animations.size() || groupIndex < 0 ||
+      static_cast<size_t>(groupIndex) >= m_skins.size())
+    return;
+
+  auto const & animation = *m_animations[animIndex];
+  double const animTime = GetAnimationTime(animation, timeSinceStart, cycled);
+  if (cursor != nullptr)
+    cursor->Prepare(animIndex, animation.m_boneAnimations.size());
+
+  // Reused by the next evaluations on the same thread.
+  thread_local std::vector<glm::mat4x4> transforms;
+  if (transforms.size() < m_skeleton.size())
+    transforms.resize(m_skeleton.size());
+
+  for (size_t i = 0; i < m_skeleton.size(); ++i)
+  {
+    auto const & node = m_skeleton[i];
+    auto const channel = (node.m_boneIndex >= 0 && node.m_height >= skippedLevels) ?
+      animation.FindChannel(node.m_boneIndex) : -1;
+    glm::mat4x4 const localTransform = channel >= 0 ?
+      animation.CalculateBoneTransform(static_cast<size_t>(channel), animTime, cursor) :
+      node.m_transform;
+    transforms[i] = node.m_parent >= 0 ? transforms[node.m_parent] * localTransform
+                                       : localTransform;
+  }
+
+  for (auto const & bone : m_skins[groupIndex])
+    bonesTransforms[bone.m_boneIndex] = transforms[bone.m_skeletonIndex] * bone.m_offset;
+}
+
+void BaseMesh::InitializePose(AnimationPose & pose) const
 {
-  if (bonesTransforms.size() != kMaxBonesNumber)
-    bonesTransforms.resize(kMaxBonesNumber);
+  pose = m_bindPose;
+}
 
-  for (auto & bt : bonesTransforms)
-    bt = glm::mat4x4();
+void BaseMesh::SamplePose(size_t animIndex, double timeSinceStart, bool cycled,
+                          AnimationCursor * cursor, AnimationPose & pose) const
+{
+  if (pose.GetSize() != m_skeleton.size())
+    InitializePose(pose);
 
-  if (animIndex >= m_animations.size() || m_bonesRootNode == nullptr)
+  if (animIndex >= m_animations.size())
     return;
 
-  MeshGroup const & group = FindCachedMeshGroup(groupIndex);
-  if (group.m_groupIndex < 0)
+  auto const & animation = *m_animations[animIndex];
+  double const animTime = GetAnimationTime(animation, timeSinceStart, cycled);
+  if (cursor != nullptr)
+    cursor->Prepare(animIndex, animation.m_boneAnimations.size());
+
+  for (size_t i = 0; i < m_skeleton.size(); ++i)
+  {
+    auto const & node = m_skeleton[i];
+    auto const channel = node.m_boneIndex >= 0 ? animation.FindChannel(node.m_boneIndex) : -1;
+    if (channel >= 0)
+    {
+      animation.CalculateBoneTransform(static_cast<size_t>(channel), animTime, cursor,
+                                       pose.m_translations[i], pose.m_rotations[i],
+                                       pose.m_scales[i]);
+    }
+    else
+    {
+      pose.m_translations[i] = m_bindPose.m_translations[i];
+      pose.m_rotations[i] = m_bindPose.m_rotations[i];
+      pose.m_scales[i] = m_bindPose.m_scales[i];
+    }
+  }
+}
+
+void BaseMesh::GetBoneMask(std::string const & boneName, BoneMask & mask) const
+{
+  mask.assign(m_skeleton.size(), 0.0f);
+  auto const it = m_bonesIndices.find(boneName);
+  if (it == m_bonesIndices.end())
     return;
 
-  double const timeInTicks = m_animations[animIndex]->m_ticksPerSecond * timeSinceStart;
-  double const animTime = cycled ? std::fmod(timeInTicks, m_animations[animIndex]->m_durationInTicks)
-                                 : std::min(timeInTicks, m_animations[animIndex]->m_durationInTicks);
-  CalculateBonesTransform(animIndex, animTime, group, m_bonesRootNode, glm::mat4x4(), bonesTransforms);
+  // The descendants of a node follow it in the skeleton.
+  for (size_t i = 0; i < m_skeleton.size(); ++i)
+  {
+    auto const parent = m_skeleton[i].m_parent;
+    if (m_skeleton[i].m_boneIndex == static_cast<int32_t>(it->second) ||
+        (parent >= 0 && mask[parent] > 0.0f))
+    {
+      mask[i] = 1.0f;
+    }
+  }
 }
 
-bool BaseMesh::LoadMesh(std::string && filename, uint32_t desiredAttributesMask)
+void BaseMesh::GetBonesTransforms(int groupIndex, AnimationPose const & pose,
+                                  std::vector<glm::mat4x4> & bonesTransforms) const
+{
+  bonesTransforms.resize(GetBonesCount());
+  std::fill(bonesTransforms.begin(), bonesTransforms.end(), glm::mat4x4());
+  if (groupIndex < 0 || static_cast<size_t>(groupIndex) >= m_skins.size() ||
+      pose.GetSize() != m_skeleton.size())
+  {
+    return;
+  }
+
+  thread_local std::vector<glm::mat4x4> transforms;
+  if (transforms.size() < m_skeleton.size())
+    transforms.resize(m_skeleton.size());
+
+  for (size_t i = 0; i < m_skeleton.size(); ++i)
+  {
+    auto const localTransform = ComposeTransform(pose.m_translations[i], pose.m_rotations[i],
+                                                 pose.m_scales[i]);
+    auto const parent = m_skeleton[i].m_parent;
+    transforms[i] = parent >= 0 ? transforms[parent] * localTransform : localTransform;
+  }
+
+  for (auto const & bone : m_skins[groupIndex])
+    bonesTransforms[bone.m_boneIndex] = transforms[bone.m_skeletonIndex] * bone.m_offset;
+}
+
+void BaseMesh::BuildSkeleton()
+{
+  m_skeleton.clear();
+  m_skins.clear();
+  m_bindPose.Resize(0);
+  if (m_bonesRootNode == nullptr)
+    return;
+
+  // Depth-first order, so the parents precede their children.
+  std::vector<std::pair<MeshNode const *, int32_t>> stack = {{m_bonesRootNode.get(), -1}};
+  while (!stack.empty())
+  {
+    auto const [meshNode, parent] = stack.back();
+    stack.pop_back();
+
+    SkeletonNode node;
+    node.m_parent = parent;
+    node.m_transform = meshNode->m_transform;
+    auto const it = m_bonesIndices.find(meshNode->m_name);
+    if (it != m_bonesIndices.end())
+      node.m_boneIndex = static_cast<int32_t>(it->second);
+    m_skeleton.push_back(node);
+
+    auto const index = static_cast<int32_t>(m_skeleton.size() - 1);
+    for (auto c = meshNode->m_children.rbegin(); c != meshNode->m_children.rend(); ++c)
+      stack.emplace_back(c->get(), index);
+  }
+
+  // The children follow their parents, so the heights are accumulated in the reverse order.
+  for (size_t i = m_skeleton.size(); i-- > 1;)
+  {
+    auto & parent = m_skeleton[m_skeleton[i].m_parent];
+    parent.m_height = std::max(parent.m_height, m_skeleton[i].m_height + 1);
+  }
+
+  m_bindPose.Resize(m_skeleton.size());
+  for (size_t i = 0; i < m_skeleton.size(); ++i)
+  {
+    DecomposeTransform(m_skeleton[i].m_transform, m_bindPose.m_translations[i],
+                       m_bindPose.m_rotations[i], m_bindPose.m_scales[i]);
+  }
+
+  m_skins.resize(static_cast<size_t>(std::max(m_groupsCount, 0)));
+  for (int groupIndex = 0; groupIndex < m_groupsCount; ++groupIndex)
+  {
+    MeshGroup const & group = FindCachedMeshGroup(groupIndex);
+    if (group.m_groupIndex < 0 || group.m_boneOffsets.empty())
+      continue;
+
+    for (size_t i = 0; i < m_skeleton.size(); ++i)
+    {
+      if (m_skeleton[i].m_boneIndex < 0)
+        continue;
+
+      auto const boneIndex = static_cast<uint32_t>(m_skeleton[i].m_boneIndex);
+      auto const it = group.m_boneOffsets.find(boneIndex);
+      if (it != group.m_boneOffsets.end())
+        m_skins[groupIndex].push_back({static_cast<uint32_t>(i), boneIndex, it->second});
+    }
+  }
+}
+
+bool BaseMesh::LoadMesh(std::string && filename, uint32_t desiredAttributesMask,
+                        KeyframeReduction const & keyframeReduction)
 {
   // Workaround for some CMake generated projects.
   if (!Utils::IsPathExisted(filename))
@@ -600,9 +815,10 @@ bool BaseMesh::LoadMesh(std::string && filename, uint32_t desiredAttributesMask)
   MeshLogGuard logGuard(filename);
 
   Importer importer;
-  unsigned int postProcessFlags = aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace |
-                                  aiProcess_JoinIdenticalVertices | aiProcess_Triangulate |
-                                  aiProcess_ValidateDataStructure | aiProcess_SortByPType;
+  // Tangents are calculated natively (see CalculateTangents), Assimp's pass is single-threaded.
+  unsigned int postProcessFlags = aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices |
+                                  aiProcess_Triangulate | aiProcess_ValidateDataStructure |
+                                  aiProcess_SortByPType;
   aiScene const * scene = importer.ReadFile(filename, postProcessFlags);
 
   if (scene == nullptr)
@@ -716,22 +932,27 @@ bool BaseMesh::LoadMesh(std::string && filename, uint32_t desiredAttributesMask)
           boneAnim.m_scaleKeys.emplace_back(animNode->mScalingKeys[i].mTime,
                                             GetVector3(animNode->mScalingKeys[i].mValue));
 
+        ReduceKeys(boneAnim, keyframeReduction);
         anim->m_boneAnimations.push_back(std::move(boneAnim));
       }
 
       if (!failed)
+      {
+        anim->BuildChannelsTable(m_bonesIndices.size());
         m_animations.push_back(std::move(anim));
+      }
     }
   }
+  BuildSkeleton();
 
   return true;
 }
 
-bool BaseMesh::GenerateSphere(float radius, uint32_t attributesMask)
+bool BaseMesh::GenerateSphere(float radius, uint32_t attributesMask, uint32_t tesselationLevel)
 {
   MeshGenerator generator;
   BaseMesh::MeshGroup meshGroup;
-  if (!generator.GenerateSphere(radius, attributesMask, meshGroup))
+  if (!generator.GenerateSphere(radius, attributesMask, meshGroup, tesselationLevel))
     return false;
 
   m_rootNode = std::make_unique<MeshNode>();
@@ -765,10 +986,11 @@ bool BaseMesh::GeneratePlane(float width, float height, uint32_t widthSegments,
   return true;
 }
 
-bool BaseMesh::GenerateTerrain(std::vector<uint8_t> const & heightmap,
-                               uint32_t heightmapWidth, uint32_t heightmapHeight,
-                               float minAltitude, float maxAltitude, float width, float height,
-                               uint32_t attributesMask)
+template <typename T>
+bool BaseMesh::GenerateTerrainImpl(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                                   uint32_t heightmapHeight, float minAltitude,
+                                   float maxAltitude, float width, float height,
+                                   uint32_t attributesMask)
 {
   MeshGenerator generator;
   BaseMesh::MeshGroup meshGroup;
@@ -788,6 +1010,24 @@ bool BaseMesh::GenerateTerrain(std::vector<uint8_t> const & heightmap,
   return true;
 }
 
+bool BaseMesh::GenerateTerrain(std::vector<uint8_t> const & heightmap,
+                               uint32_t heightmapWidth, uint32_t heightmapHeight,
+                               float minAltitude, float maxAltitude, float width, float height,
+                               uint32_t attributesMask)
+{
+  return GenerateTerrainImpl(heightmap, heightmapWidth, heightmapHeight, minAltitude,
+                             maxAltitude, width, height, attributesMask);
+}
+
+bool BaseMesh::GenerateTerrain(std::vector<uint16_t> const & heightmap,
+                               uint32_t heightmapWidth, uint32_t heightmapHeight,
+                               float minAltitude, float maxAltitude, float width, float height,
+                               uint32_t attributesMask)
+{
+  return GenerateTerrainImpl(heightmap, heightmapWidth, heightmapHeight, minAltitude,
+                             maxAltitude, width, height, attributesMask);
+}
+
 bool BaseMesh::GenerateTerrain(std::vector<glm::vec3> const & positions,
                                std::vector<glm::vec2> const & borders,
                                uint32_t attributesMask)
@@ -807,6 +1047,118 @@ bool BaseMesh::GenerateTerrain(std::vector<glm::vec3> const & positions,
   return true;
 }
 
+template <typename T>
+bool BaseMesh::GenerateAdaptiveTerrainImpl(std::vector<T> const & heightmap,
+                                           uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                           float minAltitude, float maxAltitude, float width,
+                                           float height, float maxError, uint32_t attributesMask)
+{
+  MeshGenerator generator;
+  BaseMesh::MeshGroup meshGroup;
+  if (!generator.GenerateAdaptiveTerrain(heightmap, heightmapWidth, heightmapHeight,
+                                         attributesMask, minAltitude, maxAltitude, width, height,
+                                         maxError, meshGroup))
+  {
+    return false;
+  }
+
+  m_rootNode = std::make_unique<MeshNode>();
+  m_attributesMask = attributesMask;
+  m_verticesCount = meshGroup.m_verticesCount;
+  m_indicesCount = meshGroup.m_indicesCount;
+  m_groupsCount = 1;
+  m_rootNode->m_groups.push_back(std::move(meshGroup));
+
+  return true;
+}
+
+bool BaseMesh::GenerateAdaptiveTerrain(std::vector<uint8_t> const & heightmap,
+                                       uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                       float minAltitude, float maxAltitude, float width,
+                                       float height, float maxError, uint32_t attributesMask)
+{
+  return GenerateAdaptiveTerrainImpl(heightmap, heightmapWidth, heightmapHeight, minAltitude,
+                                     maxAltitude, width, height, maxError, attributesMask);
+}
+
+bool BaseMesh::GenerateAdaptiveTerrain(std::vector<uint16_t> const & heightmap,
+                                       uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                       float minAltitude, float maxAltitude, float width,
+                                       float height, float maxError, uint32_t attributesMask)
+{
+  return GenerateAdaptiveTerrainImpl(heightmap, heightmapWidth, heightmapHeight, minAltitude,
+                                     maxAltitude, width, height, maxError, attributesMask);
+}
+
+bool BaseMesh::GenerateTiledTerrain(std::vector<glm::vec3> const & positions, float tileSize,
+                                    float maxError, uint32_t attributesMask)
+{
+  MeshGenerator generator;
+  std::vector<MeshGroup> meshGroups;
+  if (!generator.GenerateTiledTerrain(positions, tileSize, maxError, attributesMask, meshGroups))
+    return false;
+
+  m_rootNode = std::make_unique<MeshNode>();
+  m_attributesMask = attributesMask;
+  m_verticesCount = 0;
+  m_indicesCount = 0;
+  for (auto const & g : meshGroups)
+  {
+    m_verticesCount += g.m_verticesCount;
+    m_indicesCount += g.m_indicesCount;
+  }
+  m_groupsCount = static_cast<int>(meshGroups.size());
+  m_rootNode->m_groups = std::move(meshGroups);
+
+  return true;
+}
+
+template <typename T>
+bool BaseMesh::GenerateChunkedTerrainImpl(std::vector<T> const & heightmap,
+                                          uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                          TerrainSettings const & settings,
+                                          TerrainQuadtree & quadtree, uint32_t attributesMask)
+{
+  std::vector<MeshGroup> meshGroups;
+  if (!quadtree.Build(heightmap, heightmapWidth, heightmapHeight, settings, attributesMask,
+                      meshGroups))
+  {
+    return false;
+  }
+
+  m_rootNode = std::make_unique<MeshNode>();
+  m_attributesMask = attributesMask;
+  m_verticesCount = 0;
+  m_indicesCount = 0;
+  for (auto const & g : meshGroups)
+  {
+    m_verticesCount += g.m_verticesCount;
+    m_indicesCount += g.m_indicesCount;
+  }
+  m_groupsCount = static_cast<int>(meshGroups.size());
+  m_rootNode->m_groups = std::move(meshGroups);
+
+  return true;
+}
+
+bool BaseMesh::GenerateChunkedTerrain(std::vector<uint8_t> const & heightmap,
+                                      uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                      TerrainSettings const & settings,
+                                      TerrainQuadtree & quadtree, uint32_t attributesMask)
+{
+  return GenerateChunkedTerrainImpl(heightmap, heightmapWidth, heightmapHeight, settings,
+                                    quadtree, attributesMask);
+}
+
+bool BaseMesh::GenerateChunkedTerrain(std::vector<uint16_t> const & heightmap,
+                                      uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                      TerrainSettings const & settings,
+                                      TerrainQuadtree & quadtree, uint32_t attributesMask)
+{
+  return GenerateChunkedTerrainImpl(heightmap, heightmapWidth, heightmapHeight, settings,
+                                    quadtree, attributesMask);
+}
+
 void BaseMesh::DestroyMesh()
 {
   m_groupsCache.clear();
@@ -815,6 +1167,9 @@ void BaseMesh::DestroyMesh()
   m_bonesIndices.clear();
   m_rootNode.reset();
   m_bonesRootNode.reset();
+  m_skeleton.clear();
+  m_bindPose.Resize(0);
+  m_skins.clear();
 
   m_verticesCount = 0;
   m_indicesCount = 0;
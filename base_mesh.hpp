@@ -1,5 +1,6 @@
 #pragma once
 
+#include "animation.hpp"
 #include "common.hpp"
 
 namespace rf
@@ -55,32 +56,16 @@ MeshVertexAttribute const kAllAttributes[] = {Position, Normal,  UV0,   UV1,
                                               UV3,      Tangent, Color, BoneIndices, BoneWeights};
 uint32_t constexpr kAttributesCount = sizeof(kAllAttributes) / sizeof(kAllAttributes[0]);
 
-uint32_t constexpr kMaxBonesNumber = 64;
 uint32_t constexpr kMaxBonesPerVertex = 4;
 
 using IndexBuffer32 = std::vector<uint32_t>;
 using VertexBufferCollection = std::unordered_map<MeshVertexAttribute, ByteArray>;
 
-struct BoneAnimation
-{
-  uint32_t m_boneIndex = 0;
-  std::vector<std::pair<double, glm::vec3>> m_translationKeys;
-  std::vector<std::pair<double, glm::vec3>> m_scaleKeys;
-  std::vector<std::pair<double, glm::quat>> m_rotationKeys;
-};
-
-struct MeshAnimation
-{
-  std::string m_name;
-  double m_durationInTicks = 0.0;
-  double m_ticksPerSecond = 0.0;
-  std::vector<BoneAnimation> m_boneAnimations;
-};
-
-using MeshAnimations = std::vector<std::unique_ptr<MeshAnimation>>;
-
 using BoneIndicesCollection = std::unordered_map<std::string, uint32_t>;
 
+struct TerrainSettings;
+class TerrainQuadtree;
+
 class BaseMesh
 {
 public:
@@ -93,8 +78,55 @@ public:
   std::shared_ptr<MeshMaterial> GetGroupMaterial(int index) const;
   AABB GetBoundingBox() const;
   size_t GetAnimationsCount() const;
+  // Size of the bones transforms, the indices of the BoneIndices attribute are less than it.
+  uint32_t GetBonesCount() const { return static_cast<uint32_t>(m_bonesIndices.size()); }
+  MeshAnimation const & GetAnimation(size_t index) const { return *m_animations[index]; }
+  // Replaces the keys of all the animations by the compressed ones.
+  void CompressAnimations();
   void GetBonesTransforms(int groupIndex, size_t animIndex, double timeSinceStart, bool cycled,
                           std::vector<glm::mat4x4> & bonesTransforms);
+  // The cursor belongs to one playback instance and speeds up the search of the keys.
+  void GetBonesTransforms(int groupIndex, size_t animIndex, double timeSinceStart, bool cycled,
+                          std::vector<glm::mat4x4> & bonesTransforms, AnimationCursor & cursor);
+
+  struct BonesTransformsRequest
+  {
+    BaseMesh * m_mesh = nullptr;
+    int m_groupIndex = 0;
+    size_t m_animIndex = 0;
+    double m_timeSinceStart = 0.0;
+    bool m_cycled = true;
+    // Optional, a cursor must not be shared between the requests.
+    AnimationCursor * m_cursor = nullptr;
+    // Skeleton LOD, the nodes which are less than m_skippedLevels levels above the leaves keep
+    // the bind pose and their keys are not evaluated.
+    uint32_t m_skippedLevels = 0;
+  };
+  // Evaluates the requests in parallel into one buffer, transforms of the i-th request are in
+  // [offsets[i], offsets[i + 1]).
+  static void GetBonesTransforms(std::vector<BonesTransformsRequest> const & requests,
+                                 std::vector<glm::mat4x4> & bonesTransforms,
+                                 std::vector<uint32_t> & offsets);
+  // The same packed to the GPU layout, the i-th request takes GetBoneSize(format) floats per bone
+  // from offsets[i] * GetBoneSize(format).
+  static void GetBonesTransforms(std::vector<BonesTransformsRequest> const & requests,
+                                 BonesFormat format, std::vector<float> & bonesData,
+                                 std::vector<uint32_t> & offsets);
+
+  // Poses are indexed by the skeleton nodes. InitializePose allocates the pose and sets it to
+  // the bind one, the other functions don't allocate.
+  void InitializePose(AnimationPose & pose) const;
+  void SamplePose(size_t animIndex, double timeSinceStart, bool cycled, AnimationCursor * cursor,
+                  AnimationPose & pose) const;
+  // Mask which is 1 for the bone and its descendants and 0 for the other nodes.
+  void GetBoneMask(std::string const & boneName, BoneMask & mask) const;
+  void GetBonesTransforms(int groupIndex, AnimationPose const & pose,
+                          std::vector<glm::mat4x4> & bonesTransforms) const;
+
+  // Samples the skinning transforms of the group at the fixed rate, the playback of the baked
+  // animation doesn't evaluate the keys.
+  bool BakeAnimation(int groupIndex, size_t animIndex, float framesPerSecond,
+                     BakedAnimation::Format format, BakedAnimation & bakedAnimation) const;
   uint32_t GetAttributesMask() const { return m_attributesMask; }
   uint32_t GetTrianglesCount() const { return m_indicesCount / 3; }
 
@@ -119,9 +151,15 @@ public:
     std::vector<std::unique_ptr<MeshNode>> m_children;
   };
 
+  // Vertices and indices of the group on the CPU side, e.g. for SkinMeshGroup. The buffers are
+  // empty if the mesh doesn't keep them.
+  MeshGroup const & GetGroup(int index) const { return FindCachedMeshGroup(index); }
+
 protected:
-  bool LoadMesh(std::string && filename, uint32_t desiredAttributesMask);
-  bool GenerateSphere(float radius, uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  bool LoadMesh(std::string && filename, uint32_t desiredAttributesMask,
+                KeyframeReduction const & keyframeReduction = {});
+  bool GenerateSphere(float radius, uint32_t attributesMask = Position | Normal | UV0 | Tangent,
+                      uint32_t tesselationLevel = 4);
   bool GeneratePlane(float width, float height, uint32_t widthSegments = 1,
                      uint32_t heightSegments = 1, uint32_t uSegments = 1, uint32_t vSegments = 1,
                      uint32_t attributesMask = Position | Normal | UV0 | Tangent);
@@ -129,15 +167,43 @@ protected:
                        uint32_t heightmapWidth, uint32_t heightmapHeight,
                        float minAltitude, float maxAltitude, float width, float height,
                        uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  bool GenerateTerrain(std::vector<uint16_t> const & heightmap,
+                       uint32_t heightmapWidth, uint32_t heightmapHeight,
+                       float minAltitude, float maxAltitude, float width, float height,
+                       uint32_t attributesMask = Position | Normal | UV0 | Tangent);
   bool GenerateTerrain(std::vector<glm::vec3> const & positions, std::vector<glm::vec2> const & borders,
                        uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  bool GenerateAdaptiveTerrain(std::vector<uint8_t> const & heightmap,
+                               uint32_t heightmapWidth, uint32_t heightmapHeight,
+                               float minAltitude, float maxAltitude, float width, float height,
+                               float maxError,
+                               uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  bool GenerateAdaptiveTerrain(std::vector<uint16_t> const & heightmap,
+                               uint32_t heightmapWidth, uint32_t heightmapHeight,
+                               float minAltitude, float maxAltitude, float width, float height,
+                               float maxError,
+                               uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  bool GenerateTiledTerrain(std::vector<glm::vec3> const & positions, float tileSize,
+                            float maxError,
+                            uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  bool GenerateChunkedTerrain(std::vector<uint8_t> const & heightmap,
+                              uint32_t heightmapWidth, uint32_t heightmapHeight,
+                              TerrainSettings const & settings, TerrainQuadtree & quadtree,
+                              uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  bool GenerateChunkedTerrain(std::vector<uint16_t> const & heightmap,
+                              uint32_t heightmapWidth, uint32_t heightmapHeight,
+                              TerrainSettings const & settings, TerrainQuadtree & quadtree,
+                              uint32_t attributesMask = Position | Normal | UV0 | Tangent);
   void DestroyMesh();
 
-  glm::mat4x4 FindBoneAnimation(uint32_t boneIndex, size_t animIndex, double animTime, bool & found);
-  void CalculateBonesTransform(size_t animIndex, double animTime, const BaseMesh::MeshGroup & group,
-                               std::unique_ptr<BaseMesh::MeshNode> const & meshNode,
-                               glm::mat4x4 const & parentTransform,
-                               std::vector<glm::mat4x4> & bonesTransforms);
+  // Flattens the bones hierarchy and the bone offsets of the groups, must be called when the
+  // bones and the groups are loaded.
+  void BuildSkeleton();
+  // Writes GetBonesCount() transforms.
+  void CalculateBonesTransforms(int groupIndex, size_t animIndex, double timeSinceStart,
+                                bool cycled, AnimationCursor * cursor,
+                                glm::mat4x4 * bonesTransforms,
+                                uint32_t skippedLevels = 0) const;
 
   void FillGpuBuffers(std::unique_ptr<BaseMesh::MeshNode> const & meshNode,
                       uint8_t * vbPtr, uint32_t * ibPtr,
@@ -148,6 +214,21 @@ protected:
                                   int index) const;
   MeshGroup const & FindCachedMeshGroup(int index) const;
 
+  // Heightmap terrains with 8-bit and 16-bit samples.
+  template <typename T>
+  bool GenerateTerrainImpl(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                           uint32_t heightmapHeight, float minAltitude, float maxAltitude,
+                           float width, float height, uint32_t attributesMask);
+  template <typename T>
+  bool GenerateAdaptiveTerrainImpl(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                                   uint32_t heightmapHeight, float minAltitude, float maxAltitude,
+                                   float width, float height, float maxError,
+                                   uint32_t attributesMask);
+  template <typename T>
+  bool GenerateChunkedTerrainImpl(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                                  uint32_t heightmapHeight, TerrainSettings const & settings,
+                                  TerrainQuadtree & quadtree, uint32_t attributesMask);
+
   uint32_t m_verticesCount = 0;
   uint32_t m_indicesCount = 0;
   uint32_t m_attributesMask = 0;
@@ -159,6 +240,28 @@ protected:
   
   std::unique_ptr<MeshNode> m_rootNode;
   std::unique_ptr<MeshNode> m_bonesRootNode;
+
+  // Nodes of the bones hierarchy, parents precede their children.
+  struct SkeletonNode
+  {
+    int32_t m_parent = -1;
+    // -1 for the nodes which are not bones.
+    int32_t m_boneIndex = -1;
+    // Number of levels below the node, 0 for the leaves.
+    uint32_t m_height = 0;
+    glm::mat4x4 m_transform;
+  };
+  std::vector<SkeletonNode> m_skeleton;
+  AnimationPose m_bindPose;
+
+  struct SkinBone
+  {
+    uint32_t m_skeletonIndex = 0;
+    uint32_t m_boneIndex = 0;
+    glm::mat4x4 m_offset;
+  };
+  // Bones with the offsets per group index.
+  std::vector<std::vector<SkinBone>> m_skins;
   
   mutable std::vector<MeshGroup const *> m_groupsCache;
 };
@@ -43,7 +43,7 @@ int GetChannelsCount(TextureFormat format)
 }
 }  // namespace
 
-uint8_t const * BaseTexture::Load(std::string && fileName)
+bool BaseTexture::ResolvePath(std::string & fileName) const
 {
   // Workaround for some CMake generated projects.
   if (!Utils::IsPathExisted(fileName))
@@ -52,9 +52,16 @@ uint8_t const * BaseTexture::Load(std::string && fileName)
     if (!Utils::IsPathExisted(fileName))
     {
       Logger::ToLogWithFormat(Logger::Error, "File '%s' is not found.", fileName.c_str());
-      return nullptr;
+      return false;
     }
   }
+  return true;
+}
+
+uint8_t const * BaseTexture::Load(std::string && fileName)
+{
+  if (!ResolvePath(fileName))
+    return nullptr;
 
   stbi_set_flip_vertically_on_load(true);
 
@@ -161,6 +168,40 @@ std::vector<uint8_t> BaseTexture::LoadHeightmap(std::string && fileName)
   return buffer;
 }
 
+std::vector<uint16_t> BaseTexture::LoadHeightmap16(std::string && fileName)
+{
+  if (!ResolvePath(fileName))
+    return {};
+
+  if (!stbi_is_16_bit(fileName.c_str()))
+  {
+    auto const heightmap = LoadHeightmap(std::move(fileName));
+    std::vector<uint16_t> buffer(heightmap.size());
+    for (size_t i = 0; i < buffer.size(); ++i)
+      buffer[i] = static_cast<uint16_t>(heightmap[i] * 257);
+    return buffer;
+  }
+
+  stbi_set_flip_vertically_on_load(true);
+
+  int w, h, components;
+  auto imageData = stbi_load_16(fileName.c_str(), &w, &h, &components, 1);
+  if (imageData == nullptr)
+  {
+    Logger::ToLogWithFormat(Logger::Error, "Could not load the file '%s'.", fileName.c_str());
+    return {};
+  }
+
+  m_format = TextureFormat::Unspecified;
+  m_type = TextureType::Heightmap;
+  m_width = static_cast<uint32_t>(w);
+  m_height = static_cast<uint32_t>(h);
+
+  std::vector<uint16_t> buffer(imageData, imageData + static_cast<size_t>(m_width) * m_height);
+  stbi_image_free(imageData);
+  return buffer;
+}
+
 void BaseTexture::FreeLoadedData(uint8_t const * imageData)
 {
   CHECK(imageData != nullptr, "");
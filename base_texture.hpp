@@ -47,12 +47,15 @@ public:
   std::string GetId() const { return m_id; }
 
   std::vector<uint8_t> LoadHeightmap(std::string && fileName);
+  // 16-bit images keep the full precision, 8-bit images are expanded to 16 bits.
+  std::vector<uint16_t> LoadHeightmap16(std::string && fileName);
 
   static void SaveToPng(std::string && filename, uint32_t width, uint32_t height,
                         TextureFormat format, uint8_t const * data);
 
 protected:
   uint8_t const * Load(std::string && fileName);
+  bool ResolvePath(std::string & fileName) const;
 
   std::vector<uint8_t const *> LoadCubemap(std::string && rightFileName,
                                            std::string && leftFileName,
@@ -18,10 +18,42 @@ void Camera::UpdateView()
 {
   glm::vec3 dir = m_orientation * glm::vec3(0.0f, 0.0f, 1.0f);
   m_view = glm::lookAt(m_position, m_position + dir, glm::vec3(0.0f, 1.0f, 0.0f));
+  UpdateFrustum();
 }
 
 void Camera::UpdateProjection()
 {
   m_projection = glm::perspective(m_fov, m_aspect, m_znear, m_zfar);
+  UpdateFrustum();
+}
+
+void Camera::UpdateFrustum()
+{
+  // Gribb-Hartmann: planes are combinations of the rows of the view-projection matrix.
+  glm::mat4x4 const m = m_projection * m_view;
+  auto row = [&m](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+  m_frustumPlanes[0] = row(3) + row(0);
+  m_frustumPlanes[1] = row(3) - row(0);
+  m_frustumPlanes[2] = row(3) + row(1);
+  m_frustumPlanes[3] = row(3) - row(1);
+  m_frustumPlanes[4] = row(3) + row(2);
+  m_frustumPlanes[5] = row(3) - row(2);
+  for (auto & p : m_frustumPlanes)
+    p /= glm::length(glm::vec3(p));
+}
+
+bool Camera::IsBoxInFrustum(AABB const & box) const
+{
+  auto const minPt = box.getMin();
+  auto const maxPt = box.getMax();
+  for (auto const & p : m_frustumPlanes)
+  {
+    // The box corner farthest along the plane normal.
+    glm::vec3 const v(p.x >= 0.0f ? maxPt.x : minPt.x, p.y >= 0.0f ? maxPt.y : minPt.y,
+                      p.z >= 0.0f ? maxPt.z : minPt.z);
+    if (glm::dot(glm::vec3(p), v) + p.w < 0.0f)
+      return false;
+  }
+  return true;
 }
 }  // namespace rf
\ No newline at end of file
@@ -56,9 +56,18 @@ public:
     UpdateProjection();
   }
 
+  // Planes are in world space, normals point inside the frustum.
+  std::array<glm::vec4, 6> const & GetFrustumPlanes() const
+  {
+    return m_frustumPlanes;
+  }
+
+  bool IsBoxInFrustum(AABB const & box) const;
+
 protected:
 	void UpdateView();
 	void UpdateProjection();
+  void UpdateFrustum();
 
 	float m_fov = 60.0f * kPi / 180.0f;
 	float m_znear = 0.1f;
@@ -70,5 +79,6 @@ protected:
 
   glm::mat4x4 m_view;
   glm::mat4x4 m_projection;
+  std::array<glm::vec4, 6> m_frustumPlanes;
 };
 }  // namespace rf
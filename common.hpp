@@ -14,6 +14,7 @@
 #include <functional>
 #include <iostream>
 #include <initializer_list>
+#include <limits>
 #include <list>
 #include <locale>
 #include <map>
@@ -23,6 +24,7 @@
 #include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #if defined(WIN32) || defined(__WIN32__) || defined(_WIN32) || defined(_MSC_VER)
@@ -34,6 +36,11 @@
 #pragma warning(disable : 4996)
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RF_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 #ifdef API_OPENGL
 #ifdef WINDOWS_PLATFORM
 #include "gl3w.h"
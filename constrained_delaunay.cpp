@@ -0,0 +1,419 @@
+#include "constrained_delaunay.hpp"
+
+#include "logger.hpp"
+
+#include "3party/delaunator-cpp/include/delaunator.hpp"
+
+#include <deque>
+
+namespace rf
+{
+namespace
+{
+uint64_t GetEdgeKey(uint32_t v1, uint32_t v2)
+{
+  return (static_cast<uint64_t>(std::min(v1, v2)) << 32) | std::max(v1, v2);
+}
+
+int Sign(double v)
+{
+  return (v > 0.0) - (v < 0.0);
+}
+}  // namespace
+
+ConstrainedDelaunay::ConstrainedDelaunay(std::vector<double> coords)
+  : m_coords(std::move(coords))
+{
+  delaunator::Delaunator d(m_coords);
+  m_triangles.resize(d.triangles.size());
+  m_halfedges.resize(d.halfedges.size());
+  for (size_t i = 0; i < d.triangles.size(); ++i)
+  {
+    m_triangles[i] = static_cast<uint32_t>(d.triangles[i]);
+    m_halfedges[i] = d.halfedges[i] == delaunator::INVALID_INDEX
+                     ? kInvalidIndex : static_cast<uint32_t>(d.halfedges[i]);
+  }
+
+  m_vertexHalfedges.resize(m_coords.size() / 2, kInvalidIndex);
+  for (uint32_t e = 0; e < static_cast<uint32_t>(m_triangles.size()); ++e)
+    m_vertexHalfedges[m_triangles[e]] = e;
+}
+
+double ConstrainedDelaunay::Orient(uint32_t a, uint32_t b, uint32_t c) const
+{
+  auto const ax = m_coords[2 * a];
+  auto const ay = m_coords[2 * a + 1];
+  return (m_coords[2 * b] - ax) * (m_coords[2 * c + 1] - ay) -
+         (m_coords[2 * b + 1] - ay) * (m_coords[2 * c] - ax);
+}
+
+bool ConstrainedDelaunay::IsInCircle(uint32_t a, uint32_t b, uint32_t c, uint32_t p) const
+{
+  auto const px = m_coords[2 * p];
+  auto const py = m_coords[2 * p + 1];
+  auto const ax = m_coords[2 * a] - px;
+  auto const ay = m_coords[2 * a + 1] - py;
+  auto const bx = m_coords[2 * b] - px;
+  auto const by = m_coords[2 * b + 1] - py;
+  auto const cx = m_coords[2 * c] - px;
+  auto const cy = m_coords[2 * c + 1] - py;
+  auto const det = (ax * ax + ay * ay) * (bx * cy - cx * by) -
+                   (bx * bx + by * by) * (ax * cy - cx * ay) +
+                   (cx * cx + cy * cy) * (ax * by - bx * ay);
+
+  // The sign of the determinant depends on the orientation of the triangle.
+  return Orient(a, b, c) > 0.0 ? det > 0.0 : det < 0.0;
+}
+
+bool ConstrainedDelaunay::IsOnSegment(uint32_t a, uint32_t b, uint32_t p) const
+{
+  if (p == a || p == b)
+    return false;
+
+  auto const dx = m_coords[2 * b] - m_coords[2 * a];
+  auto const dy = m_coords[2 * b + 1] - m_coords[2 * a + 1];
+  auto const px = m_coords[2 * p] - m_coords[2 * a];
+  auto const py = m_coords[2 * p + 1] - m_coords[2 * a + 1];
+  auto const len2 = dx * dx + dy * dy;
+  auto const t = dx * px + dy * py;
+  return fabs(Orient(a, b, p)) <= 1e-12 * len2 && t > 0.0 && t < len2;
+}
+
+uint32_t ConstrainedDelaunay::GetFirstOutgoingHalfedge(uint32_t v) const
+{
+  // Rotate clockwise to the hull edge (if any), so the fan can be walked in one direction.
+  auto const start = m_vertexHalfedges[v];
+  if (start == kInvalidIndex)
+    return kInvalidIndex;
+
+  auto e = start;
+  while (m_halfedges[e] != kInvalidIndex)
+  {
+    e = Next(m_halfedges[e]);
+    if (e == start)
+      break;
+  }
+  return e;
+}
+
+void ConstrainedDelaunay::ForEachNeighbour(uint32_t v,
+                                           std::function<void(uint32_t)> const & func) const
+{
+  auto const start = GetFirstOutgoingHalfedge(v);
+  if (start == kInvalidIndex)
+    return;
+
+  auto e = start;
+  do
+  {
+    func(m_triangles[Next(e)]);
+    auto const twin = m_halfedges[Prev(e)];
+    if (twin == kInvalidIndex)
+    {
+      func(m_triangles[Prev(e)]);
+      break;
+    }
+    e = twin;
+  }
+  while (e != start);
+}
+
+uint32_t ConstrainedDelaunay::FindHalfedge(uint32_t v1, uint32_t v2) const
+{
+  auto const start = GetFirstOutgoingHalfedge(v1);
+  if (start == kInvalidIndex)
+    return kInvalidIndex;
+
+  auto e = start;
+  do
+  {
+    if (m_triangles[Next(e)] == v2)
+      return e;
+    e = m_halfedges[Prev(e)];
+  }
+  while (e != kInvalidIndex && e != start);
+  return kInvalidIndex;
+}
+
+bool ConstrainedDelaunay::IsConstrained(uint32_t v1, uint32_t v2) const
+{
+  return m_constraints.find(GetEdgeKey(v1, v2)) != m_constraints.end();
+}
+
+void ConstrainedDelaunay::Link(uint32_t a, uint32_t b)
+{
+  m_halfedges[a] = b;
+  if (b != kInvalidIndex)
+    m_halfedges[b] = a;
+}
+
+uint32_t ConstrainedDelaunay::Flip(uint32_t a)
+{
+  // The same flip as in delaunator legalization, it keeps the orientation of triangles.
+  auto const b = m_halfedges[a];
+  auto const a0 = a - a % 3;
+  auto const b0 = b - b % 3;
+  auto const al = a0 + (a + 1) % 3;
+  auto const ar = a0 + (a + 2) % 3;
+  auto const bl = b0 + (b + 2) % 3;
+  auto const br = b0 + (b + 1) % 3;
+
+  auto const p0 = m_triangles[ar];
+  auto const pr = m_triangles[a];
+  auto const pl = m_triangles[al];
+  auto const p1 = m_triangles[bl];
+
+  m_triangles[a] = p1;
+  m_triangles[b] = p0;
+
+  auto const hbl = m_halfedges[bl];
+  auto const har = m_halfedges[ar];
+  Link(a, hbl);
+  Link(b, har);
+  Link(ar, bl);
+
+  m_vertexHalfedges[p1] = a;
+  m_vertexHalfedges[pl] = al;
+  m_vertexHalfedges[p0] = ar;
+  m_vertexHalfedges[pr] = br;
+  return ar;
+}
+
+bool ConstrainedDelaunay::InsertConstraint(uint32_t v1, uint32_t v2)
+{
+  auto const verticesCount = static_cast<uint32_t>(m_vertexHalfedges.size());
+  if (v1 >= verticesCount || v2 >= verticesCount ||
+      m_vertexHalfedges[v1] == kInvalidIndex || m_vertexHalfedges[v2] == kInvalidIndex)
+  {
+    Logger::ToLog(Logger::Error, "Can't insert constraint, vertex is not triangulated.");
+    return false;
+  }
+
+  // Vertices on the segment split it into several constraints.
+  for (auto v = v1; v != v2; v = InsertSegment(v, v2))
+  {
+    if (v == kInvalidIndex)
+      return false;
+  }
+  return true;
+}
+
+uint32_t ConstrainedDelaunay::InsertSegment(uint32_t a, uint32_t b)
+{
+  if (FindHalfedge(a, b) != kInvalidIndex || FindHalfedge(b, a) != kInvalidIndex)
+  {
+    m_constraints.insert(GetEdgeKey(a, b));
+    return b;
+  }
+
+  // Find the triangle around a, through which the segment leaves a.
+  auto const start = GetFirstOutgoingHalfedge(a);
+  uint32_t crossed = kInvalidIndex;
+  auto e = start;
+  do
+  {
+    auto const u = m_triangles[Next(e)];
+    auto const w = m_triangles[Prev(e)];
+    for (auto const v : {u, w})
+    {
+      if (IsOnSegment(a, b, v))
+      {
+        m_constraints.insert(GetEdgeKey(a, v));
+        return v;
+      }
+    }
+
+    auto const su = Sign(Orient(a, b, u));
+    auto const sw = Sign(Orient(a, b, w));
+    if (su * sw < 0 && Sign(Orient(a, u, b)) == Sign(Orient(a, u, w)) &&
+        Sign(Orient(a, w, b)) == Sign(Orient(a, w, u)))
+    {
+      crossed = Next(e);
+      break;
+    }
+    e = m_halfedges[Prev(e)];
+  }
+  while (e != kInvalidIndex && e != start);
+
+  if (crossed == kInvalidIndex)
+  {
+    Logger::ToLog(Logger::Error, "Can't insert constraint, segment direction is not found.");
+    return kInvalidIndex;
+  }
+
+  // Walk along the segment collecting the crossed edges. If a vertex lies on the segment, the
+  // segment is split there.
+  std::deque<std::pair<uint32_t, uint32_t>> crossedEdges;
+  uint32_t end = b;
+  while (true)
+  {
+    crossedEdges.emplace_back(m_triangles[crossed], m_triangles[Next(crossed)]);
+    auto const t = m_halfedges[crossed];
+    if (t == kInvalidIndex)
+    {
+      Logger::ToLog(Logger::Error, "Can't insert constraint, segment leaves the hull.");
+      return kInvalidIndex;
+    }
+
+    auto const o = m_triangles[Prev(t)];
+    if (o == b)
+      break;
+    if (IsOnSegment(a, b, o))
+    {
+      end = o;
+      break;
+    }
+
+    // t goes from x to y, o is the third vertex.
+    auto const y = m_triangles[Next(t)];
+    crossed = Sign(Orient(a, b, o)) == Sign(Orient(a, b, y)) ? Prev(t) : Next(t);
+  }
+
+  // Flip crossed edges until none of them crosses the segment (Sloan, 1993).
+  std::vector<std::pair<uint32_t, uint32_t>> newEdges;
+  size_t const maxIterations = 100 * crossedEdges.size() * crossedEdges.size() + 1000;
+  size_t iterations = 0;
+  while (!crossedEdges.empty())
+  {
+    if (++iterations > maxIterations)
+    {
+      Logger::ToLog(Logger::Error, "Can't insert constraint, flipping doesn't converge.");
+      return kInvalidIndex;
+    }
+
+    auto const [u, w] = crossedEdges.front();
+    crossedEdges.pop_front();
+    if (IsConstrained(u, w))
+    {
+      Logger::ToLog(Logger::Error, "Can't insert constraint, constraints intersect.");
+      return kInvalidIndex;
+    }
+
+    auto const edge = FindHalfedge(u, w);
+    if (edge == kInvalidIndex || m_halfedges[edge] == kInvalidIndex)
+    {
+      Logger::ToLog(Logger::Error, "Can't insert constraint, crossed edge is not found.");
+      return kInvalidIndex;
+    }
+
+    auto const p = m_triangles[Prev(edge)];
+    auto const q = m_triangles[Prev(m_halfedges[edge])];
+    if (Sign(Orient(p, q, u)) * Sign(Orient(p, q, w)) >= 0)
+    {
+      // The quad is not convex, try again after other flips.
+      crossedEdges.emplace_back(u, w);
+      continue;
+    }
+
+    Flip(edge);
+    if (p != a && q != a && p != end && q != end &&
+        Sign(Orient(a, end, p)) * Sign(Orient(a, end, q)) < 0)
+    {
+      crossedEdges.emplace_back(p, q);
+    }
+    else
+    {
+      newEdges.emplace_back(p, q);
+    }
+  }
+  m_constraints.insert(GetEdgeKey(a, end));
+
+  // Restore the Delaunay property of the new edges.
+  bool swapped = true;
+  for (iterations = 0; swapped && iterations < maxIterations; ++iterations)
+  {
+    swapped = false;
+    for (auto & [u, w] : newEdges)
+    {
+      if (IsConstrained(u, w))
+        continue;
+
+      auto const edge = FindHalfedge(u, w);
+      if (edge == kInvalidIndex || m_halfedges[edge] == kInvalidIndex)
+        continue;
+
+      auto const p = m_triangles[Prev(edge)];
+      auto const q = m_triangles[Prev(m_halfedges[edge])];
+      if (IsInCircle(u, w, p, q))
+      {
+        Flip(edge);
+        u = p;
+        w = q;
+        swapped = true;
+      }
+    }
+  }
+
+  return end;
+}
+
+void ConstrainedDelaunay::RemoveOuterTriangles()
+{
+  // 0-1 BFS from the outside of the hull, crossing a constraint increments the depth.
+  auto const trianglesCount = static_cast<uint32_t>(m_triangles.size() / 3);
+  std::vector<uint32_t> depths(trianglesCount, kInvalidIndex);
+  std::deque<uint32_t> queue;
+  auto visit = [&](uint32_t t, uint32_t depth, bool isConstraint)
+  {
+    depth += isConstraint ? 1 : 0;
+    if (depth >= depths[t])
+      return;
+    depths[t] = depth;
+    if (isConstraint)
+      queue.push_back(t);
+    else
+      queue.push_front(t);
+  };
+
+  for (uint32_t e = 0; e < static_cast<uint32_t>(m_halfedges.size()); ++e)
+  {
+    if (m_halfedges[e] == kInvalidIndex)
+      visit(e / 3, 0, IsConstrained(m_triangles[e], m_triangles[Next(e)]));
+  }
+
+  while (!queue.empty())
+  {
+    auto const t = queue.front();
+    queue.pop_front();
+    for (uint32_t e = 3 * t; e < 3 * t + 3; ++e)
+    {
+      if (m_halfedges[e] != kInvalidIndex)
+      {
+        visit(m_halfedges[e] / 3, depths[t],
+              IsConstrained(m_triangles[e], m_triangles[Next(e)]));
+      }
+    }
+  }
+
+  std::vector<uint32_t> remap(trianglesCount, kInvalidIndex);
+  uint32_t keptCount = 0;
+  for (uint32_t t = 0; t < trianglesCount; ++t)
+  {
+    if (depths[t] != kInvalidIndex && (depths[t] & 1) != 0)
+      remap[t] = keptCount++;
+  }
+
+  std::vector<uint32_t> triangles(keptCount * 3);
+  std::vector<uint32_t> halfedges(keptCount * 3, kInvalidIndex);
+  for (uint32_t t = 0; t < trianglesCount; ++t)
+  {
+    if (remap[t] == kInvalidIndex)
+      continue;
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+      auto const e = 3 * t + i;
+      triangles[3 * remap[t] + i] = m_triangles[e];
+      auto const twin = m_halfedges[e];
+      if (twin != kInvalidIndex && remap[twin / 3] != kInvalidIndex)
+        halfedges[3 * remap[t] + i] = 3 * remap[twin / 3] + twin % 3;
+    }
+  }
+  m_triangles = std::move(triangles);
+  m_halfedges = std::move(halfedges);
+
+  std::fill(m_vertexHalfedges.begin(), m_vertexHalfedges.end(), kInvalidIndex);
+  for (uint32_t e = 0; e < static_cast<uint32_t>(m_triangles.size()); ++e)
+    m_vertexHalfedges[m_triangles[e]] = e;
+}
+}  // namespace rf
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace rf
+{
+// Delaunay triangulation with constraint edges (Sloan's edge flipping on top of delaunator).
+// Triangles and halfedges use the delaunator layout: the halfedge e goes from triangles[e] to
+// triangles[next(e)], halfedges[e] is the opposite halfedge or kInvalidIndex on the hull.
+class ConstrainedDelaunay
+{
+public:
+  static uint32_t constexpr kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+  // coords are interleaved x and y, the triangulation keeps its own copy. Coincident points are
+  // triangulated once, the duplicates are left unreferenced.
+  explicit ConstrainedDelaunay(std::vector<double> coords);
+
+  // Makes the segment between 2 points an edge of the triangulation. Points lying exactly on
+  // the segment split it. Returns false if the constraint intersects another one.
+  bool InsertConstraint(uint32_t v1, uint32_t v2);
+
+  // Removes the triangles out of the closed constraint polygons (even-odd rule).
+  void RemoveOuterTriangles();
+
+  std::vector<uint32_t> const & GetTriangles() const { return m_triangles; }
+  std::vector<uint32_t> const & GetHalfedges() const { return m_halfedges; }
+  bool IsConstrained(uint32_t v1, uint32_t v2) const;
+
+  // Calls func for every vertex connected to v by an edge.
+  void ForEachNeighbour(uint32_t v, std::function<void(uint32_t)> const & func) const;
+
+private:
+  static uint32_t Next(uint32_t e) { return (e % 3 == 2) ? e - 2 : e + 1; }
+  static uint32_t Prev(uint32_t e) { return (e % 3 == 0) ? e + 2 : e - 1; }
+
+  double Orient(uint32_t a, uint32_t b, uint32_t c) const;
+  bool IsInCircle(uint32_t a, uint32_t b, uint32_t c, uint32_t p) const;
+  bool IsOnSegment(uint32_t a, uint32_t b, uint32_t p) const;
+  // Returns the halfedge from v1 to v2 or kInvalidIndex.
+  uint32_t FindHalfedge(uint32_t v1, uint32_t v2) const;
+  uint32_t GetFirstOutgoingHalfedge(uint32_t v) const;
+  void Link(uint32_t a, uint32_t b);
+  // Replaces the diagonal of the quad formed by the triangles of the halfedge e. Returns the
+  // halfedge of the new diagonal.
+  uint32_t Flip(uint32_t e);
+  // Inserts the part of the segment up to the first vertex on it, returns this vertex.
+  uint32_t InsertSegment(uint32_t a, uint32_t b);
+
+  std::vector<double> m_coords;
+  std::vector<uint32_t> m_triangles;
+  std::vector<uint32_t> m_halfedges;
+  // An outgoing halfedge for every vertex.
+  std::vector<uint32_t> m_vertexHalfedges;
+  std::unordered_set<uint64_t> m_constraints;
+};
+}  // namespace rf
@@ -410,4 +410,17 @@ void GpuProgram::SetTexture(std::string const & uniform, Texture * texture, int
   texture->Bind();
   glUniform1i(uf, slot);
 }
+
+void GpuProgram::SetTexture(std::string const & uniform, BufferTexture * texture, int slot)
+{
+  CHECK(texture != nullptr, "Texture must exist");
+
+  auto const uf = GetUniformLocationInternal(uniform);
+  if (uf < 0)
+    return;
+
+  glActiveTexture(GL_TEXTURE0 + slot);
+  texture->Bind();
+  glUniform1i(uf, slot);
+}
 }  // namespace rf::gl
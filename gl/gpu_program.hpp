@@ -14,6 +14,7 @@ enum class ShaderType : uint8_t
   Count
 };
 
+class BufferTexture;
 class Texture;
 
 class GpuProgram
@@ -43,6 +44,7 @@ public:
   void SetMatrixArray(std::string const & uniform, glm::mat4x4 * mat, int count);
 
   void SetTexture(std::string const & uniform, Texture * texture, int slot);
+  void SetTexture(std::string const & uniform, BufferTexture * texture, int slot);
 
   bool ValidateProgram() const;
 
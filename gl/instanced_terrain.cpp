@@ -0,0 +1,146 @@
+#include "instanced_terrain.hpp"
+
+#include "rf.hpp"
+
+namespace rf::gl
+{
+namespace
+{
+static_assert(sizeof(TerrainQuadtree::PatchInstance) == 4 * sizeof(float),
+              "Patch instance must be a single RGBA32F texel.");
+
+uint32_t constexpr kInitialInstancesCount = 256;
+
+char const * const kVertexShaderSource = R"(#version 410 core
+layout(location = 0) in vec3 aPosition;
+
+uniform mat4 uViewProjection;
+uniform sampler2D uHeightmap;
+// Offset (xy), scale (z) and LOD (w) of the patches in heightmap samples.
+uniform samplerBuffer uPatches;
+// Tile size (xy), minimal (z) and maximal (w) altitudes.
+uniform vec4 uTerrainParams;
+uniform vec2 uHeightmapSize;
+uniform float uPatchSize;
+uniform float uLodRange;
+uniform vec3 uCameraPosition;
+
+out vec3 vWorldPosition;
+out vec3 vNormal;
+out vec2 vUV;
+
+float GetHeight(vec2 s)
+{
+  ivec2 p = ivec2(clamp(s, vec2(0.0), uHeightmapSize - 1.0));
+  return mix(uTerrainParams.z, uTerrainParams.w, texelFetch(uHeightmap, p, 0).r);
+}
+
+// The same placement as in MeshGenerator::GenerateTerrain. Vertices out of the heightmap are
+// clamped to its border, so the triangles of partially covered patches degenerate.
+vec3 GetPosition(vec2 s)
+{
+  s = clamp(s, vec2(0.0), uHeightmapSize - 1.0);
+  vec2 p = (s - floor(uHeightmapSize * 0.5)) * uTerrainParams.xy;
+  return vec3(p.x, GetHeight(s), p.y);
+}
+
+void main()
+{
+  vec4 instance = texelFetch(uPatches, gl_InstanceID);
+  vec2 grid = aPosition.xz + 0.5 * uPatchSize;
+  vec2 s = instance.xy + grid * instance.z;
+
+  // Odd vertices collapse to the even ones at the end of the LOD range, so the patch matches
+  // the grid of the next LOD.
+  float rangeEnd = uLodRange * exp2(instance.w);
+  float rangeStart = 0.75 * rangeEnd;
+  vec3 position = GetPosition(s);
+  float morph = clamp((distance(uCameraPosition, position) - rangeStart) /
+                      (rangeEnd - rangeStart), 0.0, 1.0);
+  vec2 target = s - fract(grid * 0.5) * 2.0 * instance.z;
+  position = mix(position, GetPosition(target), morph);
+  s = mix(s, target, morph);
+
+  float dx = GetHeight(s + vec2(1.0, 0.0)) - GetHeight(s - vec2(1.0, 0.0));
+  float dy = GetHeight(s + vec2(0.0, 1.0)) - GetHeight(s - vec2(0.0, 1.0));
+  vNormal = normalize(vec3(-dx / (2.0 * uTerrainParams.x), 1.0, -dy / (2.0 * uTerrainParams.y)));
+  vUV = clamp(s / (uHeightmapSize - 1.0), 0.0, 1.0);
+  vWorldPosition = position;
+  gl_Position = uViewProjection * vec4(position, 1.0);
+}
+)";
+}  // namespace
+
+bool InstancedTerrain::Initialize(std::vector<uint8_t> const & heightmap,
+                                  uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                  TerrainSettings const & settings)
+{
+  return Initialize(heightmap, heightmapWidth, heightmapHeight, settings, GL_R8);
+}
+
+bool InstancedTerrain::Initialize(std::vector<uint16_t> const & heightmap,
+                                  uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                  TerrainSettings const & settings)
+{
+  return Initialize(heightmap, heightmapWidth, heightmapHeight, settings, GL_R16);
+}
+
+template <typename T>
+bool InstancedTerrain::Initialize(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                                  uint32_t heightmapHeight, TerrainSettings const & settings,
+                                  GLint format)
+{
+  m_patches.clear();
+  if (!m_quadtree.BuildPatches(heightmap, heightmapWidth, heightmapHeight, settings))
+    return false;
+
+  m_settings = settings;
+  auto const patchSize = static_cast<float>(settings.m_chunkSize);
+  if (!m_patch.InitializeAsPlane(patchSize, patchSize, settings.m_chunkSize,
+                                 settings.m_chunkSize, 1, 1, MeshVertexAttribute::Position))
+  {
+    return false;
+  }
+
+  if (!m_heightmap.InitializeWithData(format, heightmap.data(), heightmapWidth, heightmapHeight))
+    return false;
+
+  return m_instances.Initialize(GL_RGBA32F,
+                                kInitialInstancesCount * sizeof(TerrainQuadtree::PatchInstance));
+}
+
+void InstancedTerrain::Update(Camera const & camera)
+{
+  m_quadtree.Select(camera, m_patches);
+  m_instances.Update(m_patches.data(), m_patches.size() * sizeof(TerrainQuadtree::PatchInstance));
+  m_viewProjection = camera.GetProjection() * camera.GetView();
+  m_cameraPosition = camera.GetPosition();
+}
+
+void InstancedTerrain::Render(GpuProgram & program)
+{
+  if (m_patches.empty())
+    return;
+
+  auto const w = m_heightmap.GetWidth();
+  auto const h = m_heightmap.GetHeight();
+  program.SetMatrix("uViewProjection", m_viewProjection);
+  program.SetTexture("uHeightmap", &m_heightmap, 0);
+  program.SetTexture("uPatches", &m_instances, 1);
+  program.SetVector("uTerrainParams", glm::vec4(m_settings.m_width / w, m_settings.m_height / h,
+                                                m_settings.m_minAltitude,
+                                                m_settings.m_maxAltitude));
+  program.SetVector("uHeightmapSize", glm::vec2(w, h));
+  program.SetFloat("uPatchSize", static_cast<float>(m_settings.m_chunkSize));
+  program.SetFloat("uLodRange", m_quadtree.GetLodRange(0));
+  program.SetVector("uCameraPosition", m_cameraPosition);
+
+  m_patch.RenderGroup(0, static_cast<uint32_t>(m_patches.size()));
+}
+
+// static
+char const * InstancedTerrain::GetVertexShaderSource()
+{
+  return kVertexShaderSource;
+}
+}  // namespace rf::gl
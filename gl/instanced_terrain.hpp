@@ -0,0 +1,55 @@
+#pragma once
+#define API_OPENGL
+
+#include "terrain_quadtree.hpp"
+#include "gl/mesh.hpp"
+#include "gl/texture.hpp"
+
+namespace rf
+{
+class Camera;
+}  // namespace rf
+
+namespace rf::gl
+{
+class GpuProgram;
+
+// Terrain rendered as instances of a single N x N grid patch (N is TerrainSettings::m_chunkSize),
+// one instance per selected node of the quadtree. Heights are fetched from the heightmap texture
+// in the vertex shader, so the geometry memory doesn't depend on the terrain size. Patches of
+// different LODs are stitched by morphing the vertices to the grid of the next LOD near the end
+// of the LOD range (CDLOD).
+class InstancedTerrain
+{
+public:
+  bool Initialize(std::vector<uint8_t> const & heightmap, uint32_t heightmapWidth,
+                  uint32_t heightmapHeight, TerrainSettings const & settings);
+  bool Initialize(std::vector<uint16_t> const & heightmap, uint32_t heightmapWidth,
+                  uint32_t heightmapHeight, TerrainSettings const & settings);
+
+  // Selects and culls the patches on the CPU, uploads the instances.
+  void Update(Camera const & camera);
+  // The vertex shader of the program must be GetVertexShaderSource(), it passes the world
+  // position, the normal and the UV of the terrain to the fragment shader.
+  void Render(GpuProgram & program);
+
+  static char const * GetVertexShaderSource();
+
+  uint32_t GetPatchesCount() const { return static_cast<uint32_t>(m_patches.size()); }
+  TerrainQuadtree const & GetQuadtree() const { return m_quadtree; }
+
+private:
+  template <typename T>
+  bool Initialize(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                  uint32_t heightmapHeight, TerrainSettings const & settings, GLint format);
+
+  TerrainQuadtree m_quadtree;
+  TerrainSettings m_settings;
+  Mesh m_patch;
+  Texture m_heightmap;
+  BufferTexture m_instances;
+  std::vector<TerrainQuadtree::PatchInstance> m_patches;
+  glm::mat4x4 m_viewProjection = glm::mat4x4(1.0f);
+  glm::vec3 m_cameraPosition = glm::vec3(0.0f);
+};
+}  // namespace rf::gl
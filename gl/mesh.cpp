@@ -32,6 +32,45 @@ uint32_t BindAttributes(uint32_t startIndex, uint32_t attributesMask)
   });
   return index;
 }
+
+uint32_t ToKey(float value)
+{
+  uint32_t key;
+  memcpy(&key, &value, sizeof(float));
+  return key;
+}
+
+enum GeneratedMeshKind : uint32_t
+{
+  Sphere,
+  Plane
+};
+
+struct GeneratedMesh
+{
+  std::weak_ptr<MeshBuffers> m_buffers;
+  // The vertices and indices shared by the meshes which keep them.
+  std::weak_ptr<BaseMesh::MeshGroup const> m_cpuGroup;
+  uint32_t m_attributesMask = 0;
+  uint32_t m_verticesCount = 0;
+  uint32_t m_indicesCount = 0;
+  // The group without vertices and indices.
+  BaseMesh::MeshGroup m_group;
+};
+
+// Meshes are alive while any gl::Mesh holds their buffers.
+std::map<std::array<uint32_t, 8>, GeneratedMesh> g_generatedMeshes;
+
+void ReleaseCpuData(BaseMesh::MeshNode & node)
+{
+  for (auto & group : node.m_groups)
+  {
+    VertexBufferCollection().swap(group.m_vertexBuffers);
+    IndexBuffer32().swap(group.m_indexBuffer);
+  }
+  for (auto & child : node.m_children)
+    ReleaseCpuData(*child);
+}
 }  // namespace
 
 VertexArray::VertexArray()
@@ -63,12 +102,7 @@ void VertexArray::Unbind()
   glBindVertexArray(0);
 }
 
-Mesh::~Mesh()
-{
-  Destroy();
-}
-
-void Mesh::Destroy()
+MeshBuffers::~MeshBuffers()
 {
   if (m_vertexBuffer != 0)
   {
@@ -83,15 +117,120 @@ void Mesh::Destroy()
   }
 
   m_vertexArray.reset();
+}
+
+Mesh::~Mesh()
+{
+  Destroy();
+}
+
+void Mesh::Destroy()
+{
+  m_buffers.reset();
+  m_generatedGroup.reset();
 
   DestroyMesh();
 }
 
-bool Mesh::Initialize(std::string && fileName, uint32_t desiredAttributesMask)
+bool Mesh::InitializeGenerated(GeneratedMeshKey const & key,
+                               std::function<bool()> const & generate)
 {
   Destroy();
 
-  if (!LoadMesh(std::move(fileName), desiredAttributesMask))
+  std::shared_ptr<MeshBuffers> buffers;
+  auto it = g_generatedMeshes.find(key);
+  if (it != g_generatedMeshes.end())
+  {
+    buffers = it->second.m_buffers.lock();
+    if (buffers == nullptr)
+      g_generatedMeshes.erase(it);
+  }
+
+  if (buffers == nullptr)
+  {
+    if (!generate())
+      return false;
+
+    InitBuffers();
+    if (glCheckError())
+    {
+      Destroy();
+      return false;
+    }
+
+    AddToCache(key);
+    if (!m_keepCpuData)
+    {
+      ReleaseCpuData(*m_rootNode);
+      return true;
+    }
+    it = g_generatedMeshes.find(key);
+  }
+  else
+  {
+    m_buffers = std::move(buffers);
+  }
+
+  // The GPU buffers and the draw ranges are shared. The vertices and indices are shared as
+  // immutable data while any mesh keeps them, they are generated again only if all meshes
+  // with the same parameters released them.
+  auto & cachedMesh = it->second;
+  auto cpuGroup = m_keepCpuData ? cachedMesh.m_cpuGroup.lock() : nullptr;
+  if (m_keepCpuData && cpuGroup == nullptr)
+  {
+    if (m_rootNode == nullptr && !generate())
+    {
+      Destroy();
+      return false;
+    }
+    auto group = std::make_shared<MeshGroup>(std::move(m_rootNode->m_groups.front()));
+    group->m_startIndex = cachedMesh.m_group.m_startIndex;
+    cpuGroup = std::move(group);
+    cachedMesh.m_cpuGroup = cpuGroup;
+  }
+  m_generatedGroup = std::move(cpuGroup);
+
+  m_rootNode = std::make_unique<MeshNode>();
+  m_rootNode->m_groups.push_back(cachedMesh.m_group);
+  m_attributesMask = cachedMesh.m_attributesMask;
+  m_verticesCount = cachedMesh.m_verticesCount;
+  m_indicesCount = cachedMesh.m_indicesCount;
+  m_groupsCount = 1;
+  if (m_generatedGroup != nullptr)
+    m_groupsCache.assign(1, m_generatedGroup.get());
+  return true;
+}
+
+void Mesh::AddToCache(GeneratedMeshKey const & key)
+{
+  for (auto it = g_generatedMeshes.begin(); it != g_generatedMeshes.end();)
+  {
+    if (it->second.m_buffers.expired())
+      it = g_generatedMeshes.erase(it);
+    else
+      ++it;
+  }
+
+  auto const & group = m_rootNode->m_groups.front();
+  auto & cachedMesh = g_generatedMeshes[key];
+  cachedMesh.m_buffers = m_buffers;
+  cachedMesh.m_attributesMask = m_attributesMask;
+  cachedMesh.m_verticesCount = m_verticesCount;
+  cachedMesh.m_indicesCount = m_indicesCount;
+  cachedMesh.m_group.m_boundingBox = group.m_boundingBox;
+  cachedMesh.m_group.m_groupIndex = group.m_groupIndex;
+  cachedMesh.m_group.m_verticesCount = group.m_verticesCount;
+  cachedMesh.m_group.m_indicesCount = group.m_indicesCount;
+  cachedMesh.m_group.m_startIndex = group.m_startIndex;
+  cachedMesh.m_group.m_materialIndex = group.m_materialIndex;
+}
+
+bool Mesh::Initialize(std::string && fileName, uint32_t desiredAttributesMask,
+                      KeyframeReduction const & keyframeReduction)
+{
+  Destroy();
+
+  if (!LoadMesh(std::move(fileName), desiredAttributesMask, keyframeReduction))
     return false;
 
   InitBuffers();
@@ -113,7 +252,7 @@ void Mesh::RenderGroup(int index, uint32_t instancesCount) const
   if (group.m_groupIndex < 0 || group.m_indicesCount == 0)
     return;
 
-  m_vertexArray->Bind();
+  m_buffers->m_vertexArray->Bind();
   if (instancesCount == 1)
   {
     glDrawElements(GL_TRIANGLES, group.m_indicesCount, GL_UNSIGNED_INT,
@@ -127,27 +266,38 @@ void Mesh::RenderGroup(int index, uint32_t instancesCount) const
   }
 }
 
-bool Mesh::InitializeAsSphere(float radius, uint32_t attributesMask)
+bool Mesh::InitializeAsSphere(float radius, uint32_t attributesMask, uint32_t tesselationLevel)
 {
-  if (!GenerateSphere(radius, attributesMask))
-    return false;
-
-  InitBuffers();
-  if (glCheckError())
+  GeneratedMeshKey const key = {GeneratedMeshKind::Sphere, ToKey(radius), attributesMask,
+                                tesselationLevel};
+  return InitializeGenerated(key, [&]()
   {
-    Destroy();
-    return false;
-  }
-
-  return true;
+    return GenerateSphere(radius, attributesMask, tesselationLevel);
+  });
 }
 
 bool Mesh::InitializeAsPlane(float width, float height, uint32_t widthSegments,
                              uint32_t heightSegments, uint32_t uSegments,
                              uint32_t vSegments, uint32_t attributesMask)
 {
-  if (!GeneratePlane(width, height, widthSegments, heightSegments, uSegments,
-                     vSegments, attributesMask))
+  GeneratedMeshKey const key = {GeneratedMeshKind::Plane, ToKey(width), ToKey(height),
+                                widthSegments, heightSegments, uSegments, vSegments,
+                                attributesMask};
+  return InitializeGenerated(key, [&]()
+  {
+    return GeneratePlane(width, height, widthSegments, heightSegments, uSegments, vSegments,
+                         attributesMask);
+  });
+}
+
+template <typename T>
+bool Mesh::InitializeAsTerrainImpl(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                                   uint32_t heightmapHeight, float minAltitude,
+                                   float maxAltitude, float width, float height,
+                                   uint32_t attributesMask)
+{
+  if (!GenerateTerrain(heightmap, heightmapWidth, heightmapHeight, minAltitude, maxAltitude,
+                       width, height, attributesMask))
   {
     return false;
   }
@@ -167,8 +317,44 @@ bool Mesh::InitializeAsTerrain(std::vector<uint8_t> const & heightmap,
                                float minAltitude, float maxAltitude, float width, float height,
                                uint32_t attributesMask)
 {
-  if (!GenerateTerrain(heightmap, heightmapWidth, heightmapHeight, minAltitude, maxAltitude,
-                       width, height, attributesMask))
+  return InitializeAsTerrainImpl(heightmap, heightmapWidth, heightmapHeight, minAltitude,
+                                 maxAltitude, width, height, attributesMask);
+}
+
+bool Mesh::InitializeAsTerrain(std::vector<uint16_t> const & heightmap,
+                               uint32_t heightmapWidth, uint32_t heightmapHeight,
+                               float minAltitude, float maxAltitude, float width, float height,
+                               uint32_t attributesMask)
+{
+  return InitializeAsTerrainImpl(heightmap, heightmapWidth, heightmapHeight, minAltitude,
+                                 maxAltitude, width, height, attributesMask);
+}
+
+bool Mesh::InitializeAsTerrain(std::vector<glm::vec3> const & positions,
+                               std::vector<glm::vec2> const & borders,
+                               uint32_t attributesMask)
+{
+  if (!GenerateTerrain(positions, borders, attributesMask))
+    return false;
+
+  InitBuffers();
+  if (glCheckError())
+  {
+    Destroy();
+    return false;
+  }
+
+  return true;
+}
+
+template <typename T>
+bool Mesh::InitializeAsAdaptiveTerrainImpl(std::vector<T> const & heightmap,
+                                           uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                           float minAltitude, float maxAltitude, float width,
+                                           float height, float maxError, uint32_t attributesMask)
+{
+  if (!GenerateAdaptiveTerrain(heightmap, heightmapWidth, heightmapHeight, minAltitude,
+                               maxAltitude, width, height, maxError, attributesMask))
   {
     return false;
   }
@@ -183,11 +369,28 @@ bool Mesh::InitializeAsTerrain(std::vector<uint8_t> const & heightmap,
   return true;
 }
 
-bool Mesh::InitializeAsTerrain(std::vector<glm::vec3> const & positions,
-                               std::vector<glm::vec2> const & borders,
-                               uint32_t attributesMask)
+bool Mesh::InitializeAsAdaptiveTerrain(std::vector<uint8_t> const & heightmap,
+                                       uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                       float minAltitude, float maxAltitude, float width,
+                                       float height, float maxError, uint32_t attributesMask)
 {
-  if (!GenerateTerrain(positions, borders, attributesMask))
+  return InitializeAsAdaptiveTerrainImpl(heightmap, heightmapWidth, heightmapHeight, minAltitude,
+                                         maxAltitude, width, height, maxError, attributesMask);
+}
+
+bool Mesh::InitializeAsAdaptiveTerrain(std::vector<uint16_t> const & heightmap,
+                                       uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                       float minAltitude, float maxAltitude, float width,
+                                       float height, float maxError, uint32_t attributesMask)
+{
+  return InitializeAsAdaptiveTerrainImpl(heightmap, heightmapWidth, heightmapHeight, minAltitude,
+                                         maxAltitude, width, height, maxError, attributesMask);
+}
+
+bool Mesh::InitializeAsTiledTerrain(std::vector<glm::vec3> const & positions, float tileSize,
+                                    float maxError, uint32_t attributesMask)
+{
+  if (!GenerateTiledTerrain(positions, tileSize, maxError, attributesMask))
     return false;
 
   InitBuffers();
@@ -200,6 +403,46 @@ bool Mesh::InitializeAsTerrain(std::vector<glm::vec3> const & positions,
   return true;
 }
 
+template <typename T>
+bool Mesh::InitializeAsChunkedTerrainImpl(std::vector<T> const & heightmap,
+                                          uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                          TerrainSettings const & settings,
+                                          TerrainQuadtree & quadtree, uint32_t attributesMask)
+{
+  if (!GenerateChunkedTerrain(heightmap, heightmapWidth, heightmapHeight, settings, quadtree,
+                              attributesMask))
+  {
+    return false;
+  }
+
+  InitBuffers();
+  if (glCheckError())
+  {
+    Destroy();
+    return false;
+  }
+
+  return true;
+}
+
+bool Mesh::InitializeAsChunkedTerrain(std::vector<uint8_t> const & heightmap,
+                                      uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                      TerrainSettings const & settings,
+                                      TerrainQuadtree & quadtree, uint32_t attributesMask)
+{
+  return InitializeAsChunkedTerrainImpl(heightmap, heightmapWidth, heightmapHeight, settings,
+                                        quadtree, attributesMask);
+}
+
+bool Mesh::InitializeAsChunkedTerrain(std::vector<uint16_t> const & heightmap,
+                                      uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                      TerrainSettings const & settings,
+                                      TerrainQuadtree & quadtree, uint32_t attributesMask)
+{
+  return InitializeAsChunkedTerrainImpl(heightmap, heightmapWidth, heightmapHeight, settings,
+                                        quadtree, attributesMask);
+}
+
 bool Mesh::InitializeWithPositions(std::vector<glm::vec3> const & positions, IndexBuffer32 const & indexBuffer)
 {
   AABB aabb;
@@ -247,8 +490,10 @@ bool Mesh::InitializeWithBuffers(VertexBufferCollection const & vertexBuffers, u
 
 void Mesh::InitBuffers()
 {
-  m_vertexArray = std::make_unique<VertexArray>();
-  m_vertexArray->Bind();
+  m_buffers = std::make_shared<MeshBuffers>();
+  auto & vertexArray = m_buffers->m_vertexArray;
+  vertexArray = std::make_unique<VertexArray>();
+  vertexArray->Bind();
 
   uint32_t vbOffset = 0;
   uint32_t ibOffset = 0;
@@ -258,18 +503,18 @@ void Mesh::InitBuffers()
                  true /* fillIndexBuffer */, m_attributesMask);
 
   // Fill OpenGL buffers.
-  glGenBuffers(1, &m_vertexBuffer);
-  glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+  glGenBuffers(1, &m_buffers->m_vertexBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffers->m_vertexBuffer);
   glBufferData(GL_ARRAY_BUFFER, vb.size(), vb.data(), GL_STATIC_DRAW);
 
-  m_vertexArray->BindVertexAttributes(m_attributesMask);
+  vertexArray->BindVertexAttributes(m_attributesMask);
 
-  glGenBuffers(1, &m_indexBuffer);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+  glGenBuffers(1, &m_buffers->m_indexBuffer);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffers->m_indexBuffer);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, ib.size() * sizeof(uint32_t),
                ib.data(), GL_STATIC_DRAW);
 
-  m_vertexArray->Unbind();
+  vertexArray->Unbind();
 
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -21,14 +21,36 @@ private:
   uint32_t m_lastStartIndex = 0;
 };
 
+// GPU buffers of a mesh. Generated meshes with the same parameters share them.
+class MeshBuffers
+{
+public:
+  MeshBuffers() = default;
+  ~MeshBuffers();
+
+  MeshBuffers(MeshBuffers const &) = delete;
+  MeshBuffers & operator=(MeshBuffers const &) = delete;
+
+  std::unique_ptr<VertexArray> m_vertexArray;
+  GLuint m_vertexBuffer = 0;
+  GLuint m_indexBuffer = 0;
+};
+
 class Mesh : public BaseMesh
 {
 public:
   Mesh() = default;
   ~Mesh() override;
 
-  bool Initialize(std::string && fileName, uint32_t desiredAttributesMask = 0xffffffff);
-  bool InitializeAsSphere(float radius, uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  // If the reduction is enabled, keys of the animations which are reconstructed by
+  // the interpolation within the tolerances are dropped, see KeyframeReduction.
+  bool Initialize(std::string && fileName, uint32_t desiredAttributesMask = 0xffffffff,
+                  KeyframeReduction const & keyframeReduction = {});
+  // Spheres and planes are cached by their parameters, meshes with the same parameters share
+  // the GPU buffers and the vertices and indices kept on the CPU side, see SetKeepCpuData.
+  // Use MeshGenerator::GetSphereTesselationLevel to choose the level by the desired precision.
+  bool InitializeAsSphere(float radius, uint32_t attributesMask = Position | Normal | UV0 | Tangent,
+                          uint32_t tesselationLevel = 4);
   bool InitializeAsPlane(float width, float height, uint32_t widthSegments = 1,
                          uint32_t heightSegments = 1, uint32_t uSegments = 1, uint32_t vSegments = 1,
                          uint32_t attributesMask = Position | Normal | UV0 | Tangent);
@@ -36,21 +58,75 @@ public:
                            uint32_t heightmapWidth, uint32_t heightmapHeight,
                            float minAltitude, float maxAltitude, float width, float height,
                            uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  bool InitializeAsTerrain(std::vector<uint16_t> const & heightmap,
+                           uint32_t heightmapWidth, uint32_t heightmapHeight,
+                           float minAltitude, float maxAltitude, float width, float height,
+                           uint32_t attributesMask = Position | Normal | UV0 | Tangent);
   bool InitializeAsTerrain(std::vector<glm::vec3> const & positions, std::vector<glm::vec2> const & borders,
                            uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  // maxError is the maximal vertical distance to the heightmap, see MeshGenerator.
+  bool InitializeAsAdaptiveTerrain(std::vector<uint8_t> const & heightmap,
+                                   uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                   float minAltitude, float maxAltitude, float width, float height,
+                                   float maxError,
+                                   uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  bool InitializeAsAdaptiveTerrain(std::vector<uint16_t> const & heightmap,
+                                   uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                   float minAltitude, float maxAltitude, float width, float height,
+                                   float maxError,
+                                   uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  // Every tile is a group with its own bounding box, see MeshGenerator::GenerateTiledTerrain.
+  bool InitializeAsTiledTerrain(std::vector<glm::vec3> const & positions, float tileSize,
+                                float maxError,
+                                uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  // Every quadtree node is a group, render the groups from TerrainQuadtree::Select.
+  bool InitializeAsChunkedTerrain(std::vector<uint8_t> const & heightmap,
+                                  uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                  TerrainSettings const & settings, TerrainQuadtree & quadtree,
+                                  uint32_t attributesMask = Position | Normal | UV0 | Tangent);
+  bool InitializeAsChunkedTerrain(std::vector<uint16_t> const & heightmap,
+                                  uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                  TerrainSettings const & settings, TerrainQuadtree & quadtree,
+                                  uint32_t attributesMask = Position | Normal | UV0 | Tangent);
   bool InitializeWithPositions(std::vector<glm::vec3> const & postions, IndexBuffer32 const & indexBuffer);
   bool InitializeWithBuffers(VertexBufferCollection const & vertexBuffers, uint32_t verticesCount,
                              IndexBuffer32 const & indexBuffer, AABB const & aabb);
 
   void RenderGroup(int index, uint32_t instancesCount = 1) const;
 
+  // If false, the spheres and planes initialized afterwards don't keep their vertices and
+  // indices after the upload, and the ones found in the cache aren't generated at all.
+  void SetKeepCpuData(bool keep) { m_keepCpuData = keep; }
+  bool GetKeepCpuData() const { return m_keepCpuData; }
+
 private:
+  // Kind of the generated mesh and the parameters of the generator.
+  using GeneratedMeshKey = std::array<uint32_t, 8>;
+
   void Destroy();
   void InitBuffers();
+  // Takes the GPU buffers from the cache or uploads the generated mesh and caches them.
+  bool InitializeGenerated(GeneratedMeshKey const & key, std::function<bool()> const & generate);
+  void AddToCache(GeneratedMeshKey const & key);
+  // Heightmap terrains with 8-bit and 16-bit samples.
+  template <typename T>
+  bool InitializeAsTerrainImpl(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                               uint32_t heightmapHeight, float minAltitude, float maxAltitude,
+                               float width, float height, uint32_t attributesMask);
+  template <typename T>
+  bool InitializeAsAdaptiveTerrainImpl(std::vector<T> const & heightmap,
+                                       uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                       float minAltitude, float maxAltitude, float width,
+                                       float height, float maxError, uint32_t attributesMask);
+  template <typename T>
+  bool InitializeAsChunkedTerrainImpl(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                                      uint32_t heightmapHeight, TerrainSettings const & settings,
+                                      TerrainQuadtree & quadtree, uint32_t attributesMask);
 
-  std::unique_ptr<VertexArray> m_vertexArray;
-  GLuint m_vertexBuffer = 0;
-  GLuint m_indexBuffer = 0;
+  std::shared_ptr<MeshBuffers> m_buffers;
+  // Vertices and indices of the generated mesh, shared with the meshes found in the cache.
+  std::shared_ptr<MeshGroup const> m_generatedGroup;
+  bool m_keepCpuData = true;
 };
 
 class SinglePointMesh
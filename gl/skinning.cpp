@@ -0,0 +1,136 @@
+#include "skinning.hpp"
+
+#include "rf.hpp"
+
+namespace rf::gl
+{
+namespace
+{
+char const * const kMatrix4x4Source = R"(
+uniform samplerBuffer uBones;
+uniform int uBonesOffset;
+
+mat4 GetBoneTransform(uint index)
+{
+  int t = (uBonesOffset + int(index)) * 4;
+  return mat4(texelFetch(uBones, t), texelFetch(uBones, t + 1),
+              texelFetch(uBones, t + 2), texelFetch(uBones, t + 3));
+}
+)";
+
+// Rows of the 3x4 matrix are the columns of the transposed one.
+char const * const kMatrix3x4Source = R"(
+uniform samplerBuffer uBones;
+uniform int uBonesOffset;
+
+mat4 GetBoneTransform(uint index)
+{
+  int t = (uBonesOffset + int(index)) * 3;
+  return transpose(mat4(texelFetch(uBones, t), texelFetch(uBones, t + 1),
+                        texelFetch(uBones, t + 2), vec4(0.0, 0.0, 0.0, 1.0)));
+}
+)";
+
+char const * const kMatrixSkinningSource = R"(
+mat4 GetSkinningTransform(uvec4 indices, vec4 weights)
+{
+  return GetBoneTransform(indices.x) * weights.x + GetBoneTransform(indices.y) * weights.y +
+         GetBoneTransform(indices.z) * weights.z + GetBoneTransform(indices.w) * weights.w;
+}
+
+void SkinVertex(uvec4 indices, vec4 weights, inout vec3 position, inout vec3 normal)
+{
+  mat4 m = GetSkinningTransform(indices, weights);
+  position = (m * vec4(position, 1.0)).xyz;
+  normal = normalize(mat3(m) * normal);
+}
+)";
+
+// The real part is in the first column, the dual one is in the second column.
+char const * const kDualQuaternionSource = R"(
+uniform samplerBuffer uBones;
+uniform int uBonesOffset;
+
+mat2x4 GetBoneDualQuaternion(uint index)
+{
+  int t = (uBonesOffset + int(index)) * 2;
+  return mat2x4(texelFetch(uBones, t), texelFetch(uBones, t + 1));
+}
+
+// Dual quaternions are blended in the hemisphere of the first one.
+mat2x4 GetSkinningDualQuaternion(uvec4 indices, vec4 weights)
+{
+  mat2x4 dq0 = GetBoneDualQuaternion(indices.x);
+  mat2x4 dq1 = GetBoneDualQuaternion(indices.y);
+  mat2x4 dq2 = GetBoneDualQuaternion(indices.z);
+  mat2x4 dq3 = GetBoneDualQuaternion(indices.w);
+  mat2x4 dq = dq0 * weights.x +
+              dq1 * (dot(dq0[0], dq1[0]) < 0.0 ? -weights.y : weights.y) +
+              dq2 * (dot(dq0[0], dq2[0]) < 0.0 ? -weights.z : weights.z) +
+              dq3 * (dot(dq0[0], dq3[0]) < 0.0 ? -weights.w : weights.w);
+  return dq / length(dq[0]);
+}
+
+void SkinVertex(uvec4 indices, vec4 weights, inout vec3 position, inout vec3 normal)
+{
+  mat2x4 dq = GetSkinningDualQuaternion(indices, weights);
+  vec4 r = dq[0];
+  vec4 d = dq[1];
+  position += 2.0 * cross(r.xyz, cross(r.xyz, position) + r.w * position);
+  position += 2.0 * (r.w * d.xyz - d.w * r.xyz + cross(r.xyz, d.xyz));
+  normal += 2.0 * cross(r.xyz, cross(r.xyz, normal) + r.w * normal);
+}
+)";
+
+std::string const kMatrix4x4Helpers = std::string(kMatrix4x4Source) + kMatrixSkinningSource;
+std::string const kMatrix3x4Helpers = std::string(kMatrix3x4Source) + kMatrixSkinningSource;
+}  // namespace
+
+bool BonesPalette::Initialize(uint32_t bonesCount, BonesFormat format)
+{
+  m_format = format;
+  m_bonesCount = 0;
+  return m_buffer.Initialize(GL_RGBA32F,
+                             std::max(bonesCount, 1u) * GetBoneSize(format) * sizeof(float));
+}
+
+void BonesPalette::Update(std::vector<glm::mat4x4> const & bonesTransforms)
+{
+  Update(bonesTransforms.data(), static_cast<uint32_t>(bonesTransforms.size()));
+}
+
+void BonesPalette::Update(glm::mat4x4 const * bonesTransforms, uint32_t bonesCount)
+{
+  m_packedData.resize(static_cast<size_t>(bonesCount) * GetBoneSize(m_format));
+  PackBonesTransforms(bonesTransforms, bonesCount, m_format, m_packedData.data());
+  Update(m_packedData.data(), bonesCount);
+}
+
+void BonesPalette::Update(float const * bonesData, uint32_t bonesCount)
+{
+  m_bonesCount = bonesCount;
+  m_buffer.Update(bonesData, bonesCount * GetBoneSize(m_format) * sizeof(float));
+}
+
+void BonesPalette::Bind(GpuProgram & program, int slot, uint32_t bonesOffset)
+{
+  program.SetTexture("uBones", &m_buffer, slot);
+  program.SetInt("uBonesOffset", static_cast<int>(bonesOffset));
+}
+
+// static
+char const * BonesPalette::GetShaderSource(BonesFormat format)
+{
+  switch (format)
+  {
+    case BonesFormat::Matrix4x4:
+      return kMatrix4x4Helpers.c_str();
+    case BonesFormat::Matrix3x4:
+      return kMatrix3x4Helpers.c_str();
+    case BonesFormat::DualQuaternion:
+      return kDualQuaternionSource;
+  }
+  CHECK(false, "Unknown bones format.");
+  return "";
+}
+}  // namespace rf::gl
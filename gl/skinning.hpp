@@ -0,0 +1,48 @@
+#pragma once
+#define API_OPENGL
+
+#include "animation.hpp"
+#include "gl/texture.hpp"
+
+namespace rf::gl
+{
+class GpuProgram;
+
+// Bones transforms of any number of skinned meshes in a single RGBA32F buffer texture, a bone
+// takes GetBoneSize(format) / 4 texels. Unlike the uniform arrays it isn't limited by the number
+// of uniform components, so the meshes may have any number of bones and the whole result of the
+// batched BaseMesh::GetBonesTransforms is uploaded at once.
+class BonesPalette
+{
+public:
+  // bonesCount is the initial capacity, the palette grows on Update.
+  bool Initialize(uint32_t bonesCount, BonesFormat format = BonesFormat::Matrix4x4);
+  // Packs the transforms to the format of the palette.
+  void Update(std::vector<glm::mat4x4> const & bonesTransforms);
+  void Update(glm::mat4x4 const * bonesTransforms, uint32_t bonesCount);
+  // The data is already in the format of the palette, e.g. of the packed BaseMesh::
+  // GetBonesTransforms or BakedAnimation::GetFrame.
+  void Update(float const * bonesData, uint32_t bonesCount);
+
+  // Binds the palette to uBones and the first bone of the mesh to uBonesOffset, e.g. the offset
+  // of the mesh in the batch.
+  void Bind(GpuProgram & program, int slot, uint32_t bonesOffset = 0);
+
+  // GLSL functions to be placed in a vertex shader after the version directive. Every format
+  // provides void SkinVertex(uvec4 indices, vec4 weights, inout vec3 position, inout vec3 normal)
+  // for the BoneIndices (uvec4) and BoneWeights (vec4) attributes. Matrices also provide
+  // mat4 GetBoneTransform(uint index) and mat4 GetSkinningTransform(uvec4 indices, vec4 weights),
+  // dual quaternions provide mat2x4 GetBoneDualQuaternion(uint index) and
+  // mat2x4 GetSkinningDualQuaternion(uvec4 indices, vec4 weights).
+  static char const * GetShaderSource(BonesFormat format = BonesFormat::Matrix4x4);
+
+  BonesFormat GetFormat() const { return m_format; }
+  uint32_t GetBonesCount() const { return m_bonesCount; }
+
+private:
+  BufferTexture m_buffer;
+  BonesFormat m_format = BonesFormat::Matrix4x4;
+  uint32_t m_bonesCount = 0;
+  std::vector<float> m_packedData;
+};
+}  // namespace rf::gl
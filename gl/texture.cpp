@@ -189,6 +189,22 @@ bool Texture::Initialize(std::string && fileName)
 bool Texture::InitializeWithData(GLint format, uint8_t const * buffer,
                                  uint32_t width, uint32_t height,
                                  bool mipmaps, int pixelFormat)
+{
+  return InitializeWithTypedData(format, buffer, GL_UNSIGNED_BYTE, width, height, mipmaps,
+                                 pixelFormat);
+}
+
+bool Texture::InitializeWithData(GLint format, uint16_t const * buffer,
+                                 uint32_t width, uint32_t height,
+                                 bool mipmaps, int pixelFormat)
+{
+  return InitializeWithTypedData(format, buffer, GL_UNSIGNED_SHORT, width, height, mipmaps,
+                                 pixelFormat);
+}
+
+bool Texture::InitializeWithTypedData(GLint format, void const * buffer, GLenum pixelType,
+                                      uint32_t width, uint32_t height, bool mipmaps,
+                                      int pixelFormat)
 {
   Destroy();
 
@@ -204,8 +220,7 @@ bool Texture::InitializeWithData(GLint format, uint8_t const * buffer,
   glBindTexture(m_target, m_texture);
   auto const mipLevels = mipmaps ? CalculateMipLevelsCount() : 1;
   glTexStorage2D(m_target, mipLevels, m_innerFormat, m_width, m_height);
-  glTexSubImage2D(m_target, 0, 0, 0, m_width, m_height, m_pixelFormat,
-                  GL_UNSIGNED_BYTE, buffer);
+  glTexSubImage2D(m_target, 0, 0, 0, m_width, m_height, m_pixelFormat, pixelType, buffer);
 
   SetSampling();
   if (mipmaps)
@@ -431,4 +446,80 @@ void Texture::Save(std::string && filename) const
 
   SaveToPng(std::move(filename), m_width, m_height, m_format, pixels.data());
 }
+
+BufferTexture::~BufferTexture()
+{
+  Destroy();
+}
+
+bool BufferTexture::Initialize(GLint format, size_t sizeInBytes)
+{
+  return Initialize(format, nullptr, sizeInBytes, GL_STREAM_DRAW);
+}
+
+bool BufferTexture::InitializeWithData(GLint format, void const * data, size_t sizeInBytes)
+{
+  return Initialize(format, data, sizeInBytes, GL_STATIC_DRAW);
+}
+
+bool BufferTexture::Initialize(GLint format, void const * data, size_t sizeInBytes,
+                               GLenum usage)
+{
+  Destroy();
+
+  m_format = format;
+  m_size = sizeInBytes;
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+  glBufferData(GL_TEXTURE_BUFFER, m_size, data, usage);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+  glGenTextures(1, &m_texture);
+  glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, m_format, m_buffer);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+  if (glCheckError())
+  {
+    Destroy();
+    return false;
+  }
+  return true;
+}
+
+void BufferTexture::Update(void const * data, size_t sizeInBytes)
+{
+  if (m_buffer == 0 || sizeInBytes == 0)
+    return;
+
+  glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+  if (sizeInBytes > m_size)
+    m_size = std::max(sizeInBytes, 2 * m_size);
+
+  // Orphaning, the previous storage may still be used by the GPU.
+  glBufferData(GL_TEXTURE_BUFFER, m_size, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_TEXTURE_BUFFER, 0, sizeInBytes, data);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void BufferTexture::Bind()
+{
+  glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+}
+
+void BufferTexture::Destroy()
+{
+  if (m_texture != 0)
+  {
+    glDeleteTextures(1, &m_texture);
+    m_texture = 0;
+  }
+
+  if (m_buffer != 0)
+  {
+    glDeleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+  }
+  m_size = 0;
+}
 }  // namespace rf::gl
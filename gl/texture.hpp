@@ -16,6 +16,10 @@ public:
   bool InitializeWithData(GLint format, uint8_t const * buffer,
                           uint32_t width, uint32_t height,
                           bool mipmaps = false, int pixelFormat = -1);
+  // For 16-bit formats, e.g. GL_R16 heightmaps.
+  bool InitializeWithData(GLint format, uint16_t const * buffer,
+                          uint32_t width, uint32_t height,
+                          bool mipmaps = false, int pixelFormat = -1);
   bool InitializeAsCubemap(std::string && rightFileName,
                            std::string && leftFileName,
                            std::string && topFileName,
@@ -38,9 +42,43 @@ private:
   int m_innerFormat = -1;
   int m_pixelFormat = -1;
 
+  bool InitializeWithTypedData(GLint format, void const * buffer, GLenum pixelType,
+                               uint32_t width, uint32_t height, bool mipmaps, int pixelFormat);
   void SetSampling();
   void GenerateMipmaps();
 
   void Destroy();
 };
+
+// Buffer object viewed as a texture (GL_TEXTURE_BUFFER), shaders read it with texelFetch.
+// Suits the data which is updated every frame, e.g. per-instance parameters.
+class BufferTexture
+{
+public:
+  BufferTexture() = default;
+  ~BufferTexture();
+
+  BufferTexture(BufferTexture const &) = delete;
+  BufferTexture & operator=(BufferTexture const &) = delete;
+
+  // format is a sized format of a texel, e.g. GL_RGBA32F.
+  bool Initialize(GLint format, size_t sizeInBytes);
+  // For the static data, e.g. BakedAnimation::GetData() with GL_RGBA32F.
+  bool InitializeWithData(GLint format, void const * data, size_t sizeInBytes);
+  // The buffer grows if the data doesn't fit.
+  void Update(void const * data, size_t sizeInBytes);
+
+  void Bind();
+
+  size_t GetSize() const { return m_size; }
+
+private:
+  bool Initialize(GLint format, void const * data, size_t sizeInBytes, GLenum usage);
+  void Destroy();
+
+  GLuint m_buffer = 0;
+  GLuint m_texture = 0;
+  GLint m_format = 0;
+  size_t m_size = 0;
+};
 }  // namespace rf::gl
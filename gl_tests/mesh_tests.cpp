@@ -17,3 +17,46 @@ TEST(Mesh, Smoke)
   EXPECT_EQ(true, mesh.InitializeAsPlane(10.0f, 10.0f, 1, 1, 1, 1, desiredAttributesMask));
   EXPECT_EQ(desiredAttributesMask, mesh.GetAttributesMask());
 }
+
+TEST(Mesh, GeneratedMeshesCache)
+{
+  auto const attributesMask = rf::MeshVertexAttribute::Position |
+                              rf::MeshVertexAttribute::Normal;
+  std::vector<std::unique_ptr<rf::gl::Mesh>> meshes;
+  for (int i = 0; i < 3; ++i)
+  {
+    meshes.push_back(std::make_unique<rf::gl::Mesh>());
+    EXPECT_EQ(true, meshes.back()->InitializeAsSphere(2.0f, attributesMask, 3));
+    EXPECT_EQ(meshes.front()->GetTrianglesCount(), meshes.back()->GetTrianglesCount());
+    EXPECT_EQ(meshes.front()->GetBoundingBox().getMax(), meshes.back()->GetBoundingBox().getMax());
+  }
+
+  // The meshes found in the cache aren't generated again, they share the vertices and indices.
+  for (auto const & mesh : meshes)
+  {
+    auto const & group = mesh->GetGroup(0);
+    EXPECT_EQ(&group, &meshes.front()->GetGroup(0));
+    EXPECT_EQ(group.m_indexBuffer.size(), group.m_indicesCount);
+    EXPECT_EQ(group.m_vertexBuffers.size(), 2u);
+  }
+
+  // The shared buffers outlive the first mesh.
+  meshes.front().reset();
+  meshes.back()->RenderGroup(0);
+
+  rf::gl::Mesh gpuOnly;
+  gpuOnly.SetKeepCpuData(false);
+  EXPECT_EQ(true, gpuOnly.InitializeAsSphere(2.0f, attributesMask, 3));
+  EXPECT_EQ(meshes.back()->GetTrianglesCount(), gpuOnly.GetTrianglesCount());
+  EXPECT_TRUE(gpuOnly.GetGroup(0).m_vertexBuffers.empty());
+  EXPECT_TRUE(gpuOnly.GetGroup(0).m_indexBuffer.empty());
+  gpuOnly.RenderGroup(0);
+
+  rf::gl::Mesh shared;
+  EXPECT_EQ(true, shared.InitializeAsSphere(2.0f, attributesMask, 3));
+  EXPECT_EQ(&meshes.back()->GetGroup(0), &shared.GetGroup(0));
+
+  rf::gl::Mesh plane;
+  EXPECT_EQ(true, plane.InitializeAsPlane(10.0f, 10.0f, 4, 4, 1, 1, attributesMask));
+  EXPECT_EQ(32u, plane.GetTrianglesCount());
+}
@@ -0,0 +1,52 @@
+#define API_OPENGL
+#include "rf.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(BonesPalette, Smoke)
+{
+  static char const * kFragmentShaderCode = {
+      "#version 410 core\n"
+      "out vec4 oColor;\n"
+      "void main()\n"
+      "{\n"
+      "  oColor = vec4(1.0);\n"
+      "}"};
+
+  // More bones than fit into the uniform arrays.
+  std::vector<glm::mat4x4> bones(1000, glm::mat4x4(1.0f));
+  for (auto const format : {rf::BonesFormat::Matrix4x4, rf::BonesFormat::Matrix3x4,
+                            rf::BonesFormat::DualQuaternion})
+  {
+    std::string const vertexShaderCode = std::string("#version 410 core\n") +
+      rf::gl::BonesPalette::GetShaderSource(format) +
+      "layout(location = 0) in vec3 aPosition;\n"
+      "layout(location = 1) in vec3 aNormal;\n"
+      "layout(location = 2) in uvec4 aBoneIndices;\n"
+      "layout(location = 3) in vec4 aBoneWeights;\n"
+      "out vec3 vNormal;\n"
+      "void main()\n"
+      "{\n"
+      "  vec3 position = aPosition;\n"
+      "  vNormal = aNormal;\n"
+      "  SkinVertex(aBoneIndices, aBoneWeights, position, vNormal);\n"
+      "  gl_Position = vec4(position, 1.0);\n"
+      "}";
+
+    rf::gl::GpuProgram program;
+    ASSERT_EQ(true, program.Initialize({vertexShaderCode, "", kFragmentShaderCode},
+                                       false /* areFiles */));
+
+    rf::gl::BonesPalette palette;
+    EXPECT_EQ(true, palette.Initialize(64, format));
+    palette.Update(bones);
+    EXPECT_EQ(1000u, palette.GetBonesCount());
+
+    EXPECT_EQ(true, program.Use());
+    palette.Bind(program, 0, 500);
+  }
+
+  // Matrices are the default format.
+  EXPECT_STREQ(rf::gl::BonesPalette::GetShaderSource(rf::BonesFormat::Matrix4x4),
+               rf::gl::BonesPalette::GetShaderSource());
+}
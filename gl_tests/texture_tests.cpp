@@ -36,3 +36,23 @@ TEST(Texture, Smoke)
   rf::Utils::RemoveFile(kFilename);
   EXPECT_EQ(false, rf::Utils::IsPathExisted(kFilename));
 }
+
+TEST(BufferTexture, Smoke)
+{
+  rf::gl::BufferTexture tex;
+  EXPECT_EQ(true, tex.Initialize(GL_RGBA32F, 16 * sizeof(glm::vec4)));
+  EXPECT_EQ(16 * sizeof(glm::vec4), tex.GetSize());
+
+  // The buffer grows if the data doesn't fit.
+  std::vector<glm::vec4> data(100, glm::vec4(1.0f));
+  tex.Update(data.data(), data.size() * sizeof(glm::vec4));
+  EXPECT_LE(data.size() * sizeof(glm::vec4), tex.GetSize());
+}
+
+TEST(BufferTexture, InitializeWithData)
+{
+  rf::gl::BufferTexture tex;
+  std::vector<float> data(3 * 4 * 64, 0.5f);
+  EXPECT_EQ(true, tex.InitializeWithData(GL_RGBA32F, data.data(), data.size() * sizeof(float)));
+  EXPECT_EQ(data.size() * sizeof(float), tex.GetSize());
+}
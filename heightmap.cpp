@@ -0,0 +1,334 @@
+#include "heightmap.hpp"
+
+#include "logger.hpp"
+#include "parallel.hpp"
+
+#ifdef WINDOWS_PLATFORM
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rf
+{
+namespace
+{
+void CalculateRowGradients(uint8_t const * prevRow, uint8_t const * row, uint8_t const * nextRow,
+                           uint32_t width, int16_t * dx, int16_t * dy)
+{
+  auto calculateScalar = [&](uint32_t j)
+  {
+    auto const l = j > 0 ? j - 1 : j;
+    auto const r = j + 1 < width ? j + 1 : j;
+    dx[j] = static_cast<int16_t>((prevRow[r] - prevRow[l]) + 2 * (row[r] - row[l]) +
+                                 (nextRow[r] - nextRow[l]));
+    dy[j] = static_cast<int16_t>((nextRow[l] + 2 * nextRow[j] + nextRow[r]) -
+                                 (prevRow[l] + 2 * prevRow[j] + prevRow[r]));
+  };
+
+  uint32_t j = 0;
+  if (width > 0)
+    calculateScalar(j++);
+
+#ifdef RF_USE_SSE2
+  // 8 samples at once in 16-bit lanes, Sobel sums are in [-1020, 1020].
+  auto const zero = _mm_setzero_si128();
+  auto load = [zero](uint8_t const * p)
+  {
+    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(p)), zero);
+  };
+  auto sum121 = [](__m128i l, __m128i c, __m128i r)
+  {
+    return _mm_add_epi16(_mm_add_epi16(l, r), _mm_slli_epi16(c, 1));
+  };
+  for (; j + 9 <= width; j += 8)
+  {
+    auto const pl = load(prevRow + j - 1);
+    auto const pc = load(prevRow + j);
+    auto const pr = load(prevRow + j + 1);
+    auto const cl = load(row + j - 1);
+    auto const cr = load(row + j + 1);
+    auto const nl = load(nextRow + j - 1);
+    auto const nc = load(nextRow + j);
+    auto const nr = load(nextRow + j + 1);
+    auto const gx = sum121(_mm_sub_epi16(pr, pl), _mm_sub_epi16(cr, cl), _mm_sub_epi16(nr, nl));
+    auto const gy = _mm_sub_epi16(sum121(nl, nc, nr), sum121(pl, pc, pr));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dx + j), gx);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dy + j), gy);
+  }
+#endif
+
+  for (; j < width; ++j)
+    calculateScalar(j);
+}
+
+template <typename T>
+void MarkChangedSample(T const * prevRow, T const * row, T const * nextRow, uint32_t width,
+                       T tolerance, uint32_t j, uint8_t * changed)
+{
+  // Clamped neighbours are the sample itself or its other neighbours.
+  auto const l = j > 0 ? j - 1 : j;
+  auto const r = j + 1 < width ? j + 1 : j;
+  auto const v = static_cast<int>(row[j]);
+  auto differs = [v, tolerance](T n) { return abs(v - static_cast<int>(n)) > tolerance; };
+  changed[j] = static_cast<uint8_t>(differs(prevRow[l]) || differs(prevRow[j]) ||
+                                    differs(prevRow[r]) || differs(row[l]) ||
+                                    differs(row[r]) || differs(nextRow[l]) ||
+                                    differs(nextRow[j]) || differs(nextRow[r]));
+}
+}  // namespace
+
+void MarkChangedSamples(uint8_t const * prevRow, uint8_t const * row, uint8_t const * nextRow,
+                        uint32_t width, uint8_t tolerance, uint8_t * changed)
+{
+  auto markScalar = [&](uint32_t j)
+  {
+    MarkChangedSample(prevRow, row, nextRow, width, tolerance, j, changed);
+  };
+
+  uint32_t j = 0;
+  if (width > 0)
+    markScalar(j++);
+
+#ifdef RF_USE_SSE2
+  // 16 samples at once, all 9 loads are inside the rows.
+  auto const t = _mm_set1_epi8(static_cast<char>(tolerance));
+  auto const one = _mm_set1_epi8(1);
+  auto const zero = _mm_setzero_si128();
+  auto differs = [t](__m128i a, __m128i b)
+  {
+    // Non-zero bytes where |a - b| > tolerance.
+    auto const d = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+    return _mm_subs_epu8(d, t);
+  };
+  auto load = [](uint8_t const * p)
+  {
+    return _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+  };
+  for (; j + 17 <= width; j += 16)
+  {
+    auto const v = load(row + j);
+    auto d = _mm_or_si128(differs(v, load(row + j - 1)), differs(v, load(row + j + 1)));
+    d = _mm_or_si128(d, differs(v, load(prevRow + j - 1)));
+    d = _mm_or_si128(d, differs(v, load(prevRow + j)));
+    d = _mm_or_si128(d, differs(v, load(prevRow + j + 1)));
+    d = _mm_or_si128(d, differs(v, load(nextRow + j - 1)));
+    d = _mm_or_si128(d, differs(v, load(nextRow + j)));
+    d = _mm_or_si128(d, differs(v, load(nextRow + j + 1)));
+    auto const result = _mm_andnot_si128(_mm_cmpeq_epi8(d, zero), one);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(changed + j), result);
+  }
+#endif
+
+  for (; j < width; ++j)
+    markScalar(j);
+}
+
+void MarkChangedSamples(uint16_t const * prevRow, uint16_t const * row, uint16_t const * nextRow,
+                        uint32_t width, uint16_t tolerance, uint8_t * changed)
+{
+  for (uint32_t j = 0; j < width; ++j)
+    MarkChangedSample(prevRow, row, nextRow, width, tolerance, j, changed);
+}
+
+void HeightmapGradients::Calculate(std::vector<uint8_t> const & heightmap, uint32_t width,
+                                   uint32_t height)
+{
+  m_width = width;
+  m_height = height;
+  m_dx.resize(static_cast<size_t>(width) * height);
+  m_dy.resize(static_cast<size_t>(width) * height);
+
+  uint32_t const kRowsPerBlock = 32;
+  auto const blocksCount = (height + kRowsPerBlock - 1) / kRowsPerBlock;
+  ParallelFor(blocksCount, [&](uint32_t blockIndex)
+  {
+    auto const startRow = blockIndex * kRowsPerBlock;
+    auto const endRow = std::min(startRow + kRowsPerBlock, height);
+    for (uint32_t i = startRow; i < endRow; ++i)
+    {
+      auto const offset = static_cast<size_t>(i) * width;
+      auto const row = heightmap.data() + offset;
+      auto const prevRow = i > 0 ? row - width : row;
+      auto const nextRow = i + 1 < height ? row + width : row;
+      CalculateRowGradients(prevRow, row, nextRow, width, m_dx.data() + offset,
+                            m_dy.data() + offset);
+    }
+  });
+}
+
+glm::vec2 HeightmapGradients::Calculate(std::vector<uint8_t> const & heightmap, uint32_t width,
+                                        uint32_t height, uint32_t x, uint32_t y)
+{
+  auto getHeight = [&heightmap, width](uint32_t sx, uint32_t sy)
+  {
+    return heightmap[static_cast<size_t>(sy) * width + sx];
+  };
+  return Calculate(getHeight, width, height, x, y);
+}
+
+glm::vec2 HeightmapGradients::Calculate(std::vector<uint16_t> const & heightmap, uint32_t width,
+                                        uint32_t height, uint32_t x, uint32_t y)
+{
+  auto getHeight = [&heightmap, width](uint32_t sx, uint32_t sy)
+  {
+    return heightmap[static_cast<size_t>(sy) * width + sx];
+  };
+  return Calculate(getHeight, width, height, x, y);
+}
+
+glm::vec2 HeightmapGradients::Get(uint32_t x, uint32_t y) const
+{
+  auto const index = static_cast<size_t>(y) * m_width + x;
+  return glm::vec2(m_dx[index] * GetSobelScale(x, m_width),
+                   m_dy[index] * GetSobelScale(y, m_height));
+}
+
+glm::vec2 HeightmapGradients::Sample(float x, float y) const
+{
+  x = glm::clamp(x, 0.0f, static_cast<float>(m_width - 1));
+  y = glm::clamp(y, 0.0f, static_cast<float>(m_height - 1));
+  auto const x0 = static_cast<uint32_t>(x);
+  auto const y0 = static_cast<uint32_t>(y);
+  auto const x1 = std::min(x0 + 1, m_width - 1);
+  auto const y1 = std::min(y0 + 1, m_height - 1);
+  auto const fx = x - x0;
+  auto const fy = y - y0;
+  return glm::mix(glm::mix(Get(x0, y0), Get(x1, y0), fx),
+                  glm::mix(Get(x0, y1), Get(x1, y1), fx), fy);
+}
+
+glm::vec3 HeightmapGradients::GetNormal(glm::vec2 const & gradient, float altitudeScale,
+                                        float tileSizeX, float tileSizeY)
+{
+  return glm::normalize(glm::vec3(-gradient.x * altitudeScale / tileSizeX, 1.0f,
+                                  -gradient.y * altitudeScale / tileSizeY));
+}
+
+glm::vec3 HeightmapGradients::GetTangent(glm::vec2 const & gradient, float altitudeScale,
+                                         float tileSizeX)
+{
+  return glm::normalize(glm::vec3(1.0f, gradient.x * altitudeScale / tileSizeX, 0.0f));
+}
+
+HeightmapFile::~HeightmapFile()
+{
+  Close();
+}
+
+bool HeightmapFile::Open(std::string const & fileName, uint32_t width, uint32_t height,
+                         Format format, float minValue, float maxValue)
+{
+  Close();
+
+  auto const sampleSize = format == Format::UInt16 ? sizeof(uint16_t) : sizeof(float);
+  auto const size = static_cast<size_t>(width) * height * sampleSize;
+  if (width == 0 || height == 0 || (format == Format::Float && maxValue <= minValue))
+  {
+    Logger::ToLogWithFormat(Logger::Error, "Can't open heightmap '%s', parameters are invalid.",
+                            fileName.c_str());
+    return false;
+  }
+
+#ifdef WINDOWS_PLATFORM
+  auto const file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  LARGE_INTEGER fileSize = {};
+  if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) ||
+      static_cast<size_t>(fileSize.QuadPart) < size)
+  {
+    if (file != INVALID_HANDLE_VALUE)
+      CloseHandle(file);
+    Logger::ToLogWithFormat(Logger::Error, "Can't open heightmap '%s'.", fileName.c_str());
+    return false;
+  }
+  m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (m_mapping != nullptr)
+    m_data = static_cast<uint8_t const *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, size));
+#else
+  auto const file = open(fileName.c_str(), O_RDONLY);
+  struct stat fileStat = {};
+  if (file < 0 || fstat(file, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < size)
+  {
+    if (file >= 0)
+      close(file);
+    Logger::ToLogWithFormat(Logger::Error, "Can't open heightmap '%s'.", fileName.c_str());
+    return false;
+  }
+  auto const data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+  if (data != MAP_FAILED)
+    m_data = static_cast<uint8_t const *>(data);
+#endif
+
+  if (m_data == nullptr)
+  {
+    Close();
+    Logger::ToLogWithFormat(Logger::Error, "Can't map heightmap '%s'.", fileName.c_str());
+    return false;
+  }
+
+  m_size = size;
+  m_width = width;
+  m_height = height;
+  m_format = format;
+  m_minValue = minValue;
+  m_maxValue = maxValue;
+  return true;
+}
+
+void HeightmapFile::Close()
+{
+#ifdef WINDOWS_PLATFORM
+  if (m_data != nullptr)
+    UnmapViewOfFile(m_data);
+  if (m_mapping != nullptr)
+    CloseHandle(m_mapping);
+  m_mapping = nullptr;
+#else
+  if (m_data != nullptr)
+    munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+  m_data = nullptr;
+  m_size = 0;
+  m_width = 0;
+  m_height = 0;
+}
+
+uint16_t HeightmapFile::Get(uint32_t x, uint32_t y) const
+{
+  auto const index = static_cast<size_t>(y) * m_width + x;
+  if (m_format == Format::UInt16)
+  {
+    uint16_t value;
+    memcpy(&value, m_data + index * sizeof(uint16_t), sizeof(uint16_t));
+    return value;
+  }
+
+  float value;
+  memcpy(&value, m_data + index * sizeof(float), sizeof(float));
+  auto const normalized = glm::clamp((value - m_minValue) / (m_maxValue - m_minValue), 0.0f, 1.0f);
+  return static_cast<uint16_t>(normalized * std::numeric_limits<uint16_t>::max() + 0.5f);
+}
+
+void HeightmapFile::ReadTile(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                             std::vector<uint16_t> & tile) const
+{
+  tile.resize(static_cast<size_t>(width) * height);
+  if (m_data == nullptr)
+    return;
+
+  for (uint32_t i = 0; i < height; ++i)
+  {
+    auto const sy = std::min(y + i, m_height - 1);
+    auto const row = tile.data() + static_cast<size_t>(i) * width;
+    for (uint32_t j = 0; j < width; ++j)
+      row[j] = Get(std::min(x + j, m_width - 1), sy);
+  }
+}
+}  // namespace rf
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace rf
+{
+// Sobel gradients of an 8-bit heightmap, the gradients of 16-bit heightmaps are calculated per
+// sample. Samples out of the heightmap are clamped to its border, where the differences are
+// one-sided and divided by the actual distance between the samples. Gradients are in heightmap
+// units per sample.
+class HeightmapGradients
+{
+public:
+  void Calculate(std::vector<uint8_t> const & heightmap, uint32_t width, uint32_t height);
+
+  glm::vec2 Get(uint32_t x, uint32_t y) const;
+  // Bilinear interpolation, coordinates are in samples.
+  glm::vec2 Sample(float x, float y) const;
+
+  // The gradient of one sample without the gradients grid, for sparse vertex sets.
+  static glm::vec2 Calculate(std::vector<uint8_t> const & heightmap, uint32_t width,
+                             uint32_t height, uint32_t x, uint32_t y);
+  static glm::vec2 Calculate(std::vector<uint16_t> const & heightmap, uint32_t width,
+                             uint32_t height, uint32_t x, uint32_t y);
+  // getHeight(x, y) returns the sample of a heightmap of any type.
+  template <typename GetHeight>
+  static glm::vec2 Calculate(GetHeight const & getHeight, uint32_t width, uint32_t height,
+                             uint32_t x, uint32_t y)
+  {
+    auto const t = y > 0 ? y - 1 : y;
+    auto const b = y + 1 < height ? y + 1 : y;
+    auto const l = x > 0 ? x - 1 : x;
+    auto const r = x + 1 < width ? x + 1 : x;
+    auto h = [&getHeight](uint32_t sx, uint32_t sy)
+    {
+      return static_cast<float>(getHeight(sx, sy));
+    };
+    auto const dx = (h(r, t) - h(l, t)) + 2.0f * (h(r, y) - h(l, y)) + (h(r, b) - h(l, b));
+    auto const dy = (h(l, b) + 2.0f * h(x, b) + h(r, b)) - (h(l, t) + 2.0f * h(x, t) + h(r, t));
+    return glm::vec2(dx * GetSobelScale(x, width), dy * GetSobelScale(y, height));
+  }
+
+  // Converts a Sobel sum to the gradient: the weights sum to 4 and the samples are 2 apart
+  // inside and 1 apart on the border.
+  static float GetSobelScale(uint32_t i, uint32_t size)
+  {
+    auto const distance = (i + 1 < size ? i + 1 : i) - (i > 0 ? i - 1 : i);
+    return distance > 0 ? 0.25f / distance : 0.0f;
+  }
+
+  uint32_t GetWidth() const { return m_width; }
+  uint32_t GetHeight() const { return m_height; }
+
+  // altitudeScale is the altitude per heightmap unit, tile sizes are the distances between
+  // neighbouring samples.
+  static glm::vec3 GetNormal(glm::vec2 const & gradient, float altitudeScale,
+                             float tileSizeX, float tileSizeY);
+  // Tangent along +X in the plane of the normal.
+  static glm::vec3 GetTangent(glm::vec2 const & gradient, float altitudeScale,
+                              float tileSizeX);
+
+private:
+  // Raw Sobel sums, 8 times bigger than the gradients.
+  std::vector<int16_t> m_dx;
+  std::vector<int16_t> m_dy;
+  uint32_t m_width = 0;
+  uint32_t m_height = 0;
+};
+
+// Marks the samples of the row which differ by more than tolerance from any of their 8
+// neighbours, changed[j] is 1 or 0. Missing rows of the borders must be replaced by the row
+// itself and neighbours out of the row are skipped, it doesn't change the result.
+void MarkChangedSamples(uint8_t const * prevRow, uint8_t const * row, uint8_t const * nextRow,
+                        uint32_t width, uint8_t tolerance, uint8_t * changed);
+void MarkChangedSamples(uint16_t const * prevRow, uint16_t const * row, uint16_t const * nextRow,
+                        uint32_t width, uint16_t tolerance, uint8_t * changed);
+
+// Raw heightmap file: row-major samples without a header in the native byte order. The file is
+// mapped into memory, so only the touched pages are loaded and it can be larger than RAM.
+class HeightmapFile
+{
+public:
+  enum class Format : uint8_t
+  {
+    UInt16,
+    Float
+  };
+
+  HeightmapFile() = default;
+  ~HeightmapFile();
+
+  HeightmapFile(HeightmapFile const &) = delete;
+  HeightmapFile & operator=(HeightmapFile const &) = delete;
+
+  // Float samples are mapped from [minValue, maxValue] to the 16-bit range.
+  bool Open(std::string const & fileName, uint32_t width, uint32_t height, Format format,
+            float minValue = 0.0f, float maxValue = 1.0f);
+  void Close();
+
+  uint16_t Get(uint32_t x, uint32_t y) const;
+  // Copies the window of the heightmap, samples out of the heightmap are clamped to its border.
+  void ReadTile(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                std::vector<uint16_t> & tile) const;
+
+  uint32_t GetWidth() const { return m_width; }
+  uint32_t GetHeight() const { return m_height; }
+
+private:
+  uint8_t const * m_data = nullptr;
+  size_t m_size = 0;
+#ifdef WINDOWS_PLATFORM
+  void * m_mapping = nullptr;
+#endif
+  uint32_t m_width = 0;
+  uint32_t m_height = 0;
+  Format m_format = Format::UInt16;
+  float m_minValue = 0.0f;
+  float m_maxValue = 1.0f;
+};
+}  // namespace rf
@@ -1,9 +1,15 @@
 #include "mesh_generator.hpp"
+#include "constrained_delaunay.hpp"
+#include "heightmap.hpp"
 #include "mesh_simplifier.hpp"
+#include "parallel.hpp"
+#include "rtin.hpp"
 
 #include "logger.hpp"
 
-#include "3party/delaunator-cpp/include/delaunator.hpp"
+#include <atomic>
+#include <numeric>
+#include <tuple>
 
 namespace rf
 {
@@ -42,28 +48,47 @@ void InitIcosahedron(float radius, std::vector<glm::vec3> & positions,
              6, 8,  3,  8, 9,  4, 9, 5, 2, 4, 11, 6,  2, 10, 8,  6, 7, 9, 8, 1};
 }
 
-uint32_t SplitIcosahedronEdge(float radius, std::vector<glm::vec3> & positions, uint32_t index1,
-                              uint32_t index2)
+using EdgeMidpoints = std::unordered_map<uint64_t, uint32_t>;
+
+uint32_t SplitIcosahedronEdge(float radius, std::vector<glm::vec3> & positions,
+                              EdgeMidpoints & midpoints, uint32_t index1, uint32_t index2)
 {
+  // Every edge is shared by 2 triangles, so the midpoint is created only once.
+  auto const key = (static_cast<uint64_t>(std::min(index1, index2)) << 32) |
+                   std::max(index1, index2);
+  auto const it = midpoints.find(key);
+  if (it != midpoints.end())
+    return it->second;
+
   glm::vec3 pos = glm::normalize(positions[index1] + positions[index2]);
   pos *= radius;
   positions.push_back(std::move(pos));
-  return static_cast<uint32_t>(positions.size()) - 1;
+  auto const index = static_cast<uint32_t>(positions.size()) - 1;
+  midpoints.emplace(key, index);
+  return index;
 }
 
 void TesselateIcosahedron(float radius, std::vector<glm::vec3> & positions,
                           std::vector<uint32_t> & indices, uint32_t tesselationLevel)
 {
+  EdgeMidpoints midpoints;
+  std::vector<uint32_t> newIndicies;
   for (uint32_t i = 0; i < tesselationLevel; i++)
   {
-    std::vector<uint32_t> newIndicies;
-    newIndicies.reserve(indices.size() * 12);
+    // Closed mesh: E = 3F / 2, every edge adds a vertex and every triangle turns into 4.
+    size_t const edgesCount = indices.size() / 2;
+    positions.reserve(positions.size() + edgesCount);
+    midpoints.clear();
+    midpoints.reserve(edgesCount);
+    newIndicies.clear();
+    newIndicies.reserve(indices.size() * 4);
 
     for (size_t j = 0; j < indices.size(); j += 3)
     {
-      uint32_t a = SplitIcosahedronEdge(radius, positions, indices[j], indices[j + 1]);
-      uint32_t b = SplitIcosahedronEdge(radius, positions, indices[j + 1], indices[j + 2]);
-      uint32_t c = SplitIcosahedronEdge(radius, positions, indices[j + 2], indices[j]);
+      uint32_t a = SplitIcosahedronEdge(radius, positions, midpoints, indices[j], indices[j + 1]);
+      uint32_t b = SplitIcosahedronEdge(radius, positions, midpoints, indices[j + 1],
+                                        indices[j + 2]);
+      uint32_t c = SplitIcosahedronEdge(radius, positions, midpoints, indices[j + 2], indices[j]);
 
       newIndicies.push_back(indices[j]);
       newIndicies.push_back(a);
@@ -82,7 +107,7 @@ void TesselateIcosahedron(float radius, std::vector<glm::vec3> & positions,
       newIndicies.push_back(c);
     }
 
-    indices = newIndicies;
+    std::swap(indices, newIndicies);
   }
 }
 
@@ -104,7 +129,7 @@ std::vector<uint32_t> GetWrappedTriangles(std::vector<glm::vec2> const & uv,
     glm::vec3 uvA = glm::vec3(uv[indices[i]].x, uv[indices[i]].y, 0.0);
     glm::vec3 uvB = glm::vec3(uv[indices[i + 1]].x, uv[indices[i + 1]].y, 0.0);
     glm::vec3 uvC = glm::vec3(uv[indices[i + 2]].x, uv[indices[i + 2]].y, 0.0);
-    float const z = ((uvB - uvA) * (uvC - uvA)).z;
+    float const z = glm::cross(uvB - uvA, uvC - uvA).z;
     if (z > 0)
       result.push_back(static_cast<uint32_t>(i));
   }
@@ -204,49 +229,853 @@ void CopyToVertexBuffer(ByteArray & vb, std::vector<T> const & v)
   memcpy(vb.data(), v.data(), sz);
 }
 
-bool IsPointInside(std::vector<glm::vec2> const & borders, glm::vec2 const & pt)
+// Triangulates the points with the borders polygon as constraints and simplifies the mesh.
+// Altitudes of the border vertices are interpolated from their neighbours.
+bool TriangulateTerrain(std::vector<glm::vec3> const & inputPositions,
+                        std::vector<glm::vec2> const & borders,
+                        std::vector<glm::vec3> & positions, std::vector<uint32_t> & indices)
 {
-  if (borders.empty())
-    return true;
+  std::vector<glm::vec3> allPositions = inputPositions;
+  std::vector<uint32_t> borderIndices;
+  uint32_t const inputPointsCount = static_cast<uint32_t>(inputPositions.size());
+  if (!borders.empty())
+  {
+    // Border vertices coincident with the input points reuse them.
+    auto getKey = [](float x, float z)
+    {
+      uint32_t bx, bz;
+      memcpy(&bx, &x, sizeof(float));
+      memcpy(&bz, &z, sizeof(float));
+      return (static_cast<uint64_t>(bx) << 32) | bz;
+    };
+    uint32_t const kNotFound = std::numeric_limits<uint32_t>::max();
+    std::unordered_map<uint64_t, uint32_t> borderVertices;
+    for (auto const & b : borders)
+      borderVertices.emplace(getKey(b.x, b.y), kNotFound);
+    for (uint32_t i = 0; i < inputPointsCount; ++i)
+    {
+      auto const it = borderVertices.find(getKey(inputPositions[i].x, inputPositions[i].z));
+      if (it != borderVertices.end() && it->second == kNotFound)
+        it->second = i;
+    }
 
-  uint32_t rCross = 0;
-  uint32_t lCross = 0;
-  size_t const numPoints = borders.size();
+    borderIndices.reserve(borders.size());
+    for (auto const & b : borders)
+    {
+      auto & index = borderVertices[getKey(b.x, b.y)];
+      if (index == kNotFound)
+      {
+        index = static_cast<uint32_t>(allPositions.size());
+        allPositions.emplace_back(b.x, 0.0f, b.y);
+      }
+      borderIndices.push_back(index);
+    }
+  }
 
-  auto prev = borders[numPoints - 1] - pt;
-  for (size_t i = 0; i < numPoints; ++i)
+  std::vector<double> coords;
+  coords.reserve(allPositions.size() * 2);
+  for (auto const & p : allPositions)
   {
-    auto const cur = borders[i] - pt;
-    if (fabs(glm::length(cur)) < 1e-9)
+    coords.emplace_back(static_cast<double>(p.x));
+    coords.emplace_back(static_cast<double>(p.z));
+  }
+  ConstrainedDelaunay triangulation(std::move(coords));
+
+  if (!borderIndices.empty())
+  {
+    for (size_t i = 0; i < borderIndices.size(); ++i)
+    {
+      if (!triangulation.InsertConstraint(borderIndices[i],
+                                          borderIndices[(i + 1) % borderIndices.size()]))
+      {
+        Logger::ToLog(Logger::Error, "Can't generate landscape, borders are invalid.");
+        return false;
+      }
+    }
+
+    // Inverse distance weighting of the neighbours with known altitudes. Border vertices with
+    // border neighbours only get the altitude on the next passes.
+    std::vector<bool> hasAltitude(allPositions.size(), false);
+    std::fill(hasAltitude.begin(), hasAltitude.begin() + inputPointsCount, true);
+    bool changed = true;
+    while (changed)
+    {
+      changed = false;
+      for (auto const v : borderIndices)
+      {
+        if (hasAltitude[v])
+          continue;
+
+        float altitude = 0.0f;
+        float weights = 0.0f;
+        triangulation.ForEachNeighbour(v, [&](uint32_t n)
+        {
+          if (!hasAltitude[n])
+            return;
+          auto const w = 1.0f / std::max(glm::distance(allPositions[v], allPositions[n]), kEps);
+          altitude += w * allPositions[n].y;
+          weights += w;
+        });
+        if (weights > 0.0f)
+        {
+          allPositions[v].y = altitude / weights;
+          hasAltitude[v] = true;
+          changed = true;
+        }
+      }
+    }
+
+    triangulation.RemoveOuterTriangles();
+  }
+
+  auto const & triangles = triangulation.GetTriangles();
+  std::vector<uint32_t> initialIndices(triangles.begin(), triangles.end());
+
+  MeshSimplifier::MeshData simplifierData;
+  simplifierData.m_positions = std::move(allPositions);
+  simplifierData.m_indices = std::move(initialIndices);
+  MeshSimplifier simplifier(simplifierData);
+  auto result = simplifier.Simplify(100000, 5.0);
+  positions = std::move(result.m_positions);
+  indices = std::move(result.m_indices);
+  return true;
+}
+
+// Tiles of the tiled terrain. Seams between the tiles are constraint edges in the triangulations
+// of both neighbouring tiles, so the tiles share the vertices on the seams without overlapping.
+struct TerrainTiles
+{
+  // Seam coordinates along X and Z, the first and the last ones are the bounds of the points.
+  std::vector<float> m_xs;
+  std::vector<float> m_zs;
+  // Indices of the points by tiles (row-major), points on the seams belong to all adjacent tiles.
+  std::vector<uint32_t> m_offsets;
+  std::vector<uint32_t> m_points;
+  // Altitudes of the corners of the tiles interpolated over the points around them.
+  std::vector<float> m_cornerAltitudes;
+  // Vertices of the seams between the corners in the increasing order, the corners are excluded.
+  // Seams along X go from the corner (x, z) to (x + 1, z), the index is z * tilesX + x. Seams
+  // along Z go from the corner (x, z) to (x, z + 1), the index is z * (tilesX + 1) + x.
+  std::vector<std::vector<glm::vec3>> m_seamsX;
+  std::vector<std::vector<glm::vec3>> m_seamsZ;
+};
+
+// Returns the first and the last tiles containing the coordinate.
+std::pair<uint32_t, uint32_t> GetTilesRange(float v, std::vector<float> const & seams)
+{
+  auto const count = static_cast<uint32_t>(seams.size()) - 1;
+  auto const step = (seams.back() - seams.front()) / count;
+  auto i = static_cast<uint32_t>(glm::clamp((v - seams.front()) / step, 0.0f,
+                                            static_cast<float>(count - 1)));
+  while (i > 0 && v < seams[i])
+    --i;
+  while (i + 1 < count && v >= seams[i + 1])
+    ++i;
+  return {(i > 0 && v == seams[i]) ? i - 1 : i, i};
+}
+
+// Delaunay triangulation of the points in XZ, empty if the points don't span an area.
+std::vector<uint32_t> TriangulateAltitudes(std::vector<glm::vec3> const & points)
+{
+  bool hasArea = false;
+  for (size_t i = 2; i < points.size() && !hasArea; ++i)
+  {
+    auto const a = points[1] - points[0];
+    auto const b = points[i] - points[0];
+    hasArea = a.x * b.z - a.z * b.x != 0.0f;
+  }
+  if (!hasArea)
+    return {};
+
+  std::vector<double> coords;
+  coords.reserve(points.size() * 2);
+  for (auto const & p : points)
+  {
+    coords.emplace_back(static_cast<double>(p.x));
+    coords.emplace_back(static_cast<double>(p.z));
+  }
+  return ConstrainedDelaunay(std::move(coords)).GetTriangles();
+}
+
+// Altitude of the triangulated points at (x, z), false if it's out of the triangulation.
+bool InterpolateAltitude(std::vector<glm::vec3> const & points,
+                         std::vector<uint32_t> const & triangles, float x, float z,
+                         float & altitude)
+{
+  for (size_t i = 0; i < triangles.size(); i += 3)
+  {
+    auto const & a = points[triangles[i]];
+    auto const & b = points[triangles[i + 1]];
+    auto const & c = points[triangles[i + 2]];
+    auto const area = (b.x - a.x) * (c.z - a.z) - (b.z - a.z) * (c.x - a.x);
+    if (area == 0.0f)
+      continue;
+    auto const wb = ((x - a.x) * (c.z - a.z) - (z - a.z) * (c.x - a.x)) / area;
+    auto const wc = ((b.x - a.x) * (z - a.z) - (b.z - a.z) * (x - a.x)) / area;
+    if (wb >= -kEps && wc >= -kEps && wb + wc <= 1.0f + kEps)
+    {
+      altitude = a.y + wb * (b.y - a.y) + wc * (c.y - a.y);
       return true;
+    }
+  }
+  return false;
+}
+
+// Keeps the points of the polyline (coordinate along the seam, altitude) between first and last,
+// which are farther than maxError from the simplified polyline vertically.
+void SimplifySeam(std::vector<glm::vec2> const & profile, size_t first, size_t last,
+                  float maxError, std::vector<uint8_t> & kept)
+{
+  if (last <= first + 1)
+    return;
+
+  auto const & a = profile[first];
+  auto const & b = profile[last];
+  size_t farthest = first;
+  float maxDistance = maxError;
+  for (size_t i = first + 1; i < last; ++i)
+  {
+    auto const t = (profile[i].x - a.x) / (b.x - a.x);
+    auto const d = fabs(profile[i].y - glm::mix(a.y, b.y, t));
+    if (d > maxDistance)
+    {
+      maxDistance = d;
+      farthest = i;
+    }
+  }
+  if (farthest == first)
+    return;
+
+  kept[farthest] = 1;
+  SimplifySeam(profile, first, farthest, maxError, kept);
+  SimplifySeam(profile, farthest, last, maxError, kept);
+}
+
+// Samples the surface of the points on both sides of the seam where their triangulation crosses
+// it, and keeps the samples needed to stay within maxError. The seam goes from (from, altitude
+// fromAltitude) to (to, toAltitude) along the axis (0 is X, 2 is Z) at the coordinate seam of the
+// other axis.
+std::vector<glm::vec3> BuildSeam(std::vector<glm::vec3> const & points, int axis, float seam,
+                                 float from, float to, float fromAltitude, float toAltitude,
+                                 float maxError)
+{
+  auto const other = 2 - axis;
+  std::vector<glm::vec2> profile;
+  profile.emplace_back(from, fromAltitude);
+  for (auto const & p : points)
+  {
+    if (p[other] == seam && p[axis] > from && p[axis] < to)
+      profile.emplace_back(p[axis], p.y);
+  }
+
+  // Edges of the triangulation crossing the seam, every edge is met twice at most.
+  auto const triangles = TriangulateAltitudes(points);
+  for (size_t i = 0; i < triangles.size(); ++i)
+  {
+    auto const & p = points[triangles[i]];
+    auto const & q = points[triangles[i % 3 == 2 ? i - 2 : i + 1]];
+    auto const dp = p[other] - seam;
+    auto const dq = q[other] - seam;
+    if ((dp < 0.0f && dq > 0.0f) || (dp > 0.0f && dq < 0.0f))
+    {
+      auto const t = dp / (dp - dq);
+      auto const v = p[axis] + t * (q[axis] - p[axis]);
+      if (v > from && v < to)
+        profile.emplace_back(v, p.y + t * (q.y - p.y));
+    }
+  }
+  profile.emplace_back(to, toAltitude);
+  std::sort(profile.begin() + 1, profile.end() - 1,
+            [](glm::vec2 const & a, glm::vec2 const & b) { return a.x < b.x; });
+
+  // The crossings of the same edge and the points on the seam coincide, so do the crossings
+  // next to the points.
+  auto const minStep = 1e-5f * (to - from);
+  size_t count = 1;
+  for (size_t i = 1; i < profile.size(); ++i)
+  {
+    if (profile[i].x - profile[count - 1].x > minStep)
+      profile[count++] = profile[i];
+    else if (i + 1 == profile.size())
+      profile[count - 1] = profile[i];
+  }
+  profile.resize(count);
+
+  std::vector<uint8_t> kept(profile.size(), 0);
+  SimplifySeam(profile, 0, profile.size() - 1, maxError, kept);
+
+  std::vector<glm::vec3> result;
+  for (size_t i = 1; i + 1 < profile.size(); ++i)
+  {
+    if (kept[i] == 0)
+      continue;
+    glm::vec3 v;
+    v[axis] = profile[i].x;
+    v.y = profile[i].y;
+    v[other] = seam;
+    result.push_back(v);
+  }
+  return result;
+}
+
+void InitTerrainTiles(std::vector<glm::vec3> const & positions, AABB const & box, float tileSize,
+                      float maxError, TerrainTiles & tiles)
+{
+  auto initSeams = [tileSize](float minValue, float maxValue, std::vector<float> & seams)
+  {
+    auto const count = std::max(static_cast<uint32_t>(ceil((maxValue - minValue) / tileSize)), 1u);
+    seams.resize(count + 1);
+    for (uint32_t i = 0; i < count; ++i)
+      seams[i] = minValue + (maxValue - minValue) * i / count;
+    seams[count] = maxValue;
+  };
+  initSeams(box.getMin().x, box.getMax().x, tiles.m_xs);
+  initSeams(box.getMin().z, box.getMax().z, tiles.m_zs);
+  auto const tilesX = static_cast<uint32_t>(tiles.m_xs.size()) - 1;
+  auto const tilesZ = static_cast<uint32_t>(tiles.m_zs.size()) - 1;
+
+  // Counting sort of the points by tiles.
+  auto forEachTile = [&](glm::vec3 const & p, auto && func)
+  {
+    auto const rangeX = GetTilesRange(p.x, tiles.m_xs);
+    auto const rangeZ = GetTilesRange(p.z, tiles.m_zs);
+    for (auto z = rangeZ.first; z <= rangeZ.second; ++z)
+    {
+      for (auto x = rangeX.first; x <= rangeX.second; ++x)
+        func(x, z);
+    }
+  };
+  tiles.m_offsets.assign(tilesX * tilesZ + 1, 0);
+  for (auto const & p : positions)
+    forEachTile(p, [&](uint32_t x, uint32_t z) { ++tiles.m_offsets[z * tilesX + x + 1]; });
+  for (size_t i = 1; i < tiles.m_offsets.size(); ++i)
+    tiles.m_offsets[i] += tiles.m_offsets[i - 1];
+
+  std::vector<uint32_t> fill(tiles.m_offsets.begin(), tiles.m_offsets.end() - 1);
+  tiles.m_points.resize(tiles.m_offsets.back());
+  float meanAltitude = 0.0f;
+  for (uint32_t i = 0; i < static_cast<uint32_t>(positions.size()); ++i)
+  {
+    forEachTile(positions[i], [&](uint32_t x, uint32_t z)
+    {
+      tiles.m_points[fill[z * tilesX + x]++] = i;
+    });
+    meanAltitude += (positions[i].y - meanAltitude) / (i + 1);
+  }
+
+  // Altitudes are interpolated over the points of the adjacent tiles in a band around the seams,
+  // a quarter of the tile wide on every side.
+  auto const bandX = 0.25f * (tiles.m_xs[1] - tiles.m_xs[0]);
+  auto const bandZ = 0.25f * (tiles.m_zs[1] - tiles.m_zs[0]);
+  auto gatherPoints = [&](uint32_t x0, uint32_t x1, uint32_t z0, uint32_t z1,
+                          float minX, float maxX, float minZ, float maxZ)
+  {
+    std::vector<glm::vec3> points;
+    for (auto z = z0; z <= std::min(z1, tilesZ - 1); ++z)
+    {
+      for (auto x = x0; x <= std::min(x1, tilesX - 1); ++x)
+      {
+        auto const tileIndex = z * tilesX + x;
+        for (auto i = tiles.m_offsets[tileIndex]; i < tiles.m_offsets[tileIndex + 1]; ++i)
+        {
+          auto const & p = positions[tiles.m_points[i]];
+          if (p.x >= minX && p.x <= maxX && p.z >= minZ && p.z <= maxZ)
+            points.push_back(p);
+        }
+      }
+    }
+    // Points on the seams belong to several tiles.
+    std::sort(points.begin(), points.end(), [](glm::vec3 const & a, glm::vec3 const & b)
+    {
+      return std::tie(a.x, a.z, a.y) < std::tie(b.x, b.z, b.y);
+    });
+    points.erase(std::unique(points.begin(), points.end(),
+                             [](glm::vec3 const & a, glm::vec3 const & b)
+                             {
+                               return a.x == b.x && a.z == b.z;
+                             }), points.end());
+    return points;
+  };
 
-    bool const rCheck = ((cur.y > 0) != (prev.y > 0));
-    bool const lCheck = ((cur.y < 0) != (prev.y < 0));
-    if (rCheck || lCheck)
+  // Corners out of the points get the altitudes of the nearest points of the adjacent tiles.
+  auto const cornersX = tilesX + 1;
+  tiles.m_cornerAltitudes.assign(cornersX * (tilesZ + 1), meanAltitude);
+  ParallelFor(static_cast<uint32_t>(tiles.m_cornerAltitudes.size()), [&](uint32_t cornerIndex)
+  {
+    auto const cx = cornerIndex % cornersX;
+    auto const cz = cornerIndex / cornersX;
+    auto const x = tiles.m_xs[cx];
+    auto const z = tiles.m_zs[cz];
+    auto const points = gatherPoints(cx > 0 ? cx - 1 : 0, cx, cz > 0 ? cz - 1 : 0, cz,
+                                     x - bandX, x + bandX, z - bandZ, z + bandZ);
+    auto & altitude = tiles.m_cornerAltitudes[cornerIndex];
+    if (InterpolateAltitude(points, TriangulateAltitudes(points), x, z, altitude))
+      return;
+
+    float minDistance = std::numeric_limits<float>::max();
+    auto const nearest = gatherPoints(cx > 0 ? cx - 1 : 0, cx, cz > 0 ? cz - 1 : 0, cz,
+                                      box.getMin().x, box.getMax().x,
+                                      box.getMin().z, box.getMax().z);
+    for (auto const & p : nearest)
     {
-      auto const delta = prev.y - cur.y;
-      auto const cp = cur.x * prev.y - cur.y * prev.x;
-      if (cp != 0.0)
+      auto const d = glm::distance(glm::vec2(p.x, p.z), glm::vec2(x, z));
+      if (d < minDistance)
       {
-        bool const prevGreaterCur = delta > 0.0;
-        if (rCheck && ((cp > 0.0) == prevGreaterCur))
-          ++rCross;
-        if (lCheck && ((cp > 0.0) != prevGreaterCur))
-          ++lCross;
+        minDistance = d;
+        altitude = p.y;
       }
     }
-    prev = cur;
+  });
+
+  tiles.m_seamsX.resize(tilesX * (tilesZ + 1));
+  tiles.m_seamsZ.resize(cornersX * tilesZ);
+  auto const seamsXCount = static_cast<uint32_t>(tiles.m_seamsX.size());
+  ParallelFor(seamsXCount + static_cast<uint32_t>(tiles.m_seamsZ.size()), [&](uint32_t index)
+  {
+    if (index < seamsXCount)
+    {
+      auto const x = index % tilesX;
+      auto const z = index / tilesX;
+      auto const seam = tiles.m_zs[z];
+      auto const points = gatherPoints(x, x, z > 0 ? z - 1 : 0, z, tiles.m_xs[x],
+                                       tiles.m_xs[x + 1], seam - bandZ, seam + bandZ);
+      tiles.m_seamsX[index] = BuildSeam(points, 0, seam, tiles.m_xs[x], tiles.m_xs[x + 1],
+                                        tiles.m_cornerAltitudes[z * cornersX + x],
+                                        tiles.m_cornerAltitudes[z * cornersX + x + 1], maxError);
+    }
+    else
+    {
+      auto const x = (index - seamsXCount) % cornersX;
+      auto const z = (index - seamsXCount) / cornersX;
+      auto const seam = tiles.m_xs[x];
+      auto const points = gatherPoints(x > 0 ? x - 1 : 0, x, z, z, seam - bandX, seam + bandX,
+                                       tiles.m_zs[z], tiles.m_zs[z + 1]);
+      tiles.m_seamsZ[index - seamsXCount] =
+        BuildSeam(points, 2, seam, tiles.m_zs[z], tiles.m_zs[z + 1],
+                  tiles.m_cornerAltitudes[z * cornersX + x],
+                  tiles.m_cornerAltitudes[(z + 1) * cornersX + x], maxError);
+    }
+  });
+}
+
+// Triangulates the points of the tile with its seams as constraints and simplifies the mesh
+// keeping the vertices on the seams.
+bool TriangulateTerrainTile(std::vector<glm::vec3> const & inputPositions,
+                            TerrainTiles const & tiles, uint32_t tileX, uint32_t tileZ,
+                            float maxError, std::vector<glm::vec3> & positions,
+                            std::vector<uint32_t> & indices)
+{
+  auto const tilesX = static_cast<uint32_t>(tiles.m_xs.size()) - 1;
+  auto const tileIndex = tileZ * tilesX + tileX;
+  auto const minX = tiles.m_xs[tileX];
+  auto const maxX = tiles.m_xs[tileX + 1];
+  auto const minZ = tiles.m_zs[tileZ];
+  auto const maxZ = tiles.m_zs[tileZ + 1];
+
+  // The boundary goes counterclockwise from the corner (minX, minZ), the points on it are
+  // replaced by the seams.
+  std::vector<glm::vec3> tilePositions;
+  auto const cornerAltitude = [&](uint32_t x, uint32_t z)
+  {
+    return tiles.m_cornerAltitudes[z * (tilesX + 1) + x];
+  };
+  auto const & bottom = tiles.m_seamsX[tileZ * tilesX + tileX];
+  auto const & right = tiles.m_seamsZ[tileZ * (tilesX + 1) + tileX + 1];
+  auto const & top = tiles.m_seamsX[(tileZ + 1) * tilesX + tileX];
+  auto const & left = tiles.m_seamsZ[tileZ * (tilesX + 1) + tileX];
+  tilePositions.emplace_back(minX, cornerAltitude(tileX, tileZ), minZ);
+  tilePositions.insert(tilePositions.end(), bottom.begin(), bottom.end());
+  tilePositions.emplace_back(maxX, cornerAltitude(tileX + 1, tileZ), minZ);
+  tilePositions.insert(tilePositions.end(), right.begin(), right.end());
+  tilePositions.emplace_back(maxX, cornerAltitude(tileX + 1, tileZ + 1), maxZ);
+  tilePositions.insert(tilePositions.end(), top.rbegin(), top.rend());
+  tilePositions.emplace_back(minX, cornerAltitude(tileX, tileZ + 1), maxZ);
+  tilePositions.insert(tilePositions.end(), left.rbegin(), left.rend());
+  auto const boundaryCount = static_cast<uint32_t>(tilePositions.size());
+
+  for (auto i = tiles.m_offsets[tileIndex]; i < tiles.m_offsets[tileIndex + 1]; ++i)
+  {
+    auto const & p = inputPositions[tiles.m_points[i]];
+    if (p.x != minX && p.x != maxX && p.z != minZ && p.z != maxZ)
+      tilePositions.push_back(p);
   }
 
-  if ((rCross & 1) != (lCross & 1))
-    return true;
+  std::vector<double> coords;
+  coords.reserve(tilePositions.size() * 2);
+  for (auto const & p : tilePositions)
+  {
+    coords.emplace_back(static_cast<double>(p.x));
+    coords.emplace_back(static_cast<double>(p.z));
+  }
 
-  return static_cast<bool>(rCross & 1);
+  ConstrainedDelaunay triangulation(std::move(coords));
+  for (uint32_t k = 0; k < boundaryCount; ++k)
+  {
+    if (!triangulation.InsertConstraint(k, (k + 1) % boundaryCount))
+    {
+      Logger::ToLogWithFormat(Logger::Error, "Can't generate landscape, tile %u is invalid.",
+                              tileIndex);
+      return false;
+    }
+  }
+
+  std::vector<uint32_t> seamVertices(boundaryCount);
+  std::iota(seamVertices.begin(), seamVertices.end(), 0);
+
+  auto const & triangles = triangulation.GetTriangles();
+  MeshSimplifier::MeshData simplifierData;
+  simplifierData.m_positions = std::move(tilePositions);
+  simplifierData.m_indices.assign(triangles.begin(), triangles.end());
+  MeshSimplifier simplifier(simplifierData);
+  simplifier.LockVertices(seamVertices);
+  MeshSimplifier::SimplificationError error;
+  auto result = simplifier.SimplifyWithErrorBound(maxError, error);
+  positions = std::move(result.m_positions);
+  indices = std::move(result.m_indices);
+  return true;
+}
+
+std::vector<glm::vec2> CalculateTerrainUV(std::vector<glm::vec3> const & positions,
+                                          AABB const & box)
+{
+  std::vector<glm::vec2> uv;
+  uv.reserve(positions.size());
+  auto const w = box.getMax().x - box.getMin().x;
+  auto const h = box.getMax().z - box.getMin().z;
+  for (auto const & p : positions)
+    uv.emplace_back((p.x - box.getMin().x) / w, (p.z - box.getMin().z) / h);
+  return uv;
+}
+
+std::vector<glm::vec2> CalculateTerrainUV(std::vector<glm::vec3> const & positions)
+{
+  AABB box;
+  for (auto const & p : positions)
+    box.extend(p);
+  return CalculateTerrainUV(positions, box);
+}
+
+bool FillTerrainGroup(uint32_t componentsMask, std::vector<glm::vec3> const & positions,
+                      std::vector<glm::vec2> const & uv, std::vector<glm::vec3> const & normals,
+                      std::vector<glm::vec3> const & tangents, std::vector<uint32_t> && indices,
+                      BaseMesh::MeshGroup & meshGroup)
+{
+  bool failed = false;
+  ForEachAttributeWithCheck(
+    componentsMask,
+    [&meshGroup, &failed, &positions, &uv, &normals, &tangents](MeshVertexAttribute attr) {
+      if (attr == MeshVertexAttribute::Position)
+      {
+        for (auto const & p : positions)
+          meshGroup.m_boundingBox.extend(p);
+
+        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], positions);
+      }
+      else if (attr == MeshVertexAttribute::Normal)
+      {
+        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], normals);
+      }
+      else if (attr == MeshVertexAttribute::Tangent)
+      {
+        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], tangents);
+      }
+      else if (attr == MeshVertexAttribute::UV0)
+      {
+        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], uv);
+      }
+      else
+      {
+        failed = true;
+        Logger::ToLog(Logger::Error,
+                      "Can't generate landscape, components mask contains unsupported attributes.");
+        return false;
+      }
+
+      return true;
+    });
+
+  if (!failed)
+  {
+    meshGroup.m_groupIndex = 0;
+    meshGroup.m_verticesCount = static_cast<uint32_t>(positions.size());
+    meshGroup.m_indexBuffer = std::move(indices);
+    meshGroup.m_indicesCount = static_cast<uint32_t>(meshGroup.m_indexBuffer.size());
+  }
+
+  return !failed;
+}
+
+template <typename T>
+bool GenerateAdaptiveTerrainImpl(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                                 uint32_t heightmapHeight, uint32_t componentsMask,
+                                 float minAltitude, float maxAltitude, float width, float height,
+                                 float maxError, BaseMesh::MeshGroup & meshGroup)
+{
+  if (maxError < 0.0f || maxAltitude < minAltitude)
+  {
+    Logger::ToLog(Logger::Error, "Can't generate adaptive terrain, parameters are invalid.");
+    return false;
+  }
+
+  Rtin rtin;
+  if (!rtin.Initialize(heightmap, heightmapWidth, heightmapHeight))
+    return false;
+
+  float const maxValue = std::numeric_limits<T>::max();
+  float const altitudeScale = (maxAltitude - minAltitude) / maxValue;
+  std::vector<uint32_t> samples;
+  std::vector<uint32_t> indices;
+  rtin.Triangulate(altitudeScale > 0.0f ? maxError / altitudeScale : 0.0f, samples, indices);
+
+  // Placement of the samples is the same as in GenerateTerrain. Normals and tangents are
+  // calculated only for the output vertices.
+  float const tileSizeX = width / heightmapWidth;
+  float const tileSizeY = height / heightmapHeight;
+  auto const verticesCount = static_cast<uint32_t>(samples.size());
+  std::vector<glm::vec3> positions(verticesCount);
+  std::vector<glm::vec3> normals(verticesCount);
+  std::vector<glm::vec3> tangents(verticesCount);
+  uint32_t const kVerticesPerBlock = 4096;
+  ParallelFor((verticesCount + kVerticesPerBlock - 1) / kVerticesPerBlock,
+              [&](uint32_t blockIndex)
+  {
+    auto const endIndex = std::min((blockIndex + 1) * kVerticesPerBlock, verticesCount);
+    for (uint32_t i = blockIndex * kVerticesPerBlock; i < endIndex; ++i)
+    {
+      auto const j = samples[i] % heightmapWidth;
+      auto const k = samples[i] / heightmapWidth;
+      auto const x = tileSizeX * (static_cast<int>(j) - static_cast<int>(heightmapWidth) / 2);
+      auto const y = tileSizeY * (static_cast<int>(k) - static_cast<int>(heightmapHeight) / 2);
+      auto const z = glm::mix(minAltitude, maxAltitude,
+                              static_cast<float>(heightmap[samples[i]]) / maxValue);
+      positions[i] = glm::vec3(x, z, y);
+
+      auto const g = HeightmapGradients::Calculate(heightmap, heightmapWidth, heightmapHeight,
+                                                   j, k);
+      normals[i] = HeightmapGradients::GetNormal(g, altitudeScale, tileSizeX, tileSizeY);
+      tangents[i] = HeightmapGradients::GetTangent(g, altitudeScale, tileSizeX);
+    }
+  });
+  auto const uv = CalculateTerrainUV(positions);
+
+  return FillTerrainGroup(componentsMask, positions, uv, normals, tangents, std::move(indices),
+                          meshGroup);
+}
+
+template <typename T>
+bool GenerateTerrainImpl(std::vector<T> const & heightmap, uint32_t heightmapWidth,
+                         uint32_t heightmapHeight, uint32_t componentsMask, float minAltitude,
+                         float maxAltitude, float width, float height,
+                         BaseMesh::MeshGroup & meshGroup)
+{
+  float const tileSizeX = width / heightmapWidth;
+  float const tileSizeY = height / heightmapHeight;
+
+  // Pivot rows and columns split the heightmap into 4x4 parts, corners are pivots as well.
+  auto const di = heightmapHeight / 4;
+  auto const dj = heightmapWidth / 4;
+
+  float const maxValue = std::numeric_limits<T>::max();
+
+  // Rows are processed by blocks on several threads. Every block has its own buffer, so the
+  // points go in the same row-major order as in a serial scan.
+  uint32_t const kRowsPerBlock = 16;
+  T const kTolerance = 0;
+  auto const blocksCount = (heightmapHeight + kRowsPerBlock - 1) / kRowsPerBlock;
+  std::vector<std::vector<glm::vec3>> blockPositions(blocksCount);
+  ParallelFor(blocksCount, [&](uint32_t blockIndex)
+  {
+    std::vector<uint8_t> changed(heightmapWidth);
+    auto & blockResult = blockPositions[blockIndex];
+    auto const startRow = blockIndex * kRowsPerBlock;
+    auto const endRow = std::min(startRow + kRowsPerBlock, heightmapHeight);
+    for (uint32_t i = startRow; i < endRow; ++i)
+    {
+      // Missing rows are replaced by the row itself, it doesn't change the result.
+      auto const row = heightmap.data() + i * heightmapWidth;
+      auto const prevRow = i > 0 ? row - heightmapWidth : row;
+      auto const nextRow = i + 1 < heightmapHeight ? row + heightmapWidth : row;
+      MarkChangedSamples(prevRow, row, nextRow, heightmapWidth, kTolerance, changed.data());
+
+      bool const isPivotRow = (di == 0 || i % di == 0 || i + 1 == heightmapHeight);
+      auto const y = tileSizeY * (static_cast<int>(i) - static_cast<int>(heightmapHeight) / 2);
+      for (uint32_t j = 0; j < heightmapWidth; ++j)
+      {
+        // Skip points around which the similar values.
+        bool const isPivot = isPivotRow && (dj == 0 || j % dj == 0 || j + 1 == heightmapWidth);
+        if (!isPivot && changed[j] == 0)
+          continue;
+
+        auto const x = tileSizeX * (static_cast<int>(j) - static_cast<int>(heightmapWidth) / 2);
+        auto const z = glm::mix(minAltitude, maxAltitude, static_cast<float>(row[j]) / maxValue);
+        blockResult.emplace_back(x, z, y);
+      }
+    }
+  });
+
+  size_t positionsCount = 0;
+  for (auto const & b : blockPositions)
+    positionsCount += b.size();
+
+  std::vector<glm::vec3> positions;
+  positions.reserve(positionsCount);
+  for (auto const & b : blockPositions)
+    positions.insert(positions.end(), b.begin(), b.end());
+
+  std::vector<glm::vec3> terrainPositions;
+  std::vector<uint32_t> indices;
+  if (!TriangulateTerrain(positions, {}, terrainPositions, indices))
+    return false;
+  auto const uv = CalculateTerrainUV(terrainPositions);
+
+  // Normals and tangents come from the Sobel gradients of the heightmap, so they are smooth and
+  // don't depend on the triangulation. The gradients grid of 8-bit heightmaps is calculated
+  // with SIMD, the gradients of 16-bit ones are calculated only for the output vertices.
+  HeightmapGradients gradients;
+  if constexpr(std::is_same<uint8_t, T>::value)
+    gradients.Calculate(heightmap, heightmapWidth, heightmapHeight);
+  float const altitudeScale = (maxAltitude - minAltitude) / maxValue;
+  std::vector<glm::vec3> normals(terrainPositions.size());
+  std::vector<glm::vec3> tangents(terrainPositions.size());
+  uint32_t const kVerticesPerBlock = 4096;
+  auto const verticesCount = static_cast<uint32_t>(terrainPositions.size());
+  ParallelFor((verticesCount + kVerticesPerBlock - 1) / kVerticesPerBlock,
+              [&](uint32_t blockIndex)
+  {
+    auto const endIndex = std::min((blockIndex + 1) * kVerticesPerBlock, verticesCount);
+    for (uint32_t i = blockIndex * kVerticesPerBlock; i < endIndex; ++i)
+    {
+      auto const & p = terrainPositions[i];
+      auto const x = p.x / tileSizeX + static_cast<int>(heightmapWidth) / 2;
+      auto const y = p.z / tileSizeY + static_cast<int>(heightmapHeight) / 2;
+      glm::vec2 g;
+      if constexpr(std::is_same<uint8_t, T>::value)
+      {
+        g = gradients.Sample(x, y);
+      }
+      else
+      {
+        // Vertices are the heightmap samples.
+        auto const j = static_cast<uint32_t>(glm::clamp(std::round(x), 0.0f,
+                                                        heightmapWidth - 1.0f));
+        auto const k = static_cast<uint32_t>(glm::clamp(std::round(y), 0.0f,
+                                                        heightmapHeight - 1.0f));
+        g = HeightmapGradients::Calculate(heightmap, heightmapWidth, heightmapHeight, j, k);
+      }
+      normals[i] = HeightmapGradients::GetNormal(g, altitudeScale, tileSizeX, tileSizeY);
+      tangents[i] = HeightmapGradients::GetTangent(g, altitudeScale, tileSizeX);
+    }
+  });
+
+  return FillTerrainGroup(componentsMask, terrainPositions, uv, normals, tangents,
+                          std::move(indices), meshGroup);
 }
 }  // namespace
 
+uint32_t MeshGenerator::GetSphereTesselationLevel(float radius, float maxError)
+{
+  // Angle between neighbouring vertices of the icosahedron, it halves with every level.
+  // The maximum distance from the sphere is reached in the middle of an edge.
+  double const kIcosahedronEdgeAngle = 1.1071487177940904;
+  double const r = radius;
+  double angle = kIcosahedronEdgeAngle;
+  uint32_t level = 0;
+  while (level < kMaxSphereTesselationLevel && r * (1.0 - cos(0.5 * angle)) > maxError)
+  {
+    angle *= 0.5;
+    ++level;
+  }
+  return level;
+}
+
+// static
+void MeshGenerator::CalculateTangents(std::vector<glm::vec3> const & positions,
+                                      std::vector<glm::vec3> const & normals,
+                                      std::vector<glm::vec2> const & uv,
+                                      std::vector<uint32_t> const & indices,
+                                      std::vector<glm::vec3> & tangents)
+{
+  auto const verticesCount = static_cast<uint32_t>(positions.size());
+  auto const trianglesCount = static_cast<uint32_t>(indices.size() / 3);
+  tangents.resize(verticesCount);
+
+  // Tangents of the triangle corners, projected to the tangent planes of the vertices.
+  std::vector<glm::vec3> cornerTangents(static_cast<size_t>(trianglesCount) * 3);
+  uint32_t const kTrianglesPerBlock = 4096;
+  ParallelFor((trianglesCount + kTrianglesPerBlock - 1) / kTrianglesPerBlock,
+              [&](uint32_t blockIndex)
+  {
+    auto const endIndex = std::min((blockIndex + 1) * kTrianglesPerBlock, trianglesCount);
+    for (uint32_t i = blockIndex * kTrianglesPerBlock; i < endIndex; ++i)
+    {
+      uint32_t const v[3] = {indices[3 * i], indices[3 * i + 1], indices[3 * i + 2]};
+      auto const e1 = positions[v[1]] - positions[v[0]];
+      auto const e2 = positions[v[2]] - positions[v[0]];
+      auto const duv1 = uv[v[1]] - uv[v[0]];
+      auto const duv2 = uv[v[2]] - uv[v[0]];
+      auto const det = duv1.x * duv2.y - duv2.x * duv1.y;
+      if (fabs(det) < std::numeric_limits<float>::min())
+        continue;
+
+      // Derivative of the position by u, it keeps the direction for the mirrored UVs.
+      auto const faceTangent = (e1 * duv2.y - e2 * duv1.y) / det;
+      for (uint32_t k = 0; k < 3; ++k)
+      {
+        auto const & n = normals[v[k]];
+        auto const t = faceTangent - n * glm::dot(n, faceTangent);
+        auto const a = positions[v[(k + 1) % 3]] - positions[v[k]];
+        auto const b = positions[v[(k + 2) % 3]] - positions[v[k]];
+        auto const la = glm::length(a);
+        auto const lb = glm::length(b);
+        auto const lt = glm::length(t);
+        if (la < kEps || lb < kEps || lt < kEps)
+          continue;
+
+        auto const angle = std::acos(glm::clamp(glm::dot(a, b) / (la * lb), -1.0f, 1.0f));
+        cornerTangents[3 * i + k] = t * (angle / lt);
+      }
+    }
+  });
+
+  // Corners of every vertex, so the vertices can be processed independently.
+  std::vector<uint32_t> offsets(verticesCount + 1, 0);
+  for (size_t i = 0; i < cornerTangents.size(); ++i)
+    offsets[indices[i] + 1]++;
+  for (uint32_t i = 0; i < verticesCount; ++i)
+    offsets[i + 1] += offsets[i];
+  std::vector<uint32_t> corners(cornerTangents.size());
+  {
+    std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+    for (uint32_t i = 0; i < static_cast<uint32_t>(corners.size()); ++i)
+      corners[cursors[indices[i]]++] = i;
+  }
+
+  uint32_t const kVerticesPerBlock = 4096;
+  ParallelFor((verticesCount + kVerticesPerBlock - 1) / kVerticesPerBlock,
+              [&](uint32_t blockIndex)
+  {
+    auto const endIndex = std::min((blockIndex + 1) * kVerticesPerBlock, verticesCount);
+    for (uint32_t i = blockIndex * kVerticesPerBlock; i < endIndex; ++i)
+    {
+      glm::vec3 t(0.0f);
+      for (auto c = offsets[i]; c < offsets[i + 1]; ++c)
+        t += cornerTangents[corners[c]];
+
+      auto const & n = normals[i];
+      t -= n * glm::dot(n, t);
+      if (glm::length(t) < kEps)
+      {
+        auto const axis = fabs(n.z) < 0.9f ? glm::vec3(0.0f, 0.0f, 1.0f)
+                                           : glm::vec3(1.0f, 0.0f, 0.0f);
+        t = glm::cross(n, axis);
+      }
+      tangents[i] = glm::normalize(t);
+    }
+  });
+}
+
 bool MeshGenerator::GenerateSphere(float radius, uint32_t componentsMask,
-                                   BaseMesh::MeshGroup & meshGroup)
+                                   BaseMesh::MeshGroup & meshGroup, uint32_t tesselationLevel)
 {
   if (componentsMask == 0)
   {
@@ -260,10 +1089,18 @@ bool MeshGenerator::GenerateSphere(float radius, uint32_t componentsMask,
     return false;
   }
 
+  if (tesselationLevel > kMaxSphereTesselationLevel)
+  {
+    Logger::ToLogWithFormat(Logger::Error,
+                            "Can't generate sphere, tesselation level must not exceed %u.",
+                            kMaxSphereTesselationLevel);
+    return false;
+  }
+
   std::vector<glm::vec3> positions;
   std::vector<uint32_t> indices;
   InitIcosahedron(radius, positions, indices);
-  TesselateIcosahedron(radius, positions, indices, 4);
+  TesselateIcosahedron(radius, positions, indices, tesselationLevel);
 
   std::vector<glm::vec2> uv(positions.size());
   for (size_t i = 0; i < positions.size(); i++)
@@ -274,7 +1111,7 @@ bool MeshGenerator::GenerateSphere(float radius, uint32_t componentsMask,
   bool failed = false;
   ForEachAttributeWithCheck(
       componentsMask,
-      [&meshGroup, &failed, &positions, &uv](MeshVertexAttribute attr) {
+      [&meshGroup, &failed, &positions, &uv, &indices](MeshVertexAttribute attr) {
         if (attr == MeshVertexAttribute::Position)
         {
           for (size_t i = 0; i < positions.size(); i++)
@@ -292,17 +1129,12 @@ bool MeshGenerator::GenerateSphere(float radius, uint32_t componentsMask,
         }
         else if (attr == MeshVertexAttribute::Tangent)
         {
-          std::vector<glm::vec3> tangents(positions.size());
-          for (size_t i = 0; i < tangents.size(); i++)
-          {
-            glm::vec3 n = glm::normalize(positions[i]);
-            if (fabs(n.y + 1.0) < kEps)
-              tangents[i] = glm::vec3(-1, 0, 0);
-            else if (fabs(n.y - 1.0) < kEps)
-              tangents[i] = glm::vec3(1, 0, 0);
-            else
-              tangents[i] = glm::vec3(0, 1, 0) * n;
-          }
+          std::vector<glm::vec3> normals(positions.size());
+          for (size_t i = 0; i < normals.size(); i++)
+            normals[i] = glm::normalize(positions[i]);
+
+          std::vector<glm::vec3> tangents;
+          CalculateTangents(positions, normals, uv, indices, tangents);
           CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], tangents);
         }
         else if (attr == MeshVertexAttribute::UV0)
@@ -410,79 +1242,39 @@ bool MeshGenerator::GenerateTerrain(std::vector<uint8_t> const & heightmap,
                                     uint32_t componentsMask, float minAltitude, float maxAltitude,
                                     float width, float height, BaseMesh::MeshGroup & meshGroup)
 {
-  std::vector<glm::vec3> positions;
-  positions.reserve(heightmapWidth * heightmapHeight);
-  float const tileSizeX = width / heightmapWidth;
-  float const tileSizeY = height / heightmapHeight;
-
-  auto isPivot = [heightmapHeight, heightmapWidth](int i, int j)
-  {
-    if (i == 0 && j == 0)
-      return true;
-    if (i == 0 && j + 1 == heightmapWidth)
-      return true;
-    if (i + 1 == heightmapHeight && j == 0)
-      return true;
-    if (i + 1 == heightmapHeight && j + 1 == heightmapWidth)
-      return true;
-
-    auto const di = heightmapHeight / 4;
-    auto const dj = heightmapWidth / 4;
-    if (i % di == 0 && j % dj == 0)
-      return true;
-
-    if (i % di == 0 && j + 1 == heightmapWidth)
-      return true;
-    if (i + 1 == heightmapHeight && j % dj == 0)
-      return true;
-
-    return false;
-  };
-
-  auto isValidOffset = [heightmapHeight, heightmapWidth](int i, int j, int xoff, int yoff)
-  {
-    i += yoff;
-    j += xoff;
-    return i >= 0 && j >= 0 && i < heightmapHeight && j < heightmapWidth;
-  };
+  return GenerateTerrainImpl(heightmap, heightmapWidth, heightmapHeight, componentsMask,
+                             minAltitude, maxAltitude, width, height, meshGroup);
+}
 
-  uint32_t const kTolerance = 0;
-  for (int i = 0; i < static_cast<int>(heightmapHeight); ++i)
-  {
-    auto const y = tileSizeY * (i - static_cast<int>(heightmapHeight) / 2);
-    for (int j = 0; j < static_cast<int>(heightmapWidth); ++j)
-    {
-      // Skip points around which the similar values.
-      if (!isPivot(i, j))
-      {
-        static std::vector<std::pair<int, int>> const kOffsets = {{-1, -1}, {0, -1}, {1, -1},
-                                                                  {-1, 0}, {1, 0},
-                                                                  {-1, 1}, {0, 1}, {1, 1}};
-        bool diff = false;
-        auto const val = heightmap[i * heightmapWidth + j];
-        for (auto const & [xoff, yoff] : kOffsets)
-        {
-          if (!isValidOffset(i, j, xoff, yoff))
-            continue;
-          auto const valNeighbour = heightmap[(i + yoff) * heightmapWidth + (j + xoff)];
-          if (abs(val - valNeighbour) > kTolerance)
-          {
-            diff = true;
-            break;
-          }
-        }
-        if (!diff)
-          continue;
-      }
+bool MeshGenerator::GenerateTerrain(std::vector<uint16_t> const & heightmap,
+                                    uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                    uint32_t componentsMask, float minAltitude, float maxAltitude,
+                                    float width, float height, BaseMesh::MeshGroup & meshGroup)
+{
+  return GenerateTerrainImpl(heightmap, heightmapWidth, heightmapHeight, componentsMask,
+                             minAltitude, maxAltitude, width, height, meshGroup);
+}
 
-      auto const x = tileSizeX * (j - static_cast<int>(heightmapWidth) / 2);
-      auto const z = glm::mix(minAltitude, maxAltitude,
-                           static_cast<float>(heightmap[i * heightmapWidth + j]) / 255.0f);
-      positions.emplace_back(x, z, y);
-    }
-  }
+bool MeshGenerator::GenerateAdaptiveTerrain(std::vector<uint8_t> const & heightmap,
+                                            uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                            uint32_t componentsMask, float minAltitude,
+                                            float maxAltitude, float width, float height,
+                                            float maxError, BaseMesh::MeshGroup & meshGroup)
+{
+  return GenerateAdaptiveTerrainImpl(heightmap, heightmapWidth, heightmapHeight, componentsMask,
+                                     minAltitude, maxAltitude, width, height, maxError,
+                                     meshGroup);
+}
 
-  return GenerateTerrain(positions, {}, componentsMask, meshGroup);
+bool MeshGenerator::GenerateAdaptiveTerrain(std::vector<uint16_t> const & heightmap,
+                                            uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                            uint32_t componentsMask, float minAltitude,
+                                            float maxAltitude, float width, float height,
+                                            float maxError, BaseMesh::MeshGroup & meshGroup)
+{
+  return GenerateAdaptiveTerrainImpl(heightmap, heightmapWidth, heightmapHeight, componentsMask,
+                                     minAltitude, maxAltitude, width, height, maxError,
+                                     meshGroup);
 }
 
 bool MeshGenerator::GenerateTerrain(std::vector<glm::vec3> const & inputPositions,
@@ -498,54 +1290,13 @@ bool MeshGenerator::GenerateTerrain(std::vector<glm::vec3> const & inputPosition
     return glm::normalize(n1 + n2);
   };
 
-  std::vector<double> coords;
-  coords.reserve(inputPositions.size() * 2);
-  for (auto const & p : inputPositions)
-  {
-    coords.emplace_back(static_cast<double>(p.x));
-    coords.emplace_back(static_cast<double>(p.z));
-  }
-  delaunator::Delaunator d(coords);
-
-  std::vector<uint32_t> initialIndices;
-  initialIndices.reserve(d.triangles.size());
-  for (size_t i = 0; i < d.triangles.size(); i += 3)
-  {
-    auto const p1 = glm::vec2(inputPositions[d.triangles[i]].x,
-                              inputPositions[d.triangles[i]].z);
-    auto const p2 = glm::vec2(inputPositions[d.triangles[i + 1]].x,
-                              inputPositions[d.triangles[i + 1]].z);
-    auto const p3 = glm::vec2(inputPositions[d.triangles[i + 2]].x,
-                              inputPositions[d.triangles[i + 2]].z);
-    auto const center = (p1 + p2 + p3) / 3.0f;
-    if (IsPointInside(borders, center))
-    {
-      initialIndices.push_back(d.triangles[i]);
-      initialIndices.push_back(d.triangles[i + 1]);
-      initialIndices.push_back(d.triangles[i + 2]);
-    }
-  }
-
-  MeshSimplifier::MeshData simplifierData;
-  simplifierData.m_positions = inputPositions;
-  simplifierData.m_indices = std::move(initialIndices);
-  MeshSimplifier simplifier(simplifierData);
-  auto result = simplifier.Simplify(100000, 5.0);
-  auto positions = std::move(result.m_positions);
-  std::vector<uint32_t> indices = std::move(result.m_indices);
-
-  std::vector<glm::vec2> uv;
-  uv.reserve(positions.size());
-  AABB box;
-  for (auto const & p : positions)
-    box.extend(p);
-  auto const w = box.getMax().x - box.getMin().x;
-  auto const h = box.getMax().z - box.getMin().z;
-  for (auto const & p : positions)
-    uv.emplace_back((p.x - box.getMin().x) / w, (p.z - box.getMin().z) / h);
+  std::vector<glm::vec3> positions;
+  std::vector<uint32_t> indices;
+  if (!TriangulateTerrain(inputPositions, borders, positions, indices))
+    return false;
+  auto const uv = CalculateTerrainUV(positions);
 
   std::vector<glm::vec3> normals(positions.size());
-  std::vector<glm::vec3> tangents(positions.size());
   for (size_t i = 0; i < indices.size(); i += 3)
   {
     auto const v1 = glm::normalize(positions[indices[i + 1]] - positions[indices[i]]);
@@ -554,60 +1305,118 @@ bool MeshGenerator::GenerateTerrain(std::vector<glm::vec3> const & inputPosition
     normals[indices[i]] = mergeNormals(n, normals[indices[i]], positions[indices[i]]);
     normals[indices[i + 1]] = mergeNormals(n, normals[indices[i + 1]], positions[indices[i + 1]]);
     normals[indices[i + 2]] = mergeNormals(n, normals[indices[i + 2]], positions[indices[i + 2]]);
-
-    auto const t = glm::cross(n, glm::vec3(0.0f, 0.0f, 1.0f));
-    tangents[indices[i]] += t;
-    tangents[indices[i + 1]] += t;
-    tangents[indices[i + 2]] += t;
   }
 
-  for (size_t i = 0; i < normals.size(); ++i)
+  for (auto & n : normals)
+    n = glm::normalize(n);
+
+  std::vector<glm::vec3> tangents;
+  CalculateTangents(positions, normals, uv, indices, tangents);
+
+  return FillTerrainGroup(componentsMask, positions, uv, normals, tangents, std::move(indices),
+                          meshGroup);
+}
+
+bool MeshGenerator::GenerateTiledTerrain(std::vector<glm::vec3> const & inputPositions,
+                                         float tileSize, float maxError, uint32_t componentsMask,
+                                         std::vector<BaseMesh::MeshGroup> & meshGroups)
+{
+  AABB box;
+  for (auto const & p : inputPositions)
+    box.extend(p);
+  if (tileSize <= 0.0f || maxError < 0.0f || inputPositions.size() < 3 ||
+      box.getMax().x <= box.getMin().x || box.getMax().z <= box.getMin().z)
   {
-    normals[i] = glm::normalize(normals[i]);
-    tangents[i] = glm::normalize(tangents[i]);
+    Logger::ToLog(Logger::Error, "Can't generate tiled landscape, parameters are invalid.");
+    return false;
   }
 
-  bool failed = false;
-  ForEachAttributeWithCheck(
-    componentsMask,
-    [&meshGroup, &failed, &positions, &uv, &normals, &tangents](MeshVertexAttribute attr) {
-      if (attr == MeshVertexAttribute::Position)
-      {
-        for (auto const & p : positions)
-          meshGroup.m_boundingBox.extend(p);
+  TerrainTiles tiles;
+  InitTerrainTiles(inputPositions, box, tileSize, maxError, tiles);
+  auto const tilesX = static_cast<uint32_t>(tiles.m_xs.size()) - 1;
+  auto const tilesCount = tilesX * static_cast<uint32_t>(tiles.m_zs.size() - 1);
 
-        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], positions);
-      }
-      else if (attr == MeshVertexAttribute::Normal)
-      {
-        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], normals);
-      }
-      else if (attr == MeshVertexAttribute::Tangent)
-      {
-        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], tangents);
-      }
-      else if (attr == MeshVertexAttribute::UV0)
-      {
-        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], uv);
-      }
-      else
-      {
-        failed = true;
-        Logger::ToLog(Logger::Error,
-                      "Can't generate landscape, components mask contains unsupported attributes.");
-        return false;
-      }
+  struct Tile
+  {
+    std::vector<glm::vec3> m_positions;
+    std::vector<uint32_t> m_indices;
+    std::vector<glm::vec3> m_normals;
+  };
+  std::vector<Tile> results(tilesCount);
+  std::atomic<bool> failed(false);
+  ParallelFor(tilesCount, [&](uint32_t tileIndex)
+  {
+    auto & tile = results[tileIndex];
+    if (!TriangulateTerrainTile(inputPositions, tiles, tileIndex % tilesX, tileIndex / tilesX,
+                                maxError, tile.m_positions, tile.m_indices))
+    {
+      failed = true;
+      return;
+    }
 
-      return true;
-    });
+    // Area weighted normals, they are normalized after merging on the seams.
+    tile.m_normals.resize(tile.m_positions.size());
+    for (size_t i = 0; i < tile.m_indices.size(); i += 3)
+    {
+      auto const & p = tile.m_positions;
+      auto const n = glm::cross(p[tile.m_indices[i + 1]] - p[tile.m_indices[i]],
+                                p[tile.m_indices[i + 2]] - p[tile.m_indices[i]]);
+      for (uint32_t j = 0; j < 3; ++j)
+        tile.m_normals[tile.m_indices[i + j]] += n;
+    }
+  });
+  if (failed)
+    return false;
 
-  if (!failed)
+  // Vertices on the seams get the normals of all adjacent tiles.
+  auto getKey = [](glm::vec3 const & p)
   {
-    meshGroup.m_groupIndex = 0;
-    meshGroup.m_verticesCount = static_cast<uint32_t>(positions.size());
-    meshGroup.m_indexBuffer = std::move(indices);
-    meshGroup.m_indicesCount = static_cast<uint32_t>(meshGroup.m_indexBuffer.size());
-  }
+    uint32_t bx, bz;
+    memcpy(&bx, &p.x, sizeof(float));
+    memcpy(&bz, &p.z, sizeof(float));
+    return (static_cast<uint64_t>(bx) << 32) | bz;
+  };
+  auto forEachSeamVertex = [&](uint32_t tileIndex, auto && func)
+  {
+    auto const tileX = tileIndex % tilesX;
+    auto const tileZ = tileIndex / tilesX;
+    auto & tile = results[tileIndex];
+    for (size_t i = 0; i < tile.m_positions.size(); ++i)
+    {
+      auto const & p = tile.m_positions[i];
+      if (p.x == tiles.m_xs[tileX] || p.x == tiles.m_xs[tileX + 1] ||
+          p.z == tiles.m_zs[tileZ] || p.z == tiles.m_zs[tileZ + 1])
+      {
+        func(getKey(p), tile.m_normals[i]);
+      }
+    }
+  };
+  std::unordered_map<uint64_t, glm::vec3> seamNormals;
+  for (uint32_t i = 0; i < tilesCount; ++i)
+    forEachSeamVertex(i, [&](uint64_t key, glm::vec3 const & n) { seamNormals[key] += n; });
+  for (uint32_t i = 0; i < tilesCount; ++i)
+    forEachSeamVertex(i, [&](uint64_t key, glm::vec3 & n) { n = seamNormals[key]; });
+
+  meshGroups.clear();
+  meshGroups.resize(tilesCount);
+  ParallelFor(tilesCount, [&](uint32_t tileIndex)
+  {
+    auto & tile = results[tileIndex];
+    for (auto & n : tile.m_normals)
+      n = glm::normalize(n);
+
+    // Texture coordinates are continuous over all the tiles.
+    auto const uv = CalculateTerrainUV(tile.m_positions, box);
+    std::vector<glm::vec3> tangents;
+    CalculateTangents(tile.m_positions, tile.m_normals, uv, tile.m_indices, tangents);
+    if (!FillTerrainGroup(componentsMask, tile.m_positions, uv, tile.m_normals, tangents,
+                          std::move(tile.m_indices), meshGroups[tileIndex]))
+    {
+      failed = true;
+    }
+    meshGroups[tileIndex].m_groupIndex = static_cast<int>(tileIndex);
+    tile = Tile();
+  });
 
   return !failed;
 }
@@ -8,7 +8,26 @@ namespace rf
 class MeshGenerator
 {
 public:
-  bool GenerateSphere(float radius, uint32_t componentsMask, BaseMesh::MeshGroup & meshGroup);
+  // Every level of tesselation multiplies the number of triangles by 4.
+  static uint32_t constexpr kDefaultSphereTesselationLevel = 4;
+  static uint32_t constexpr kMaxSphereTesselationLevel = 10;
+
+  // Returns the minimal tesselation level with the distance to the ideal sphere less than
+  // maxError (or kMaxSphereTesselationLevel).
+  static uint32_t GetSphereTesselationLevel(float radius, float maxError);
+
+  // Per-vertex tangents in the MikkTSpace manner: tangents of the triangle corners are
+  // orthogonalized to the vertex normals and weighted by the corner angles. Vertices without
+  // valid texture coordinates get an arbitrary tangent orthogonal to the normal. Triangles and
+  // vertices are processed in parallel.
+  static void CalculateTangents(std::vector<glm::vec3> const & positions,
+                                std::vector<glm::vec3> const & normals,
+                                std::vector<glm::vec2> const & uv,
+                                std::vector<uint32_t> const & indices,
+                                std::vector<glm::vec3> & tangents);
+
+  bool GenerateSphere(float radius, uint32_t componentsMask, BaseMesh::MeshGroup & meshGroup,
+                      uint32_t tesselationLevel = kDefaultSphereTesselationLevel);
   bool GeneratePlane(float width, float height, uint32_t componentsMask,
                      BaseMesh::MeshGroup & meshGroup, uint32_t widthSegments = 1,
                      uint32_t heightSegments = 1, uint32_t uSegments = 1, uint32_t vSegments = 1);
@@ -16,8 +35,31 @@ public:
                        uint32_t heightmapWidth, uint32_t heightmapHeight,
                        uint32_t componentsMask, float minAltitude, float maxAltitude,
                        float width, float height, BaseMesh::MeshGroup & meshGroup);
+  bool GenerateTerrain(std::vector<uint16_t> const & heightmap,
+                       uint32_t heightmapWidth, uint32_t heightmapHeight,
+                       uint32_t componentsMask, float minAltitude, float maxAltitude,
+                       float width, float height, BaseMesh::MeshGroup & meshGroup);
+  // Right-triangulated irregular network, maxError is the maximal vertical distance between the
+  // mesh and the heightmap in altitude units.
+  bool GenerateAdaptiveTerrain(std::vector<uint8_t> const & heightmap,
+                               uint32_t heightmapWidth, uint32_t heightmapHeight,
+                               uint32_t componentsMask, float minAltitude, float maxAltitude,
+                               float width, float height, float maxError,
+                               BaseMesh::MeshGroup & meshGroup);
+  bool GenerateAdaptiveTerrain(std::vector<uint16_t> const & heightmap,
+                               uint32_t heightmapWidth, uint32_t heightmapHeight,
+                               uint32_t componentsMask, float minAltitude, float maxAltitude,
+                               float width, float height, float maxError,
+                               BaseMesh::MeshGroup & meshGroup);
   bool GenerateTerrain(std::vector<glm::vec3> const & inputPositions,
                        std::vector<glm::vec2> const & borders, uint32_t componentsMask,
                        BaseMesh::MeshGroup & meshGroup);
+  // Splits the points into tiles of about tileSize x tileSize, which are triangulated and
+  // simplified (up to maxError) in parallel. Neighbouring tiles share the vertices on the seams,
+  // their altitudes are interpolated over the points on both sides and refined up to maxError.
+  // Every tile is a separate group, so the tiles can be culled independently.
+  bool GenerateTiledTerrain(std::vector<glm::vec3> const & inputPositions, float tileSize,
+                            float maxError, uint32_t componentsMask,
+                            std::vector<BaseMesh::MeshGroup> & meshGroups);
 };
 }  // namespace rf
@@ -74,6 +74,7 @@ class MeshSimplifier
     bool m_isDeleted = false;
     bool m_isDirty = false;
     glm::vec3 m_normal;
+    uint32_t m_originalIndex = 0;
   };
 
   struct Vertex
@@ -82,7 +83,13 @@ class MeshSimplifier
     uint32_t m_startTriangleRef = 0;
     uint32_t m_triangleRefsCount = 0;
     SymmetricMatrix m_quadrics;
+    // Quadrics of unit planes, sqrt of their error bounds the distance to the original planes.
+    SymmetricMatrix m_planeQuadrics;
+    // Accumulated geometric error of the vertex in world units.
+    double m_error = 0.0;
     bool m_isBorder = false;
+    // Locked vertices are never moved or removed.
+    bool m_isLocked = false;
   };
 
   struct Ref
@@ -98,6 +105,24 @@ public:
     std::vector<uint32_t> m_indices;
   };
 
+  struct SimplificationError
+  {
+    double m_maxDeviation = 0.0;
+    double m_meanDeviation = 0.0;
+  };
+
+  // Edge collapse in terms of the original vertices and triangles.
+  struct Collapse
+  {
+    uint32_t m_keptVertex = 0;
+    uint32_t m_removedVertex = 0;
+    glm::vec3 m_keptPosition;
+    glm::vec3 m_newPosition;
+    std::vector<uint32_t> m_removedTriangles;
+    // Corners (triangle * 3 + vertex) which are switched from the removed vertex to the kept one.
+    std::vector<uint32_t> m_changedCorners;
+  };
+
   explicit MeshSimplifier(MeshData const & meshData)
   {
     m_vertices.resize(meshData.m_positions.size());
@@ -108,6 +133,7 @@ public:
     for (uint32_t i = 0; i < static_cast<uint32_t>(m_triangles.size()); ++i)
     {
       auto & t = m_triangles[i];
+      t.m_originalIndex = i;
       glm::vec3 p[3];
       for (uint32_t j = 0; j < 3; ++j)
       {
@@ -119,6 +145,13 @@ public:
       t.m_normal = glm::normalize(n);
       for (uint32_t j = 0; j < 3; ++j)
         m_vertices[t.m_indices[j]].m_quadrics += SymmetricMatrix(n.x, n.y, n.z, glm::dot(-n, p[0]));
+
+      auto const & un = t.m_normal;
+      for (uint32_t j = 0; j < 3; ++j)
+      {
+        m_vertices[t.m_indices[j]].m_planeQuadrics +=
+            SymmetricMatrix(un.x, un.y, un.z, glm::dot(-un, p[0]));
+      }
     }
 
     for (auto & t : m_triangles)
@@ -169,6 +202,29 @@ public:
           m_vertices[vids[j]].m_isBorder = true;
       }
     }
+
+    // Constrain border edges with perpendicular planes, so the geometric error accounts for
+    // the boundary shrinking.
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_triangles.size()); ++i)
+    {
+      auto const & t = m_triangles[i];
+      for (uint32_t j = 0; j < 3; ++j)
+      {
+        auto const i0 = t.m_indices[j];
+        auto const i1 = t.m_indices[(j + 1) % 3];
+        if (!m_vertices[i0].m_isBorder || !m_vertices[i1].m_isBorder || !IsBorderEdge(i0, i1))
+          continue;
+
+        auto const & p0 = m_vertices[i0].m_position;
+        auto const n = glm::cross(m_vertices[i1].m_position - p0, t.m_normal);
+        if (glm::length(n) < kEps)
+          continue;
+        auto const un = glm::normalize(n);
+        SymmetricMatrix const q(un.x, un.y, un.z, glm::dot(-un, p0));
+        m_vertices[i0].m_planeQuadrics += q;
+        m_vertices[i1].m_planeQuadrics += q;
+      }
+    }
   }
 
   MeshData Simplify(int targetCount, double aggressiveness = 7.0, uint32_t maxIterationsCount = 1000)
@@ -206,8 +262,73 @@ public:
     return BuildMeshData();
   }
 
+  // Simplifies the mesh until any further edge collapse would move the surface more than
+  // maxDeviation (in world units) away from the original vertices. The achieved maximum and mean
+  // distances from the original vertices to the simplified surface are returned in error.
+  MeshData SimplifyWithErrorBound(double maxDeviation, SimplificationError & error,
+                                  double aggressiveness = 7.0, uint32_t maxIterationsCount = 1000)
+  {
+    for (auto & t : m_triangles)
+      t.m_isDeleted = false;
+
+    std::vector<glm::vec3> originalPositions(m_vertices.size());
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_vertices.size()); ++i)
+      originalPositions[i] = m_vertices[i].m_position;
+
+    uint32_t deletedTriangles = 0;
+    for (uint32_t iteration = 0; iteration < maxIterationsCount; ++iteration)
+    {
+      double const threshold = 0.000000001 * pow(double(iteration + 3), aggressiveness);
+      auto const lastDeletedTriangles = deletedTriangles;
+      CollapseEdges(threshold, deletedTriangles, maxDeviation);
+
+      // Stop when every remaining edge has been tried and rejected by the error bound.
+      if (deletedTriangles == lastDeletedTriangles)
+      {
+        double maxEdgeError = 0.0;
+        for (auto const & t : m_triangles)
+        {
+          if (!t.m_isDeleted)
+            maxEdgeError = std::max(maxEdgeError, t.m_errors[3]);
+        }
+        if (threshold >= maxEdgeError)
+          break;
+      }
+    }
+
+    CompactMesh();
+    error = CalculateDeviation(originalPositions);
+    return BuildMeshData();
+  }
+
+  // Keeps the vertices untouched, e.g. on the seams between separately simplified parts of a mesh.
+  void LockVertices(std::vector<uint32_t> const & vertices)
+  {
+    for (auto const v : vertices)
+      m_vertices[v].m_isLocked = true;
+  }
+
+  // Enables recording of the edge collapses (see GetCollapses), e.g. to build a progressive mesh.
+  void SetCollapsesRecording(bool enabled)
+  {
+    m_isRecordingCollapses = enabled;
+    m_collapses.clear();
+  }
+
+  std::vector<Collapse> const & GetCollapses() const { return m_collapses; }
+
+  // Returns the distance from which a simplification error (in world units) is projected to
+  // less than maxScreenError pixels on the screen.
+  static float CalculateLodDistance(double deviation, float fov, uint32_t screenHeight,
+                                    float maxScreenError = 1.0f)
+  {
+    return static_cast<float>(deviation) * screenHeight /
+           (2.0f * tan(fov * 0.5f) * maxScreenError);
+  }
+
 private:
-  void CollapseEdges(double threshold, uint32_t & deletedTriangles)
+  void CollapseEdges(double threshold, uint32_t & deletedTriangles,
+                     double maxDeviation = std::numeric_limits<double>::max())
   {
     std::vector<bool> deleted0, deleted1;
 
@@ -232,23 +353,43 @@ private:
         auto & v1 = m_vertices[i1];
 
         // Border check.
-        if (v0.m_isBorder != v1.m_isBorder)
+        if (v0.m_isBorder != v1.m_isBorder || v0.m_isLocked || v1.m_isLocked)
           continue;
 
         // Compute vertex to collapse to.
         glm::vec3 p;
         CalculateEdgeError(i0, i1, p);
+
+        // Error bound check.
+        auto const planeQuadrics = v0.m_planeQuadrics + v1.m_planeQuadrics;
+        auto const error = std::max(std::max(v0.m_error, v1.m_error),
+                                    sqrt(std::max(CalculateVertexError(planeQuadrics, p), 0.0)));
+        if (error > maxDeviation)
+          continue;
+
         deleted0.resize(v0.m_triangleRefsCount);
         deleted1.resize(v1.m_triangleRefsCount);
         if (IsFlipped(p, i0, i1, v0, v1, deleted0) || IsFlipped(p, i1, i0, v1, v0, deleted1))
           continue;
 
+        Collapse * collapse = nullptr;
+        if (m_isRecordingCollapses)
+        {
+          collapse = &m_collapses.emplace_back();
+          collapse->m_keptVertex = i0;
+          collapse->m_removedVertex = i1;
+          collapse->m_keptPosition = v0.m_position;
+          collapse->m_newPosition = p;
+        }
+
         v0.m_position = p;
         v0.m_quadrics += v1.m_quadrics;
+        v0.m_planeQuadrics = planeQuadrics;
+        v0.m_error = error;
         auto const startTriangleRef = static_cast<uint32_t>(m_refs.size());
 
-        UpdateTriangles(i0, v0, deleted0, deletedTriangles);
-        UpdateTriangles(i0, v1, deleted1, deletedTriangles);
+        UpdateTriangles(i0, v0, deleted0, deletedTriangles, collapse);
+        UpdateTriangles(i0, v1, deleted1, deletedTriangles, collapse);
 
         auto const triangleRefsCount = static_cast<uint32_t>(m_refs.size()) - startTriangleRef;
         if (triangleRefsCount <= v0.m_triangleRefsCount)
@@ -283,6 +424,20 @@ private:
     return meshData;
   }
 
+  // Check if only one triangle shares the edge.
+  bool IsBorderEdge(uint32_t i0, uint32_t i1) const
+  {
+    auto const & v = m_vertices[i0];
+    uint32_t count = 0;
+    for (uint32_t k = 0; k < v.m_triangleRefsCount; ++k)
+    {
+      auto const & t = m_triangles[m_refs[v.m_startTriangleRef + k].m_triangleIndex];
+      if (t.m_indices[0] == i1 || t.m_indices[1] == i1 || t.m_indices[2] == i1)
+        count++;
+    }
+    return count == 1;
+  }
+
   // Check if a triangle flips when this edge is removed.
   bool IsFlipped(glm::vec3 const & p, int i0, int i1, Vertex & v0, Vertex & v1,
                  std::vector<bool> & deleted) const
@@ -318,7 +473,7 @@ private:
 
   // Update triangle connections and edge error after an edge is collapsed.
   void UpdateTriangles(uint32_t i0, Vertex & v, std::vector<bool> & deleted,
-                       uint32_t & deletedTriangles)
+                       uint32_t & deletedTriangles, Collapse * collapse)
   {
     glm::vec3 p;
     for (uint32_t k = 0; k < v.m_triangleRefsCount; ++k)
@@ -332,8 +487,12 @@ private:
       {
         t.m_isDeleted = true;
         deletedTriangles++;
+        if (collapse != nullptr)
+          collapse->m_removedTriangles.push_back(t.m_originalIndex);
         continue;
       }
+      if (collapse != nullptr && t.m_indices[r.m_triangleVertex] != i0)
+        collapse->m_changedCorners.push_back(t.m_originalIndex * 3 + r.m_triangleVertex);
       t.m_indices[r.m_triangleVertex] = i0;
       t.m_isDirty = true;
       t.m_errors[0] = CalculateEdgeError(t.m_indices[0], t.m_indices[1], p);
@@ -426,6 +585,170 @@ private:
     m_vertices.resize(dst);
   }
 
+  // Measure distances from the original vertices to the simplified surface. Triangles are
+  // bucketed into a uniform grid, which is searched in growing rings around every vertex.
+  SimplificationError CalculateDeviation(std::vector<glm::vec3> const & originalPositions) const
+  {
+    SimplificationError result;
+    if (originalPositions.empty() || m_triangles.empty())
+      return result;
+
+    AABB box;
+    for (auto const & p : originalPositions)
+      box.extend(p);
+    for (auto const & t : m_triangles)
+    {
+      for (auto const index : t.m_indices)
+        box.extend(m_vertices[index].m_position);
+    }
+
+    auto const boxMin = box.getMin();
+    auto const diagonal = box.getMax() - boxMin;
+    auto const extent = std::max(diagonal.x, std::max(diagonal.y, diagonal.z));
+    auto const cellsPerAxis = static_cast<int>(
+        glm::clamp(cbrt(static_cast<double>(m_triangles.size())), 1.0, 256.0));
+    auto const cellSize = std::max(extent / cellsPerAxis, kEps);
+    glm::ivec3 gridSize;
+    for (int i = 0; i < 3; ++i)
+      gridSize[i] = std::max(static_cast<int>(ceil(diagonal[i] / cellSize)), 1);
+
+    auto const toCell = [&](glm::vec3 const & p)
+    {
+      glm::ivec3 cell;
+      for (int i = 0; i < 3; ++i)
+        cell[i] = glm::clamp(static_cast<int>((p[i] - boxMin[i]) / cellSize), 0, gridSize[i] - 1);
+      return cell;
+    };
+    auto const toIndex = [&gridSize](int x, int y, int z)
+    {
+      return (static_cast<size_t>(z) * gridSize.y + y) * gridSize.x + x;
+    };
+
+    // Build cells (counting sort of triangles by the cells their bounding boxes overlap).
+    auto const cellsCount = static_cast<size_t>(gridSize.x) * gridSize.y * gridSize.z;
+    std::vector<uint32_t> cellStarts(cellsCount + 1, 0);
+    std::vector<uint32_t> cellTriangles;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+      for (uint32_t i = 0; i < static_cast<uint32_t>(m_triangles.size()); ++i)
+      {
+        auto const & t = m_triangles[i];
+        auto const & p0 = m_vertices[t.m_indices[0]].m_position;
+        auto const & p1 = m_vertices[t.m_indices[1]].m_position;
+        auto const & p2 = m_vertices[t.m_indices[2]].m_position;
+        auto const c0 = toCell(glm::min(p0, glm::min(p1, p2)));
+        auto const c1 = toCell(glm::max(p0, glm::max(p1, p2)));
+        for (int z = c0.z; z <= c1.z; ++z)
+        {
+          for (int y = c0.y; y <= c1.y; ++y)
+          {
+            for (int x = c0.x; x <= c1.x; ++x)
+            {
+              if (pass == 0)
+                cellStarts[toIndex(x, y, z) + 1]++;
+              else
+                cellTriangles[cellStarts[toIndex(x, y, z)]++] = i;
+            }
+          }
+        }
+      }
+
+      if (pass == 0)
+      {
+        for (size_t i = 1; i < cellStarts.size(); ++i)
+          cellStarts[i] += cellStarts[i - 1];
+        cellTriangles.resize(cellStarts.back());
+      }
+      else
+      {
+        // Starts were shifted by the second pass, restore them.
+        for (size_t i = cellsCount; i > 0; --i)
+          cellStarts[i] = cellStarts[i - 1];
+        cellStarts[0] = 0;
+      }
+    }
+
+    auto const maxRing = std::max(gridSize.x, std::max(gridSize.y, gridSize.z));
+    for (auto const & p : originalPositions)
+    {
+      auto const cell = toCell(p);
+      auto deviation = std::numeric_limits<double>::max();
+      for (int ring = 0; ring <= maxRing; ++ring)
+      {
+        for (int z = std::max(cell.z - ring, 0); z <= std::min(cell.z + ring, gridSize.z - 1); ++z)
+        {
+          for (int y = std::max(cell.y - ring, 0); y <= std::min(cell.y + ring, gridSize.y - 1); ++y)
+          {
+            for (int x = std::max(cell.x - ring, 0); x <= std::min(cell.x + ring, gridSize.x - 1); ++x)
+            {
+              // Visit only the cells of the current ring.
+              if (std::max(abs(x - cell.x), std::max(abs(y - cell.y), abs(z - cell.z))) != ring)
+                continue;
+
+              auto const index = toIndex(x, y, z);
+              for (auto k = cellStarts[index]; k < cellStarts[index + 1]; ++k)
+              {
+                auto const & t = m_triangles[cellTriangles[k]];
+                deviation = std::min(deviation, CalculateDistanceToTriangle(
+                                                    p, m_vertices[t.m_indices[0]].m_position,
+                                                    m_vertices[t.m_indices[1]].m_position,
+                                                    m_vertices[t.m_indices[2]].m_position));
+              }
+            }
+          }
+        }
+
+        // Everything beyond the ring is farther than the found triangle.
+        if (deviation <= ring * cellSize)
+          break;
+      }
+      result.m_maxDeviation = std::max(result.m_maxDeviation, deviation);
+      result.m_meanDeviation += deviation;
+    }
+    result.m_meanDeviation /= originalPositions.size();
+    return result;
+  }
+
+  // Distance between a point and a triangle (closest point search by Voronoi regions).
+  static double CalculateDistanceToTriangle(glm::vec3 const & p, glm::vec3 const & a,
+                                            glm::vec3 const & b, glm::vec3 const & c)
+  {
+    auto const ab = b - a;
+    auto const ac = c - a;
+    auto const ap = p - a;
+    auto const d1 = glm::dot(ab, ap);
+    auto const d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+      return glm::distance(p, a);
+
+    auto const bp = p - b;
+    auto const d3 = glm::dot(ab, bp);
+    auto const d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+      return glm::distance(p, b);
+
+    auto const vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+      return glm::distance(p, a + ab * (d1 / (d1 - d3)));
+
+    auto const cp = p - c;
+    auto const d5 = glm::dot(ab, cp);
+    auto const d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+      return glm::distance(p, c);
+
+    auto const vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+      return glm::distance(p, a + ac * (d2 / (d2 - d6)));
+
+    auto const va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+      return glm::distance(p, b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+
+    auto const denom = 1.0f / (va + vb + vc);
+    return glm::distance(p, a + ab * (vb * denom) + ac * (vc * denom));
+  }
+
   // Calculate error between vertex and quadric.
   double CalculateVertexError(SymmetricMatrix const & q, glm::vec3 const & p) const
   {
@@ -470,5 +793,7 @@ private:
   std::vector<Triangle> m_triangles;
   std::vector<Vertex> m_vertices;
   std::vector<Ref> m_refs;
+  std::vector<Collapse> m_collapses;
+  bool m_isRecordingCollapses = false;
 };
 }  // namespace rf
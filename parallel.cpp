@@ -0,0 +1,127 @@
+#include "parallel.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace rf
+{
+namespace
+{
+// Set on the workers and on the thread which runs a job, the nested calls are serial.
+thread_local bool t_insideParallelFor = false;
+
+// Threads are started once and sleep between the jobs, so ParallelFor doesn't pay for creating
+// them and their thread_local scratch buffers survive between the calls.
+class WorkersPool
+{
+public:
+  explicit WorkersPool(uint32_t threadsCount)
+  {
+    m_threads.reserve(threadsCount);
+    for (uint32_t i = 0; i < threadsCount; ++i)
+      m_threads.emplace_back(&WorkersPool::Worker, this);
+  }
+
+  ~WorkersPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_jobCondition.notify_all();
+    for (auto & t : m_threads)
+      t.join();
+  }
+
+  // Jobs of several threads are run one by one.
+  void Run(uint32_t count, std::function<void(uint32_t index)> const & func)
+  {
+    std::lock_guard<std::mutex> runLock(m_runMutex);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_func = &func;
+      m_count = count;
+      m_nextIndex = 0;
+      m_jobIndex++;
+    }
+    m_jobCondition.notify_all();
+
+    Process(func, count);
+
+    // The workers which haven't taken the job yet skip it.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_func = nullptr;
+    m_doneCondition.wait(lock, [this]() { return m_activeWorkers == 0; });
+  }
+
+private:
+  void Process(std::function<void(uint32_t index)> const & func, uint32_t count)
+  {
+    for (auto i = m_nextIndex.fetch_add(1); i < count; i = m_nextIndex.fetch_add(1))
+      func(i);
+  }
+
+  void Worker()
+  {
+    t_insideParallelFor = true;
+    uint64_t lastJobIndex = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+      m_jobCondition.wait(lock, [&]() { return m_stop || m_jobIndex != lastJobIndex; });
+      if (m_stop)
+        return;
+
+      lastJobIndex = m_jobIndex;
+      if (m_func == nullptr)
+        continue;
+
+      auto const * func = m_func;
+      auto const count = m_count;
+      m_activeWorkers++;
+      lock.unlock();
+      Process(*func, count);
+      lock.lock();
+      if (--m_activeWorkers == 0)
+        m_doneCondition.notify_all();
+    }
+  }
+
+  std::vector<std::thread> m_threads;
+  std::mutex m_runMutex;
+  std::mutex m_mutex;
+  std::condition_variable m_jobCondition;
+  std::condition_variable m_doneCondition;
+  std::function<void(uint32_t index)> const * m_func = nullptr;
+  uint32_t m_count = 0;
+  std::atomic<uint32_t> m_nextIndex{0};
+  uint64_t m_jobIndex = 0;
+  uint32_t m_activeWorkers = 0;
+  bool m_stop = false;
+};
+}  // namespace
+
+uint32_t GetWorkersCount()
+{
+  static uint32_t const kWorkersCount = std::max(std::thread::hardware_concurrency(), 1u);
+  return kWorkersCount;
+}
+
+void ParallelFor(uint32_t count, std::function<void(uint32_t index)> const & func)
+{
+  if (std::min(GetWorkersCount(), count) <= 1 || t_insideParallelFor)
+  {
+    for (uint32_t i = 0; i < count; ++i)
+      func(i);
+    return;
+  }
+
+  // The calling thread is a worker as well.
+  static WorkersPool pool(GetWorkersCount() - 1);
+  t_insideParallelFor = true;
+  pool.Run(count, func);
+  t_insideParallelFor = false;
+}
+}  // namespace rf
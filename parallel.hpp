@@ -0,0 +1,14 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace rf
+{
+uint32_t GetWorkersCount();
+
+// Calls func for every index in [0, count) on the worker threads and the calling thread.
+// Indices are distributed dynamically, the call returns when all of them are processed.
+// The workers are started by the first call and reused by the next ones. The nested calls are
+// serial, the calls of several threads are run one by one.
+void ParallelFor(uint32_t count, std::function<void(uint32_t index)> const & func);
+}  // namespace rf
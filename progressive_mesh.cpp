@@ -0,0 +1,236 @@
+#include "progressive_mesh.hpp"
+#include "mesh_simplifier.hpp"
+
+#include "logger.hpp"
+
+namespace rf
+{
+namespace
+{
+uint32_t constexpr kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+glm::vec3 * GetPositions(BaseMesh::MeshGroup & meshGroup)
+{
+  auto it = meshGroup.m_vertexBuffers.find(MeshVertexAttribute::Position);
+  if (it == meshGroup.m_vertexBuffers.end())
+    return nullptr;
+  return reinterpret_cast<glm::vec3 *>(it->second.data());
+}
+}  // namespace
+
+bool ProgressiveMesh::Build(BaseMesh::MeshGroup & meshGroup, uint32_t minTrianglesCount,
+                            double aggressiveness)
+{
+  auto const positionsPtr = GetPositions(meshGroup);
+  if (positionsPtr == nullptr || meshGroup.m_indicesCount == 0)
+  {
+    Logger::ToLog(Logger::Error, "Can't build progressive mesh, positions are not found.");
+    return false;
+  }
+
+  auto const verticesCount = meshGroup.m_verticesCount;
+  auto const trianglesCount = meshGroup.m_indicesCount / 3;
+
+  MeshSimplifier::MeshData simplifierData;
+  simplifierData.m_positions.assign(positionsPtr, positionsPtr + verticesCount);
+  simplifierData.m_indices.assign(meshGroup.m_indexBuffer.begin(),
+                                  meshGroup.m_indexBuffer.begin() + meshGroup.m_indicesCount);
+  MeshSimplifier simplifier(simplifierData);
+  simplifier.SetCollapsesRecording(true);
+  simplifier.Simplify(static_cast<int>(minTrianglesCount), aggressiveness);
+  auto const & collapses = simplifier.GetCollapses();
+
+  // Surviving vertices go first, then removed ones in reverse collapse order. So the vertex
+  // removed by the k-th collapse gets the index (verticesCount - 1 - k).
+  std::vector<uint32_t> vertexOrder(verticesCount, kInvalidIndex);
+  for (uint32_t k = 0; k < static_cast<uint32_t>(collapses.size()); ++k)
+    vertexOrder[collapses[k].m_removedVertex] = verticesCount - 1 - k;
+  uint32_t baseVerticesCount = 0;
+  for (auto & index : vertexOrder)
+  {
+    if (index == kInvalidIndex)
+      index = baseVerticesCount++;
+  }
+
+  // The same for triangles.
+  std::vector<uint32_t> triangleOrder(trianglesCount, kInvalidIndex);
+  uint32_t removedTrianglesCount = 0;
+  for (auto const & c : collapses)
+  {
+    for (auto const t : c.m_removedTriangles)
+      triangleOrder[t] = trianglesCount - 1 - (removedTrianglesCount++);
+  }
+  uint32_t baseTrianglesCount = 0;
+  for (auto & index : triangleOrder)
+  {
+    if (index == kInvalidIndex)
+      index = baseTrianglesCount++;
+  }
+
+  // Reorder vertex buffers.
+  for (auto & [attr, buffer] : meshGroup.m_vertexBuffers)
+  {
+    auto const attrSize = GetAttributeSizeInBytes(attr);
+    ByteArray reordered(buffer.size());
+    for (uint32_t i = 0; i < verticesCount; ++i)
+      memcpy(reordered.data() + vertexOrder[i] * attrSize, buffer.data() + i * attrSize, attrSize);
+    buffer = std::move(reordered);
+  }
+
+  // Reorder index buffer.
+  IndexBuffer32 indices(static_cast<size_t>(trianglesCount) * 3);
+  for (uint32_t i = 0; i < trianglesCount; ++i)
+  {
+    for (uint32_t j = 0; j < 3; ++j)
+      indices[triangleOrder[i] * 3 + j] = vertexOrder[meshGroup.m_indexBuffer[i * 3 + j]];
+  }
+  meshGroup.m_indexBuffer = std::move(indices);
+
+  uint32_t attributesMask = 0;
+  for (auto const & [attr, buffer] : meshGroup.m_vertexBuffers)
+    attributesMask |= attr;
+  auto const otherAttributesMask = attributesMask & ~MeshVertexAttribute::Position;
+
+  // Vertex splits are inverted collapses in reverse order. Collapses are replayed on copies of
+  // the buffers to capture the state of the mesh right before every collapse.
+  auto const positions = GetPositions(meshGroup);
+  std::vector<glm::vec3> currentPositions(positions, positions + verticesCount);
+  IndexBuffer32 currentIndices = meshGroup.m_indexBuffer;
+  m_splits.clear();
+  m_splits.resize(collapses.size());
+  for (uint32_t k = 0; k < static_cast<uint32_t>(collapses.size()); ++k)
+  {
+    auto const & c = collapses[k];
+    auto & split = m_splits[collapses.size() - 1 - k];
+    split.m_vertex = vertexOrder[c.m_keptVertex];
+    split.m_collapsedPosition = c.m_newPosition;
+    split.m_position = c.m_keptPosition;
+    split.m_newVertexPosition = currentPositions[vertexOrder[c.m_removedVertex]];
+
+    // Only the positions are changed by the collapses.
+    split.m_attributesMask = attributesMask;
+    split.m_newVertexAttributes.resize(GetVertexSizeInBytes(otherAttributesMask));
+    ForEachAttribute(otherAttributesMask, [&](MeshVertexAttribute attr)
+    {
+      auto const attrSize = GetAttributeSizeInBytes(attr);
+      memcpy(split.m_newVertexAttributes.data() +
+             GetAttributeOffsetInBytes(otherAttributesMask, attr),
+             meshGroup.m_vertexBuffers[attr].data() + vertexOrder[c.m_removedVertex] * attrSize,
+             attrSize);
+    });
+
+    // Triangles are restored in the order of the index buffer.
+    std::vector<uint32_t> triangles;
+    triangles.reserve(c.m_removedTriangles.size());
+    for (auto const t : c.m_removedTriangles)
+      triangles.push_back(triangleOrder[t]);
+    std::sort(triangles.begin(), triangles.end());
+    for (auto const t : triangles)
+    {
+      for (uint32_t j = 0; j < 3; ++j)
+        split.m_triangles.push_back(currentIndices[t * 3 + j]);
+    }
+
+    split.m_corners.reserve(c.m_changedCorners.size());
+    for (auto const corner : c.m_changedCorners)
+    {
+      auto const index = triangleOrder[corner / 3] * 3 + corner % 3;
+      split.m_corners.push_back(index);
+      currentIndices[index] = split.m_vertex;
+    }
+    currentPositions[split.m_vertex] = c.m_newPosition;
+  }
+
+  m_baseVerticesCount = baseVerticesCount;
+  m_baseTrianglesCount = baseTrianglesCount;
+  m_level = static_cast<uint32_t>(m_splits.size());
+  return true;
+}
+
+void ProgressiveMesh::SetVertexSplits(std::vector<VertexSplit> && splits,
+                                      uint32_t baseVerticesCount, uint32_t baseTrianglesCount)
+{
+  m_splits = std::move(splits);
+  m_baseVerticesCount = baseVerticesCount;
+  m_baseTrianglesCount = baseTrianglesCount;
+  m_level = 0;
+}
+
+bool ProgressiveMesh::Refine(BaseMesh::MeshGroup & meshGroup)
+{
+  if (m_level >= m_splits.size())
+    return false;
+
+  auto const & split = m_splits[m_level];
+  auto const newVertex = m_baseVerticesCount + m_level;
+  auto const otherAttributesMask = split.m_attributesMask & ~MeshVertexAttribute::Position;
+  if (split.m_newVertexAttributes.size() < GetVertexSizeInBytes(otherAttributesMask))
+  {
+    Logger::ToLog(Logger::Error, "Can't refine progressive mesh, vertex split is corrupted.");
+    return false;
+  }
+
+  // Buffers may contain only the base mesh while the rest is streamed.
+  auto & positionsBuffer = meshGroup.m_vertexBuffers[MeshVertexAttribute::Position];
+  if (positionsBuffer.size() < (newVertex + 1) * sizeof(glm::vec3))
+    positionsBuffer.resize((newVertex + 1) * sizeof(glm::vec3));
+  auto const requiredIndices = meshGroup.m_indicesCount + split.m_triangles.size();
+  if (meshGroup.m_indexBuffer.size() < requiredIndices)
+    meshGroup.m_indexBuffer.resize(requiredIndices);
+
+  auto positions = reinterpret_cast<glm::vec3 *>(positionsBuffer.data());
+  positions[newVertex] = split.m_newVertexPosition;
+  positions[split.m_vertex] = split.m_position;
+
+  ForEachAttribute(otherAttributesMask, [&](MeshVertexAttribute attr)
+  {
+    auto const attrSize = GetAttributeSizeInBytes(attr);
+    auto & buffer = meshGroup.m_vertexBuffers[attr];
+    if (buffer.size() < (newVertex + 1) * attrSize)
+      buffer.resize((newVertex + 1) * attrSize);
+    auto const offset = GetAttributeOffsetInBytes(otherAttributesMask, attr);
+    memcpy(buffer.data() + newVertex * attrSize, split.m_newVertexAttributes.data() + offset,
+           attrSize);
+  });
+
+  memcpy(meshGroup.m_indexBuffer.data() + meshGroup.m_indicesCount, split.m_triangles.data(),
+         split.m_triangles.size() * sizeof(uint32_t));
+  for (auto const corner : split.m_corners)
+    meshGroup.m_indexBuffer[corner] = newVertex;
+
+  meshGroup.m_indicesCount += static_cast<uint32_t>(split.m_triangles.size());
+  meshGroup.m_verticesCount = newVertex + 1;
+  m_level++;
+  return true;
+}
+
+bool ProgressiveMesh::Coarsen(BaseMesh::MeshGroup & meshGroup)
+{
+  if (m_level == 0)
+    return false;
+
+  m_level--;
+  auto const & split = m_splits[m_level];
+  for (auto const corner : split.m_corners)
+    meshGroup.m_indexBuffer[corner] = split.m_vertex;
+
+  auto positions = GetPositions(meshGroup);
+  positions[split.m_vertex] = split.m_collapsedPosition;
+
+  meshGroup.m_indicesCount -= static_cast<uint32_t>(split.m_triangles.size());
+  meshGroup.m_verticesCount = m_baseVerticesCount + m_level;
+  return true;
+}
+
+void ProgressiveMesh::SetTrianglesCount(BaseMesh::MeshGroup & meshGroup, uint32_t trianglesCount)
+{
+  while (meshGroup.m_indicesCount > trianglesCount * 3 && Coarsen(meshGroup))
+  {}
+
+  while (m_level < m_splits.size() &&
+         meshGroup.m_indicesCount + m_splits[m_level].m_triangles.size() <= trianglesCount * 3)
+  {
+    Refine(meshGroup);
+  }
+}
+}  // namespace rf
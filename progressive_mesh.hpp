@@ -0,0 +1,62 @@
+#pragma once
+
+#include "common.hpp"
+#include "base_mesh.hpp"
+
+namespace rf
+{
+// Progressive mesh (H. Hoppe) built from the edge collapses of MeshSimplifier. Vertices and
+// triangles of a mesh group are reordered so that any level of detail is a prefix of the
+// group buffers, and switching between neighbouring levels touches only a few indices.
+class ProgressiveMesh
+{
+public:
+  // Refinement record. Applied to a mesh with V vertices, it adds the vertex V.
+  struct VertexSplit
+  {
+    // The vertex which is split.
+    uint32_t m_vertex = 0;
+    // Positions of the split vertex before and after the refinement.
+    glm::vec3 m_collapsedPosition;
+    glm::vec3 m_position;
+    glm::vec3 m_newVertexPosition;
+    // Attributes of the group. The other attributes of the split vertex don't change, the ones
+    // of the new vertex besides the position are interleaved in m_newVertexAttributes in the
+    // order of GetAttributeOffsetInBytes(m_attributesMask & ~Position).
+    uint32_t m_attributesMask = MeshVertexAttribute::Position;
+    ByteArray m_newVertexAttributes;
+    // Indices of the restored triangles, they are appended to the index buffer.
+    std::vector<uint32_t> m_triangles;
+    // Offsets in the index buffer, which are switched from m_vertex to the new vertex.
+    std::vector<uint32_t> m_corners;
+  };
+
+  // Simplifies the group down to minTrianglesCount and reorders its buffers. The group stays
+  // at the full level of detail.
+  bool Build(BaseMesh::MeshGroup & meshGroup, uint32_t minTrianglesCount = 0,
+             double aggressiveness = 7.0);
+
+  // Refines or coarsens the group buffers in place up to the nearest level with no more than
+  // trianglesCount triangles. The cost is proportional to the number of changed levels.
+  void SetTrianglesCount(BaseMesh::MeshGroup & meshGroup, uint32_t trianglesCount);
+  bool Refine(BaseMesh::MeshGroup & meshGroup);
+  bool Coarsen(BaseMesh::MeshGroup & meshGroup);
+
+  // Levels are counted in vertex splits applied to the base mesh.
+  uint32_t GetLevel() const { return m_level; }
+  uint32_t GetLevelsCount() const { return static_cast<uint32_t>(m_splits.size()); }
+  uint32_t GetBaseVerticesCount() const { return m_baseVerticesCount; }
+  uint32_t GetBaseTrianglesCount() const { return m_baseTrianglesCount; }
+
+  // Streaming order: the base mesh is the prefix of the buffers at level 0, splits follow.
+  std::vector<VertexSplit> const & GetVertexSplits() const { return m_splits; }
+  void SetVertexSplits(std::vector<VertexSplit> && splits, uint32_t baseVerticesCount,
+                       uint32_t baseTrianglesCount);
+
+private:
+  std::vector<VertexSplit> m_splits;
+  uint32_t m_level = 0;
+  uint32_t m_baseVerticesCount = 0;
+  uint32_t m_baseTrianglesCount = 0;
+};
+}  // namespace rf
@@ -2,15 +2,21 @@
 
 #include "common.hpp"
 
+#include "animation.hpp"
+#include "animation_lod.hpp"
 #include "base_mesh.hpp"
 #include "camera.hpp"
 #include "free_camera.hpp"
 #include "logger.hpp"
+#include "skinning.hpp"
+#include "terrain_quadtree.hpp"
 #include "window.hpp"
 
 #ifdef API_OPENGL
 #include "gl/gpu_program.hpp"
+#include "gl/instanced_terrain.hpp"
 #include "gl/mesh.hpp"
+#include "gl/skinning.hpp"
 #include "gl/texture.hpp"
 #endif
 
@@ -0,0 +1,187 @@
+#include "rtin.hpp"
+
+#include "logger.hpp"
+
+namespace rf
+{
+namespace
+{
+// Triangles partially out of the heightmap are always subdivided, so the finest ones can be
+// dropped without holes.
+uint16_t constexpr kForcedError = std::numeric_limits<uint16_t>::max();
+
+struct Triangle
+{
+  uint32_t m_ax, m_ay;
+  uint32_t m_bx, m_by;
+  // The vertex with the right angle.
+  uint32_t m_cx, m_cy;
+};
+
+// The triangle of the binary tree with the given id. The lowest bit selects the root triangle,
+// the next bits select the halves down the tree, the highest one marks the depth. So children
+// always have bigger ids than their parent.
+Triangle GetTriangle(uint32_t id, uint32_t tileSize)
+{
+  Triangle t = {};
+  if (id & 1)
+    t.m_bx = t.m_by = t.m_cx = tileSize;
+  else
+    t.m_ax = t.m_ay = t.m_cy = tileSize;
+
+  while ((id >>= 1) > 1)
+  {
+    auto const mx = (t.m_ax + t.m_bx) >> 1;
+    auto const my = (t.m_ay + t.m_by) >> 1;
+    if (id & 1)
+    {
+      t.m_bx = t.m_ax;
+      t.m_by = t.m_ay;
+      t.m_ax = t.m_cx;
+      t.m_ay = t.m_cy;
+    }
+    else
+    {
+      t.m_ax = t.m_bx;
+      t.m_ay = t.m_by;
+      t.m_bx = t.m_cx;
+      t.m_by = t.m_cy;
+    }
+    t.m_cx = mx;
+    t.m_cy = my;
+  }
+  return t;
+}
+}  // namespace
+
+bool Rtin::Initialize(std::vector<uint8_t> const & heightmap, uint32_t width, uint32_t height)
+{
+  // Half units, so the interpolated heights are exact.
+  return InitializeErrors(heightmap, width, height, 2);
+}
+
+bool Rtin::Initialize(std::vector<uint16_t> const & heightmap, uint32_t width, uint32_t height)
+{
+  return InitializeErrors(heightmap, width, height, 1);
+}
+
+template <typename T>
+bool Rtin::InitializeErrors(std::vector<T> const & heightmap, uint32_t width, uint32_t height,
+                            uint32_t errorScale)
+{
+  if (width < 2 || height < 2 || heightmap.size() < static_cast<size_t>(width) * height)
+  {
+    Logger::ToLog(Logger::Error, "Can't initialize RTIN, heightmap is invalid.");
+    return false;
+  }
+
+  m_width = width;
+  m_height = height;
+  m_errorScale = errorScale;
+  uint32_t tileSize = 1;
+  while (tileSize < std::max(width, height) - 1)
+    tileSize *= 2;
+  m_gridSize = tileSize + 1;
+  m_errors.assign(static_cast<size_t>(m_gridSize) * m_gridSize, 0);
+
+  auto getHeight = [&heightmap, width](uint32_t x, uint32_t y)
+  {
+    return static_cast<int>(heightmap[static_cast<size_t>(y) * width + x]);
+  };
+
+  // Children have bigger ids, so their errors are known when the parent is processed.
+  uint32_t const trianglesCount = tileSize * tileSize * 2 - 2;
+  uint32_t const parentTrianglesCount = trianglesCount - tileSize * tileSize;
+  for (uint32_t i = trianglesCount; i-- > 0;)
+  {
+    auto const t = GetTriangle(i + 2, tileSize);
+    if (std::min({t.m_ax, t.m_bx, t.m_cx}) >= width || std::min({t.m_ay, t.m_by, t.m_cy}) >= height)
+      continue;
+
+    auto const mx = (t.m_ax + t.m_bx) >> 1;
+    auto const my = (t.m_ay + t.m_by) >> 1;
+    uint32_t error = kForcedError;
+    if (!IsOutside(t.m_ax, t.m_ay) && !IsOutside(t.m_bx, t.m_by) && !IsOutside(t.m_cx, t.m_cy))
+    {
+      // The doubled error, rounded up to the error units.
+      auto const doubledError = abs(getHeight(t.m_ax, t.m_ay) + getHeight(t.m_bx, t.m_by) -
+                                    2 * getHeight(mx, my));
+      error = (static_cast<uint32_t>(doubledError) * errorScale + 1) / 2;
+
+      // Surfaces of the children differ from the surface of the triangle by the midpoint error
+      // at most, so the sum bounds the error of every sample inside the triangle.
+      if (i < parentTrianglesCount)
+      {
+        auto const leftIndex = ((t.m_ay + t.m_cy) >> 1) * m_gridSize + ((t.m_ax + t.m_cx) >> 1);
+        auto const rightIndex = ((t.m_by + t.m_cy) >> 1) * m_gridSize + ((t.m_bx + t.m_cx) >> 1);
+        error += std::max(m_errors[leftIndex], m_errors[rightIndex]);
+      }
+      error = std::min(error, static_cast<uint32_t>(kForcedError));
+    }
+
+    // The error of the diamond formed by 2 triangles with the same hypotenuse.
+    auto & middleError = m_errors[my * m_gridSize + mx];
+    middleError = std::max(middleError, static_cast<uint16_t>(error));
+  }
+  return true;
+}
+
+void Rtin::Triangulate(float maxError, std::vector<uint32_t> & vertices,
+                       std::vector<uint32_t> & indices) const
+{
+  vertices.clear();
+  indices.clear();
+  if (m_gridSize == 0)
+    return;
+
+  auto const threshold = std::min(maxError * m_errorScale, static_cast<float>(kForcedError - 1));
+  std::unordered_map<uint32_t, uint32_t> vertexIndices;
+  auto addVertex = [&](uint32_t x, uint32_t y)
+  {
+    auto const sample = y * m_width + x;
+    auto const it = vertexIndices.emplace(sample, static_cast<uint32_t>(vertices.size()));
+    if (it.second)
+      vertices.push_back(sample);
+    return it.first->second;
+  };
+
+  auto const tileSize = m_gridSize - 1;
+  std::vector<Triangle> stack = {{0, 0, tileSize, tileSize, tileSize, 0},
+                                 {tileSize, tileSize, 0, 0, 0, tileSize}};
+  while (!stack.empty())
+  {
+    auto const t = stack.back();
+    stack.pop_back();
+    if (std::min({t.m_ax, t.m_bx, t.m_cx}) >= m_width ||
+        std::min({t.m_ay, t.m_by, t.m_cy}) >= m_height)
+    {
+      continue;
+    }
+
+    auto const mx = (t.m_ax + t.m_bx) >> 1;
+    auto const my = (t.m_ay + t.m_by) >> 1;
+    bool const isFinest = (t.m_ax > t.m_cx ? t.m_ax - t.m_cx : t.m_cx - t.m_ax) +
+                          (t.m_ay > t.m_cy ? t.m_ay - t.m_cy : t.m_cy - t.m_ay) <= 1;
+    if (!isFinest && m_errors[my * m_gridSize + mx] > threshold)
+    {
+      stack.push_back({t.m_cx, t.m_cy, t.m_ax, t.m_ay, mx, my});
+      stack.push_back({t.m_bx, t.m_by, t.m_cx, t.m_cy, mx, my});
+      continue;
+    }
+
+    if (IsOutside(t.m_ax, t.m_ay) || IsOutside(t.m_bx, t.m_by) || IsOutside(t.m_cx, t.m_cy))
+      continue;
+
+    auto const a = addVertex(t.m_ax, t.m_ay);
+    auto b = addVertex(t.m_bx, t.m_by);
+    auto c = addVertex(t.m_cx, t.m_cy);
+    auto const abx = static_cast<int64_t>(t.m_bx) - t.m_ax;
+    auto const aby = static_cast<int64_t>(t.m_by) - t.m_ay;
+    auto const acx = static_cast<int64_t>(t.m_cx) - t.m_ax;
+    auto const acy = static_cast<int64_t>(t.m_cy) - t.m_ay;
+    if (abx * acy - aby * acx > 0)
+      std::swap(b, c);
+    indices.insert(indices.end(), {a, b, c});
+  }
+}
+}  // namespace rf
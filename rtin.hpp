@@ -0,0 +1,40 @@
+#pragma once
+
+#include "common.hpp"
+
+namespace rf
+{
+// Right-triangulated irregular network over an 8-bit or 16-bit heightmap (W. Evans et al., 1997,
+// the same scheme as in mapbox/martini). Triangles of the binary triangle tree over the
+// (2^k + 1)^2 grid covering the heightmap are subdivided while the vertical error is greater
+// than the threshold, so the mesh is crack-free and adapts to the relief in one pass.
+class Rtin
+{
+public:
+  // Calculates the errors of all the triangles of the tree. The errors grid is the only buffer
+  // proportional to the heightmap size (2 bytes per sample of the covering grid).
+  bool Initialize(std::vector<uint8_t> const & heightmap, uint32_t width, uint32_t height);
+  // Errors of 16-bit heightmaps are rounded up to whole units.
+  bool Initialize(std::vector<uint16_t> const & heightmap, uint32_t width, uint32_t height);
+
+  // maxError is in heightmap units. Vertices are indices of heightmap samples (y * width + x),
+  // triangles have the same orientation as the triangles of MeshGenerator::GeneratePlane.
+  void Triangulate(float maxError, std::vector<uint32_t> & vertices,
+                   std::vector<uint32_t> & indices) const;
+
+private:
+  // errorScale is the number of error units per heightmap unit.
+  template <typename T>
+  bool InitializeErrors(std::vector<T> const & heightmap, uint32_t width, uint32_t height,
+                        uint32_t errorScale);
+  bool IsOutside(uint32_t x, uint32_t y) const { return x >= m_width || y >= m_height; }
+
+  uint32_t m_width = 0;
+  uint32_t m_height = 0;
+  uint32_t m_gridSize = 0;
+  uint32_t m_errorScale = 2;
+  // Upper bounds of the vertical errors of the triangles in error units, stored in the middle
+  // points of the hypotenuses.
+  std::vector<uint16_t> m_errors;
+};
+}  // namespace rf
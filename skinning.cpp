@@ -0,0 +1,133 @@
+#include "skinning.hpp"
+#include "parallel.hpp"
+#include "skinning_avx.hpp"
+
+#if defined(RF_ENABLE_AVX) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace rf
+{
+namespace
+{
+static_assert(kSkinningBonesPerVertex == kMaxBonesPerVertex, "Bones per vertex mismatch.");
+
+uint32_t GetBoneOffset(SkinningData const & data, uint32_t index)
+{
+  return std::min(index, data.m_bonesCount) * kSkinningBoneSize;
+}
+
+void SkinVertex(SkinningData const & data, uint32_t v)
+{
+  float m[kSkinningBoneSize] = {};
+  for (uint32_t k = 0; k < kMaxBonesPerVertex; ++k)
+  {
+    float const w = data.m_boneWeights[v * kMaxBonesPerVertex + k];
+    float const * bone =
+      data.m_bones + GetBoneOffset(data, data.m_boneIndices[v * kMaxBonesPerVertex + k]);
+    for (uint32_t i = 0; i < kSkinningBoneSize; ++i)
+      m[i] += w * bone[i];
+  }
+
+  float const * p = data.m_positions + v * 3;
+  float * outPosition = data.m_outPositions + v * 3;
+  for (uint32_t row = 0; row < 3; ++row)
+  {
+    float const * r = m + row * 4;
+    outPosition[row] = r[0] * p[0] + r[1] * p[1] + r[2] * p[2] + r[3];
+  }
+
+  if (data.m_normals != nullptr)
+  {
+    float const * n = data.m_normals + v * 3;
+    glm::vec3 const r(m[0] * n[0] + m[1] * n[1] + m[2] * n[2],
+                      m[4] * n[0] + m[5] * n[1] + m[6] * n[2],
+                      m[8] * n[0] + m[9] * n[1] + m[10] * n[2]);
+    float const len = glm::length(r);
+    auto const result = len > 0.0f ? r / len : glm::vec3(n[0], n[1], n[2]);
+    float * outNormal = data.m_outNormals + v * 3;
+    outNormal[0] = result.x;
+    outNormal[1] = result.y;
+    outNormal[2] = result.z;
+  }
+}
+
+bool IsAvxSupportedByCpu()
+{
+#if !defined(RF_ENABLE_AVX)
+  return false;
+#elif defined(_MSC_VER)
+  // AVX and OSXSAVE bits, the OS must save the YMM registers as well.
+  int info[4];
+  __cpuid(info, 1);
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+    return false;
+  return (_xgetbv(0) & 0x6) == 0x6;
+#else
+  return __builtin_cpu_supports("avx");
+#endif
+}
+}  // namespace
+
+bool IsAvxSkinningAvailable()
+{
+  static bool const kAvailable = IsAvxSupportedByCpu();
+  return kAvailable;
+}
+
+bool SkinMeshGroup(BaseMesh::MeshGroup const & group,
+                   std::vector<glm::mat4x4> const & bonesTransforms,
+                   std::vector<glm::vec3> & positions, std::vector<glm::vec3> & normals)
+{
+  auto const & buffers = group.m_vertexBuffers;
+  auto const positionsIt = buffers.find(MeshVertexAttribute::Position);
+  auto const indicesIt = buffers.find(MeshVertexAttribute::BoneIndices);
+  auto const weightsIt = buffers.find(MeshVertexAttribute::BoneWeights);
+  if (positionsIt == buffers.end() || indicesIt == buffers.end() || weightsIt == buffers.end())
+  {
+    Logger::ToLog(Logger::Error, "Can't skin mesh group, positions or bones are missing.");
+    return false;
+  }
+
+  auto const verticesCount = group.m_verticesCount;
+  std::vector<float> bones((bonesTransforms.size() + 1) * kSkinningBoneSize);
+  for (size_t i = 0; i < bonesTransforms.size(); ++i)
+    PackMatrix3x4(bonesTransforms[i], bones.data() + i * kSkinningBoneSize);
+  PackMatrix3x4(glm::mat4x4(), bones.data() + bonesTransforms.size() * kSkinningBoneSize);
+
+  SkinningData data;
+  data.m_positions = reinterpret_cast<float const *>(positionsIt->second.data());
+  data.m_boneIndices = reinterpret_cast<uint32_t const *>(indicesIt->second.data());
+  data.m_boneWeights = reinterpret_cast<float const *>(weightsIt->second.data());
+  data.m_bones = bones.data();
+  data.m_bonesCount = static_cast<uint32_t>(bonesTransforms.size());
+
+  positions.resize(verticesCount);
+  data.m_outPositions = reinterpret_cast<float *>(positions.data());
+
+  auto const normalsIt = buffers.find(MeshVertexAttribute::Normal);
+  if (normalsIt != buffers.end())
+  {
+    normals.resize(verticesCount);
+    data.m_normals = reinterpret_cast<float const *>(normalsIt->second.data());
+    data.m_outNormals = reinterpret_cast<float *>(normals.data());
+  }
+  else
+  {
+    normals.clear();
+  }
+
+  uint32_t constexpr kVerticesPerBlock = 4096;
+  ParallelFor((verticesCount + kVerticesPerBlock - 1) / kVerticesPerBlock,
+              [&](uint32_t blockIndex)
+  {
+    uint32_t v = blockIndex * kVerticesPerBlock;
+    uint32_t const endIndex = std::min(v + kVerticesPerBlock, verticesCount);
+    if (IsAvxSkinningAvailable())
+      v = SkinVerticesAvx(data, v, endIndex);
+    for (; v < endIndex; ++v)
+      SkinVertex(data, v);
+  });
+  return true;
+}
+}  // namespace rf
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "base_mesh.hpp"
+
+namespace rf
+{
+// Linear blend skinning on the CPU for picking, skinned bounds and physics proxies. Bones
+// transforms are the ones of BaseMesh::GetBonesTransforms, the vertices with the bone indices out
+// of them are not deformed by those bones. Normals are skinned if the group has them.
+// 8 vertices are processed at once with AVX if the CPU supports it (RF_ENABLE_AVX), large groups
+// are split between the workers.
+bool SkinMeshGroup(BaseMesh::MeshGroup const & group,
+                   std::vector<glm::mat4x4> const & bonesTransforms,
+                   std::vector<glm::vec3> & positions, std::vector<glm::vec3> & normals);
+}  // namespace rf
@@ -0,0 +1,108 @@
+#include "skinning_avx.hpp"
+
+// The file is compiled with AVX by RF_ENABLE_AVX in CMake, the other files are not.
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace rf
+{
+#if defined(__AVX__)
+namespace
+{
+uint32_t GetBoneOffset(SkinningData const & data, uint32_t index)
+{
+  return (index < data.m_bonesCount ? index : data.m_bonesCount) * kSkinningBoneSize;
+}
+
+void Load(float const * p, __m256 & x, __m256 & y, __m256 & z)
+{
+  x = _mm256_set_ps(p[21], p[18], p[15], p[12], p[9], p[6], p[3], p[0]);
+  y = _mm256_set_ps(p[22], p[19], p[16], p[13], p[10], p[7], p[4], p[1]);
+  z = _mm256_set_ps(p[23], p[20], p[17], p[14], p[11], p[8], p[5], p[2]);
+}
+
+void Store(__m256 x, __m256 y, __m256 z, float * p)
+{
+  alignas(32) float out[3][8];
+  _mm256_store_ps(out[0], x);
+  _mm256_store_ps(out[1], y);
+  _mm256_store_ps(out[2], z);
+  for (uint32_t j = 0; j < 8; ++j)
+  {
+    p[j * 3] = out[0][j];
+    p[j * 3 + 1] = out[1][j];
+    p[j * 3 + 2] = out[2][j];
+  }
+}
+
+// 8 vertices in SoA: the blended matrices are built entry by entry, so every entry is a lane.
+void SkinVertices8(SkinningData const & data, uint32_t v)
+{
+  __m256 m[kSkinningBoneSize];
+  for (auto & e : m)
+    e = _mm256_setzero_ps();
+
+  for (uint32_t k = 0; k < kSkinningBonesPerVertex; ++k)
+  {
+    float const * b[8];
+    float w[8];
+    for (uint32_t j = 0; j < 8; ++j)
+    {
+      auto const i = (v + j) * kSkinningBonesPerVertex + k;
+      b[j] = data.m_bones + GetBoneOffset(data, data.m_boneIndices[i]);
+      w[j] = data.m_boneWeights[i];
+    }
+    auto const weights = _mm256_loadu_ps(w);
+    for (uint32_t i = 0; i < kSkinningBoneSize; ++i)
+    {
+      auto const e = _mm256_set_ps(b[7][i], b[6][i], b[5][i], b[4][i],
+                                   b[3][i], b[2][i], b[1][i], b[0][i]);
+      m[i] = _mm256_add_ps(m[i], _mm256_mul_ps(weights, e));
+    }
+  }
+
+  auto transform = [&m](__m256 x, __m256 y, __m256 z, uint32_t row)
+  {
+    auto const r = m + row * 4;
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r[0], x), _mm256_mul_ps(r[1], y)),
+                         _mm256_mul_ps(r[2], z));
+  };
+
+  __m256 x, y, z;
+  Load(data.m_positions + v * 3, x, y, z);
+  Store(_mm256_add_ps(transform(x, y, z, 0), m[3]), _mm256_add_ps(transform(x, y, z, 1), m[7]),
+        _mm256_add_ps(transform(x, y, z, 2), m[11]), data.m_outPositions + v * 3);
+
+  if (data.m_normals != nullptr)
+  {
+    Load(data.m_normals + v * 3, x, y, z);
+    auto const nx = transform(x, y, z, 0);
+    auto const ny = transform(x, y, z, 1);
+    auto const nz = transform(x, y, z, 2);
+    auto const lenSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)),
+                                     _mm256_mul_ps(nz, nz));
+    // Degenerated normals keep the source ones.
+    auto const valid = _mm256_cmp_ps(lenSq, _mm256_setzero_ps(), _CMP_GT_OQ);
+    auto const invLen = _mm256_and_ps(valid, _mm256_div_ps(_mm256_set1_ps(1.0f),
+                                                           _mm256_sqrt_ps(lenSq)));
+    Store(_mm256_blendv_ps(x, _mm256_mul_ps(nx, invLen), valid),
+          _mm256_blendv_ps(y, _mm256_mul_ps(ny, invLen), valid),
+          _mm256_blendv_ps(z, _mm256_mul_ps(nz, invLen), valid), data.m_outNormals + v * 3);
+  }
+}
+}  // namespace
+
+uint32_t SkinVerticesAvx(SkinningData const & data, uint32_t begin, uint32_t end)
+{
+  for (; begin + 8 <= end; begin += 8)
+    SkinVertices8(data, begin);
+  return begin;
+}
+#else
+uint32_t SkinVerticesAvx(SkinningData const &, uint32_t begin, uint32_t)
+{
+  return begin;
+}
+#endif
+}  // namespace rf
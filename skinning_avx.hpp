@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rf
+{
+// Streams of SkinMeshGroup. The AVX kernel is the only code compiled with AVX enabled, so its
+// interface has plain types only: the inline functions of glm and std must not be emitted with
+// AVX instructions, the linker may pick them for the other callers.
+struct SkinningData
+{
+  // xyz triples.
+  float const * m_positions = nullptr;
+  float const * m_normals = nullptr;
+  // 4 per vertex.
+  uint32_t const * m_boneIndices = nullptr;
+  float const * m_boneWeights = nullptr;
+  // Rows of the 3x4 matrices of the bones and the identity one for the invalid indices.
+  float const * m_bones = nullptr;
+  uint32_t m_bonesCount = 0;
+  float * m_outPositions = nullptr;
+  float * m_outNormals = nullptr;
+};
+
+uint32_t constexpr kSkinningBoneSize = 12;
+uint32_t constexpr kSkinningBonesPerVertex = 4;
+
+// True if the AVX kernel is built (RF_ENABLE_AVX) and the CPU supports AVX.
+bool IsAvxSkinningAvailable();
+// Skins the vertices of [begin, end) 8 at once, returns the first vertex left for the scalar
+// code. Must be called only if IsAvxSkinningAvailable().
+uint32_t SkinVerticesAvx(SkinningData const & data, uint32_t begin, uint32_t end);
+}  // namespace rf
@@ -0,0 +1,709 @@
+#include "terrain_quadtree.hpp"
+
+#include "camera.hpp"
+#include "heightmap.hpp"
+#include "logger.hpp"
+#include "parallel.hpp"
+
+namespace rf
+{
+namespace
+{
+// getHeight(x, y) returns the height of a sample in [0, 1].
+template <typename HeightFunc>
+class HeightmapSampler
+{
+public:
+  HeightmapSampler(HeightFunc const & getHeight, uint32_t width, uint32_t height,
+                   TerrainSettings const & settings)
+    : m_getHeight(getHeight)
+    , m_width(width)
+    , m_height(height)
+    , m_settings(settings)
+    , m_tileSizeX(settings.m_width / width)
+    , m_tileSizeY(settings.m_height / height)
+    , m_altitudeScale(settings.m_maxAltitude - settings.m_minAltitude)
+  {}
+
+  float GetAltitude(uint32_t x, uint32_t y) const
+  {
+    return glm::mix(m_settings.m_minAltitude, m_settings.m_maxAltitude, m_getHeight(x, y));
+  }
+
+  // The same placement as in MeshGenerator::GenerateTerrain.
+  glm::vec3 GetPosition(uint32_t x, uint32_t y) const
+  {
+    return glm::vec3(m_tileSizeX * (static_cast<int>(x) - static_cast<int>(m_width) / 2),
+                     GetAltitude(x, y),
+                     m_tileSizeY * (static_cast<int>(y) - static_cast<int>(m_height) / 2));
+  }
+
+  // Normals are calculated on the full resolution grid, so they don't depend on the LOD.
+  glm::vec3 GetNormal(uint32_t x, uint32_t y) const
+  {
+    return HeightmapGradients::GetNormal(GetGradient(x, y), m_altitudeScale, m_tileSizeX,
+                                         m_tileSizeY);
+  }
+
+  glm::vec3 GetTangent(uint32_t x, uint32_t y) const
+  {
+    return HeightmapGradients::GetTangent(GetGradient(x, y), m_altitudeScale, m_tileSizeX);
+  }
+
+  glm::vec2 GetUV(uint32_t x, uint32_t y) const
+  {
+    return glm::vec2(static_cast<float>(x) / (m_width - 1),
+                     static_cast<float>(y) / (m_height - 1));
+  }
+
+  // Altitude range of the full resolution samples on the segment of a row or a column.
+  float GetAltitudeRange(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) const
+  {
+    float minValue = 1.0f;
+    float maxValue = 0.0f;
+    for (uint32_t y = y0; y <= y1; ++y)
+    {
+      for (uint32_t x = x0; x <= x1; ++x)
+      {
+        minValue = std::min(minValue, m_getHeight(x, y));
+        maxValue = std::max(maxValue, m_getHeight(x, y));
+      }
+    }
+    if (minValue > maxValue)
+      return 0.0f;
+    return m_altitudeScale * (maxValue - minValue);
+  }
+
+  uint32_t GetWidth() const { return m_width; }
+  uint32_t GetHeight() const { return m_height; }
+  float GetTileSize() const { return std::max(m_tileSizeX, m_tileSizeY); }
+
+private:
+  // Gradients of the samples are calculated on demand, so the heightmap doesn't have to be
+  // resident (see HeightmapFile).
+  glm::vec2 GetGradient(uint32_t x, uint32_t y) const
+  {
+    return HeightmapGradients::Calculate(m_getHeight, m_width, m_height, x, y);
+  }
+
+  HeightFunc const & m_getHeight;
+  uint32_t const m_width;
+  uint32_t const m_height;
+  TerrainSettings const & m_settings;
+  float const m_tileSizeX;
+  float const m_tileSizeY;
+  float const m_altitudeScale;
+};
+
+template <typename T>
+void CopyToVertexBuffer(ByteArray & vb, std::vector<T> const & v)
+{
+  size_t const sz = v.size() * sizeof(T);
+  vb.resize(sz);
+  memcpy(vb.data(), v.data(), sz);
+}
+
+template <typename Sampler>
+bool GenerateChunk(Sampler const & sampler, uint32_t x0, uint32_t y0, uint32_t step,
+                   uint32_t chunkSize, uint32_t componentsMask, BaseMesh::MeshGroup & meshGroup)
+{
+  uint32_t const sx = chunkSize + 1;
+  uint32_t const gridVerticesCount = sx * sx;
+  uint32_t const verticesCount = gridVerticesCount + 4 * sx;
+
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<glm::vec3> tangents;
+  std::vector<glm::vec2> uv;
+  positions.reserve(verticesCount);
+  normals.reserve(verticesCount);
+  tangents.reserve(verticesCount);
+  uv.reserve(verticesCount);
+
+  // Samples out of the heightmap are clamped to its border, such triangles become degenerate.
+  auto const maxX = sampler.GetWidth() - 1;
+  auto const maxY = sampler.GetHeight() - 1;
+  auto const x1 = std::min(x0 + chunkSize * step, maxX);
+  auto const y1 = std::min(y0 + chunkSize * step, maxY);
+  for (uint32_t gy = 0; gy < sx; ++gy)
+  {
+    auto const y = std::min(y0 + gy * step, maxY);
+    for (uint32_t gx = 0; gx < sx; ++gx)
+    {
+      auto const x = std::min(x0 + gx * step, maxX);
+      positions.push_back(sampler.GetPosition(x, y));
+      normals.push_back(sampler.GetNormal(x, y));
+      tangents.push_back(sampler.GetTangent(x, y));
+      uv.push_back(sampler.GetUV(x, y));
+    }
+  }
+
+  std::vector<uint32_t> indices;
+  indices.reserve(chunkSize * chunkSize * 6 + 4 * chunkSize * 6);
+  for (uint32_t y = 0; y < chunkSize; ++y)
+  {
+    uint32_t const offset = y * sx;
+    for (uint32_t x = 0; x < chunkSize; ++x)
+    {
+      indices.push_back(offset + x);
+      indices.push_back(offset + x + sx);
+      indices.push_back(offset + x + sx + 1);
+      indices.push_back(offset + x + sx + 1);
+      indices.push_back(offset + x + 1);
+      indices.push_back(offset + x);
+    }
+  }
+
+  // Skirts go down along the chunk borders. Their depth covers the altitude variation of the
+  // full resolution heightmap along the border, i.e. the biggest possible crack.
+  auto addSkirt = [&](uint32_t firstVertex, uint32_t vertexStep, float depth,
+                      glm::vec3 const & outward) {
+    auto const skirtStart = static_cast<uint32_t>(positions.size());
+    for (uint32_t i = 0; i < sx; ++i)
+    {
+      auto const v = firstVertex + i * vertexStep;
+      positions.push_back(positions[v] - glm::vec3(0.0f, depth, 0.0f));
+      normals.push_back(normals[v]);
+      tangents.push_back(tangents[v]);
+      uv.push_back(uv[v]);
+    }
+
+    auto const n = glm::cross(glm::vec3(0.0f, -1.0f, 0.0f),
+                              positions[firstVertex + vertexStep] - positions[firstVertex]);
+    bool const direct = glm::dot(n, outward) >= 0.0f;
+    for (uint32_t i = 0; i < chunkSize; ++i)
+    {
+      auto const a = firstVertex + i * vertexStep;
+      auto const b = a + vertexStep;
+      auto const sa = skirtStart + i;
+      auto const sb = sa + 1;
+      if (direct)
+        indices.insert(indices.end(), {a, sa, b, b, sa, sb});
+      else
+        indices.insert(indices.end(), {a, b, sa, b, sb, sa});
+    }
+  };
+
+  auto const kMinDepth = sampler.GetTileSize() * 0.01f;
+  addSkirt(0, 1, std::max(sampler.GetAltitudeRange(x0, y0, x1, y0), kMinDepth),
+           glm::vec3(0.0f, 0.0f, -1.0f));
+  addSkirt(chunkSize * sx, 1, std::max(sampler.GetAltitudeRange(x0, y1, x1, y1), kMinDepth),
+           glm::vec3(0.0f, 0.0f, 1.0f));
+  addSkirt(0, sx, std::max(sampler.GetAltitudeRange(x0, y0, x0, y1), kMinDepth),
+           glm::vec3(-1.0f, 0.0f, 0.0f));
+  addSkirt(chunkSize, sx, std::max(sampler.GetAltitudeRange(x1, y0, x1, y1), kMinDepth),
+           glm::vec3(1.0f, 0.0f, 0.0f));
+
+  bool failed = false;
+  ForEachAttributeWithCheck(
+    componentsMask,
+    [&meshGroup, &failed, &positions, &uv, &normals, &tangents](MeshVertexAttribute attr) {
+      if (attr == MeshVertexAttribute::Position)
+      {
+        for (auto const & p : positions)
+          meshGroup.m_boundingBox.extend(p);
+
+        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], positions);
+      }
+      else if (attr == MeshVertexAttribute::Normal)
+      {
+        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], normals);
+      }
+      else if (attr == MeshVertexAttribute::Tangent)
+      {
+        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], tangents);
+      }
+      else if (attr == MeshVertexAttribute::UV0)
+      {
+        CopyToVertexBuffer(meshGroup.m_vertexBuffers[attr], uv);
+      }
+      else
+      {
+        failed = true;
+        Logger::ToLog(Logger::Error,
+                      "Can't generate terrain chunk, components mask contains unsupported "
+                      "attributes.");
+        return false;
+      }
+
+      return true;
+    });
+
+  if (failed)
+    return false;
+
+  if (meshGroup.m_boundingBox.isNull())
+  {
+    for (auto const & p : positions)
+      meshGroup.m_boundingBox.extend(p);
+  }
+  meshGroup.m_verticesCount = static_cast<uint32_t>(positions.size());
+  meshGroup.m_indexBuffer = std::move(indices);
+  meshGroup.m_indicesCount = static_cast<uint32_t>(meshGroup.m_indexBuffer.size());
+  return true;
+}
+
+// Samples of a chunk read from the file by windows: the rows of the chunk vertices with their
+// neighbours for the gradients and the border columns for the skirts. A coarse chunk doesn't
+// read the samples between its vertices.
+class ChunkWindow
+{
+public:
+  ChunkWindow(HeightmapFile const & heightmap, uint32_t x0, uint32_t y0, uint32_t step,
+              uint32_t chunkSize)
+    : m_firstX(x0)
+    , m_columnY0(y0)
+  {
+    auto const maxX = heightmap.GetWidth() - 1;
+    auto const maxY = heightmap.GetHeight() - 1;
+    m_lastX = std::min(x0 + chunkSize * step, maxX);
+    auto const y1 = std::min(y0 + chunkSize * step, maxY);
+    m_x0 = x0 > 0 ? x0 - 1 : 0;
+    m_y0 = y0 > 0 ? y0 - 1 : 0;
+    auto const width = std::min(m_lastX + 1, maxX) - m_x0 + 1;
+    m_rows.resize(std::min(y1 + 1, maxY) - m_y0 + 1);
+    for (uint32_t gy = 0; gy <= chunkSize; ++gy)
+    {
+      auto const y = std::min(y0 + gy * step, maxY);
+      for (auto const r : {y > 0 ? y - 1 : y, y, std::min(y + 1, maxY)})
+      {
+        auto & row = m_rows[r - m_y0];
+        if (row.empty())
+          heightmap.ReadTile(m_x0, r, width, 1, row);
+      }
+    }
+    heightmap.ReadTile(m_firstX, y0, 1, y1 - y0 + 1, m_firstColumn);
+    heightmap.ReadTile(m_lastX, y0, 1, y1 - y0 + 1, m_lastColumn);
+  }
+
+  float operator()(uint32_t x, uint32_t y) const
+  {
+    auto const & row = m_rows[y - m_y0];
+    if (!row.empty())
+      return row[x - m_x0] / 65535.0f;
+    auto const & column = (x == m_firstX) ? m_firstColumn : m_lastColumn;
+    return column[y - m_columnY0] / 65535.0f;
+  }
+
+private:
+  uint32_t m_x0 = 0;
+  uint32_t m_y0 = 0;
+  std::vector<std::vector<uint16_t>> m_rows;
+  uint32_t m_firstX = 0;
+  uint32_t m_lastX = 0;
+  uint32_t m_columnY0 = 0;
+  std::vector<uint16_t> m_firstColumn;
+  std::vector<uint16_t> m_lastColumn;
+};
+
+float GetDistanceToBox(glm::vec3 const & position, AABB const & box)
+{
+  auto const d = glm::max(glm::max(box.getMin() - position, position - box.getMax()),
+                          glm::vec3(0.0f));
+  return glm::length(d);
+}
+}  // namespace
+
+bool TerrainQuadtree::Build(std::vector<uint8_t> const & heightmap, uint32_t heightmapWidth,
+                            uint32_t heightmapHeight, TerrainSettings const & settings,
+                            uint32_t componentsMask, std::vector<BaseMesh::MeshGroup> & meshGroups)
+{
+  if (heightmap.size() < static_cast<size_t>(heightmapWidth) * heightmapHeight)
+  {
+    Logger::ToLog(Logger::Error, "Can't generate terrain, heightmap is invalid.");
+    return false;
+  }
+
+  auto getHeight = [&heightmap, heightmapWidth](uint32_t x, uint32_t y)
+  {
+    return heightmap[static_cast<size_t>(y) * heightmapWidth + x] / 255.0f;
+  };
+  return Build(getHeight, heightmapWidth, heightmapHeight, settings, componentsMask, meshGroups);
+}
+
+bool TerrainQuadtree::Build(std::vector<uint16_t> const & heightmap, uint32_t heightmapWidth,
+                            uint32_t heightmapHeight, TerrainSettings const & settings,
+                            uint32_t componentsMask, std::vector<BaseMesh::MeshGroup> & meshGroups)
+{
+  if (heightmap.size() < static_cast<size_t>(heightmapWidth) * heightmapHeight)
+  {
+    Logger::ToLog(Logger::Error, "Can't generate terrain, heightmap is invalid.");
+    return false;
+  }
+
+  auto getHeight = [&heightmap, heightmapWidth](uint32_t x, uint32_t y)
+  {
+    return heightmap[static_cast<size_t>(y) * heightmapWidth + x] / 65535.0f;
+  };
+  return Build(getHeight, heightmapWidth, heightmapHeight, settings, componentsMask, meshGroups);
+}
+
+bool TerrainQuadtree::Build(HeightmapFile const & heightmap, TerrainSettings const & settings,
+                            uint32_t componentsMask)
+{
+  m_chunks.clear();
+  m_heightmap = nullptr;
+  if (componentsMask == 0)
+  {
+    Logger::ToLog(Logger::Error, "Can't generate terrain, components mask is invalid.");
+    return false;
+  }
+
+  // The bounding boxes are calculated by a pass over the mapped file, no geometry is built.
+  auto getHeight = [&heightmap](uint32_t x, uint32_t y)
+  {
+    return heightmap.Get(x, y) / 65535.0f;
+  };
+  if (!BuildPatches(getHeight, heightmap.GetWidth(), heightmap.GetHeight(), settings))
+    return false;
+
+  for (uint32_t i = 0; i < static_cast<uint32_t>(m_nodes.size()); ++i)
+    m_nodes[i].m_groupIndex = static_cast<int>(i);
+  m_heightmap = &heightmap;
+  m_settings = settings;
+  m_componentsMask = componentsMask;
+  return true;
+}
+
+template <typename GetHeight>
+bool TerrainQuadtree::Build(GetHeight const & getHeight, uint32_t heightmapWidth,
+                            uint32_t heightmapHeight, TerrainSettings const & settings,
+                            uint32_t componentsMask, std::vector<BaseMesh::MeshGroup> & meshGroups)
+{
+  m_nodes.clear();
+  m_lodRanges.clear();
+  m_chunks.clear();
+  m_heightmap = nullptr;
+  meshGroups.clear();
+
+  if (componentsMask == 0)
+  {
+    Logger::ToLog(Logger::Error, "Can't generate terrain, components mask is invalid.");
+    return false;
+  }
+
+  if (heightmapWidth < 2 || heightmapHeight < 2)
+  {
+    Logger::ToLog(Logger::Error, "Can't generate terrain, heightmap is invalid.");
+    return false;
+  }
+
+  if (!InitLods(heightmapWidth, heightmapHeight, settings))
+    return false;
+
+  auto const chunkSize = settings.m_chunkSize;
+  auto const lodsCount = GetLodsCount();
+  HeightmapSampler<GetHeight> const sampler(getHeight, heightmapWidth, heightmapHeight, settings);
+
+  std::function<uint32_t(uint32_t, uint32_t, uint32_t)> buildNode;
+  buildNode = [&](uint32_t x0, uint32_t y0, uint32_t lod) -> uint32_t {
+    if (x0 + 1 >= heightmapWidth || y0 + 1 >= heightmapHeight)
+      return kInvalidNode;
+
+    BaseMesh::MeshGroup group;
+    if (!GenerateChunk(sampler, x0, y0, 1u << lod, chunkSize, componentsMask, group))
+      return kInvalidNode;
+
+    group.m_groupIndex = static_cast<int>(meshGroups.size());
+    auto const nodeIndex = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+    m_nodes[nodeIndex].m_boundingBox = group.m_boundingBox;
+    m_nodes[nodeIndex].m_lod = lod;
+    m_nodes[nodeIndex].m_groupIndex = group.m_groupIndex;
+    meshGroups.push_back(std::move(group));
+
+    if (lod == 0)
+      return nodeIndex;
+
+    auto const half = (chunkSize << lod) / 2;
+    std::array<uint32_t, 4> const children = {buildNode(x0, y0, lod - 1),
+                                              buildNode(x0 + half, y0, lod - 1),
+                                              buildNode(x0, y0 + half, lod - 1),
+                                              buildNode(x0 + half, y0 + half, lod - 1)};
+    m_nodes[nodeIndex].m_children = children;
+    return nodeIndex;
+  };
+
+  if (buildNode(0, 0, lodsCount - 1) == kInvalidNode)
+  {
+    m_nodes.clear();
+    meshGroups.clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool TerrainQuadtree::BuildPatches(std::vector<uint8_t> const & heightmap,
+                                   uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                   TerrainSettings const & settings)
+{
+  if (heightmap.size() < static_cast<size_t>(heightmapWidth) * heightmapHeight)
+  {
+    Logger::ToLog(Logger::Error, "Can't generate terrain, heightmap is invalid.");
+    return false;
+  }
+
+  auto getHeight = [&heightmap, heightmapWidth](uint32_t x, uint32_t y)
+  {
+    return heightmap[static_cast<size_t>(y) * heightmapWidth + x] / 255.0f;
+  };
+  return BuildPatches(getHeight, heightmapWidth, heightmapHeight, settings);
+}
+
+bool TerrainQuadtree::BuildPatches(std::vector<uint16_t> const & heightmap,
+                                   uint32_t heightmapWidth, uint32_t heightmapHeight,
+                                   TerrainSettings const & settings)
+{
+  if (heightmap.size() < static_cast<size_t>(heightmapWidth) * heightmapHeight)
+  {
+    Logger::ToLog(Logger::Error, "Can't generate terrain, heightmap is invalid.");
+    return false;
+  }
+
+  auto getHeight = [&heightmap, heightmapWidth](uint32_t x, uint32_t y)
+  {
+    return heightmap[static_cast<size_t>(y) * heightmapWidth + x] / 65535.0f;
+  };
+  return BuildPatches(getHeight, heightmapWidth, heightmapHeight, settings);
+}
+
+template <typename GetHeight>
+bool TerrainQuadtree::BuildPatches(GetHeight const & getHeight, uint32_t heightmapWidth,
+                                   uint32_t heightmapHeight, TerrainSettings const & settings)
+{
+  m_nodes.clear();
+  m_lodRanges.clear();
+  m_chunks.clear();
+  m_heightmap = nullptr;
+
+  if (heightmapWidth < 2 || heightmapHeight < 2)
+  {
+    Logger::ToLog(Logger::Error, "Can't generate terrain, heightmap is invalid.");
+    return false;
+  }
+
+  if (!InitLods(heightmapWidth, heightmapHeight, settings))
+    return false;
+
+  auto const chunkSize = settings.m_chunkSize;
+  HeightmapSampler<GetHeight> const sampler(getHeight, heightmapWidth, heightmapHeight, settings);
+
+  // Bounding boxes of the finest patches are calculated from the samples, the boxes of the
+  // coarser ones are the unions of the children boxes.
+  std::function<uint32_t(uint32_t, uint32_t, uint32_t)> buildNode;
+  buildNode = [&](uint32_t x0, uint32_t y0, uint32_t lod) -> uint32_t {
+    if (x0 + 1 >= heightmapWidth || y0 + 1 >= heightmapHeight)
+      return kInvalidNode;
+
+    auto const nodeIndex = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+    m_nodes[nodeIndex].m_lod = lod;
+    m_nodes[nodeIndex].m_patch.m_offset = glm::vec2(x0, y0);
+    m_nodes[nodeIndex].m_patch.m_scale = static_cast<float>(1u << lod);
+    m_nodes[nodeIndex].m_patch.m_lod = static_cast<float>(lod);
+
+    if (lod == 0)
+    {
+      auto const x1 = std::min(x0 + chunkSize, heightmapWidth - 1);
+      auto const y1 = std::min(y0 + chunkSize, heightmapHeight - 1);
+      AABB box;
+      for (uint32_t y = y0; y <= y1; ++y)
+      {
+        for (uint32_t x = x0; x <= x1; ++x)
+          box.extend(sampler.GetPosition(x, y));
+      }
+      m_nodes[nodeIndex].m_boundingBox = box;
+      return nodeIndex;
+    }
+
+    auto const half = (chunkSize << lod) / 2;
+    std::array<uint32_t, 4> const children = {buildNode(x0, y0, lod - 1),
+                                              buildNode(x0 + half, y0, lod - 1),
+                                              buildNode(x0, y0 + half, lod - 1),
+                                              buildNode(x0 + half, y0 + half, lod - 1)};
+    AABB box;
+    for (auto const c : children)
+    {
+      if (c != kInvalidNode)
+        box.extend(m_nodes[c].m_boundingBox);
+    }
+    m_nodes[nodeIndex].m_boundingBox = box;
+    m_nodes[nodeIndex].m_children = children;
+    return nodeIndex;
+  };
+
+  buildNode(0, 0, GetLodsCount() - 1);
+  return true;
+}
+
+bool TerrainQuadtree::InitLods(uint32_t heightmapWidth, uint32_t heightmapHeight,
+                               TerrainSettings const & settings)
+{
+  auto const chunkSize = settings.m_chunkSize;
+  if (chunkSize < 2 || (chunkSize & (chunkSize - 1)) != 0)
+  {
+    Logger::ToLog(Logger::Error, "Can't generate terrain, chunk size must be a power of 2.");
+    return false;
+  }
+
+  // The root chunk covers the whole heightmap.
+  uint32_t lodsCount = 1;
+  while (chunkSize * (1u << (lodsCount - 1)) < std::max(heightmapWidth, heightmapHeight) - 1)
+    ++lodsCount;
+
+  auto const tileSize = std::max(settings.m_width / heightmapWidth,
+                                 settings.m_height / heightmapHeight);
+  float range = settings.m_lodDistance > 0.0f ? settings.m_lodDistance
+                                              : 2.0f * chunkSize * tileSize;
+  m_lodRanges.resize(lodsCount);
+  for (auto & r : m_lodRanges)
+  {
+    r = range;
+    range *= 2.0f;
+  }
+  return true;
+}
+
+void TerrainQuadtree::Select(Camera const & camera, std::vector<int> & drawList) const
+{
+  Select(camera.GetPosition(),
+         [&camera](AABB const & box) { return camera.IsBoxInFrustum(box); }, drawList);
+}
+
+void TerrainQuadtree::Select(glm::vec3 const & position,
+                             std::function<bool(AABB const &)> const & isVisible,
+                             std::vector<int> & drawList) const
+{
+  drawList.clear();
+  if (!m_nodes.empty())
+  {
+    SelectNode(0, position, isVisible,
+               [&drawList](Node const & node) { drawList.push_back(node.m_groupIndex); });
+  }
+}
+
+void TerrainQuadtree::Select(Camera const & camera, std::vector<PatchInstance> & patches) const
+{
+  Select(camera.GetPosition(),
+         [&camera](AABB const & box) { return camera.IsBoxInFrustum(box); }, patches);
+}
+
+void TerrainQuadtree::Select(glm::vec3 const & position,
+                             std::function<bool(AABB const &)> const & isVisible,
+                             std::vector<PatchInstance> & patches) const
+{
+  patches.clear();
+  if (!m_nodes.empty())
+  {
+    SelectNode(0, position, isVisible,
+               [&patches](Node const & node) { patches.push_back(node.m_patch); });
+  }
+}
+
+void TerrainQuadtree::UpdateChunks(Camera const & camera, std::vector<int> & drawList)
+{
+  UpdateChunks(camera.GetPosition(),
+               [&camera](AABB const & box) { return camera.IsBoxInFrustum(box); }, drawList);
+}
+
+void TerrainQuadtree::UpdateChunks(glm::vec3 const & position,
+                                   std::function<bool(AABB const &)> const & isVisible,
+                                   std::vector<int> & drawList)
+{
+  Select(position, isVisible, drawList);
+  if (m_heightmap == nullptr)
+  {
+    drawList.clear();
+    return;
+  }
+
+  // The chunks which are neither selected nor in the eviction range of their LOD are released.
+  m_selectedNodes.assign(m_nodes.size(), 0);
+  for (auto const index : drawList)
+    m_selectedNodes[index] = 1;
+  for (auto it = m_chunks.begin(); it != m_chunks.end();)
+  {
+    auto const & node = m_nodes[it->first];
+    auto const range = m_lodRanges[node.m_lod] * m_settings.m_evictionScale;
+    if (m_selectedNodes[it->first] == 0 &&
+        GetDistanceToBox(position, node.m_boundingBox) > range)
+    {
+      it = m_chunks.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  m_missingChunks.clear();
+  for (auto const index : drawList)
+  {
+    if (m_chunks.find(index) == m_chunks.end())
+      m_missingChunks.push_back(index);
+  }
+
+  std::vector<BaseMesh::MeshGroup> chunks(m_missingChunks.size());
+  std::vector<uint8_t> generated(m_missingChunks.size(), 0);
+  ParallelFor(static_cast<uint32_t>(m_missingChunks.size()), [&](uint32_t i)
+  {
+    auto const & node = m_nodes[m_missingChunks[i]];
+    auto const x0 = static_cast<uint32_t>(node.m_patch.m_offset.x);
+    auto const y0 = static_cast<uint32_t>(node.m_patch.m_offset.y);
+    auto const step = 1u << node.m_lod;
+    ChunkWindow const window(*m_heightmap, x0, y0, step, m_settings.m_chunkSize);
+    HeightmapSampler<ChunkWindow> const sampler(window, m_heightmap->GetWidth(),
+                                                m_heightmap->GetHeight(), m_settings);
+    if (GenerateChunk(sampler, x0, y0, step, m_settings.m_chunkSize, m_componentsMask,
+                      chunks[i]))
+    {
+      chunks[i].m_groupIndex = node.m_groupIndex;
+      generated[i] = 1;
+    }
+  });
+
+  for (size_t i = 0; i < chunks.size(); ++i)
+  {
+    if (generated[i] != 0)
+      m_chunks[m_missingChunks[i]] = std::move(chunks[i]);
+  }
+
+  // The chunks which can't be generated are not drawn.
+  drawList.erase(std::remove_if(drawList.begin(), drawList.end(), [this](int index)
+  {
+    return m_chunks.find(index) == m_chunks.end();
+  }), drawList.end());
+}
+
+BaseMesh::MeshGroup const * TerrainQuadtree::GetChunk(int groupIndex) const
+{
+  auto const it = m_chunks.find(groupIndex);
+  return it != m_chunks.end() ? &it->second : nullptr;
+}
+
+template <typename OnSelected>
+void TerrainQuadtree::SelectNode(uint32_t nodeIndex, glm::vec3 const & position,
+                                 std::function<bool(AABB const &)> const & isVisible,
+                                 OnSelected const & onSelected) const
+{
+  auto const & node = m_nodes[nodeIndex];
+  if (!isVisible(node.m_boundingBox))
+    return;
+
+  // The node is subdivided if any its point is in the range of the finer LOD. Children cover
+  // the whole node, so the culled ones are just skipped.
+  if (node.m_lod == 0 ||
+      GetDistanceToBox(position, node.m_boundingBox) > m_lodRanges[node.m_lod - 1])
+  {
+    onSelected(node);
+    return;
+  }
+
+  for (auto const c : node.m_children)
+  {
+    if (c != kInvalidNode)
+      SelectNode(c, position, isVisible, onSelected);
+  }
+}
+}  // namespace rf
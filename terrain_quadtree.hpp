@@ -0,0 +1,131 @@
+#pragma once
+
+#include "common.hpp"
+#include "base_mesh.hpp"
+
+namespace rf
+{
+class Camera;
+class HeightmapFile;
+
+struct TerrainSettings
+{
+  float m_minAltitude = 0.0f;
+  float m_maxAltitude = 1.0f;
+  float m_width = 1.0f;
+  float m_height = 1.0f;
+  // Number of quads along a side of a chunk, must be a power of 2. Every chunk has the same
+  // grid, chunks of the coarser LODs cover 4 times bigger area.
+  uint32_t m_chunkSize = 64;
+  // Chunks of LOD 0 (the full resolution) are rendered closer than this distance, the range
+  // of every next LOD is 2 times bigger. 0 means 2 sizes of a LOD 0 chunk.
+  float m_lodDistance = 0.0f;
+  // Streamed chunks (see TerrainQuadtree::UpdateChunks) are released when they are not selected
+  // and farther than the range of their LOD multiplied by this scale.
+  float m_evictionScale = 1.5f;
+};
+
+// Quadtree of terrain chunks (CDLOD-like distance-based selection). Every node is a mesh group
+// with its own grid and skirts, which hide cracks between neighbouring chunks of different LODs.
+class TerrainQuadtree
+{
+public:
+  static uint32_t constexpr kInvalidNode = std::numeric_limits<uint32_t>::max();
+
+  // Instance of the shared N x N grid patch (N is TerrainSettings::m_chunkSize). The offset
+  // of the first vertex and the step between vertices are in heightmap samples, heights are
+  // sampled from the heightmap in the vertex shader (see gl::InstancedTerrain).
+  struct PatchInstance
+  {
+    glm::vec2 m_offset = glm::vec2(0.0f);
+    float m_scale = 1.0f;
+    float m_lod = 0.0f;
+  };
+
+  struct Node
+  {
+    AABB m_boundingBox;
+    // 0 is the finest LOD.
+    uint32_t m_lod = 0;
+    int m_groupIndex = -1;
+    // Placement of the shared patch, see BuildPatches.
+    PatchInstance m_patch;
+    std::array<uint32_t, 4> m_children = {kInvalidNode, kInvalidNode, kInvalidNode,
+                                          kInvalidNode};
+  };
+
+  // Generates mesh groups for all the nodes, group indices start from 0.
+  bool Build(std::vector<uint8_t> const & heightmap, uint32_t heightmapWidth,
+             uint32_t heightmapHeight, TerrainSettings const & settings,
+             uint32_t componentsMask, std::vector<BaseMesh::MeshGroup> & meshGroups);
+  bool Build(std::vector<uint16_t> const & heightmap, uint32_t heightmapWidth,
+             uint32_t heightmapHeight, TerrainSettings const & settings,
+             uint32_t componentsMask, std::vector<BaseMesh::MeshGroup> & meshGroups);
+  // Streamed terrain: builds the nodes only, group indices are the node indices. The chunks are
+  // generated on demand by UpdateChunks from windowed reads of the file, so neither the
+  // heightmap nor the geometry of the whole terrain is resident. The file must outlive the
+  // quadtree or the next Build.
+  bool Build(HeightmapFile const & heightmap, TerrainSettings const & settings,
+             uint32_t componentsMask);
+
+  // Builds the nodes only, without any geometry. The selected nodes are rendered as instances
+  // of one patch, so the geometry memory doesn't depend on the terrain size.
+  bool BuildPatches(std::vector<uint8_t> const & heightmap, uint32_t heightmapWidth,
+                    uint32_t heightmapHeight, TerrainSettings const & settings);
+  bool BuildPatches(std::vector<uint16_t> const & heightmap, uint32_t heightmapWidth,
+                    uint32_t heightmapHeight, TerrainSettings const & settings);
+
+  // Fills the draw list with group indices of visible chunks. The selected chunks cover the
+  // visible part of the terrain without overlapping.
+  void Select(Camera const & camera, std::vector<int> & drawList) const;
+  void Select(glm::vec3 const & position, std::function<bool(AABB const &)> const & isVisible,
+              std::vector<int> & drawList) const;
+  // The same selection for the terrain built with BuildPatches.
+  void Select(Camera const & camera, std::vector<PatchInstance> & patches) const;
+  void Select(glm::vec3 const & position, std::function<bool(AABB const &)> const & isVisible,
+              std::vector<PatchInstance> & patches) const;
+
+  // Selection of the streamed terrain. The missing chunks of the selected nodes are generated
+  // in parallel, the chunks out of the eviction range are released (see
+  // TerrainSettings::m_evictionScale). The draw list is valid until the next update.
+  void UpdateChunks(Camera const & camera, std::vector<int> & drawList);
+  void UpdateChunks(glm::vec3 const & position,
+                    std::function<bool(AABB const &)> const & isVisible,
+                    std::vector<int> & drawList);
+  // nullptr if the chunk is not resident.
+  BaseMesh::MeshGroup const * GetChunk(int groupIndex) const;
+  uint32_t GetChunksCount() const { return static_cast<uint32_t>(m_chunks.size()); }
+
+  std::vector<Node> const & GetNodes() const { return m_nodes; }
+  uint32_t GetLodsCount() const { return static_cast<uint32_t>(m_lodRanges.size()); }
+  float GetLodRange(uint32_t lod) const { return m_lodRanges[lod]; }
+
+private:
+  // getHeight(x, y) returns the height of a sample in [0, 1].
+  template <typename GetHeight>
+  bool Build(GetHeight const & getHeight, uint32_t heightmapWidth, uint32_t heightmapHeight,
+             TerrainSettings const & settings, uint32_t componentsMask,
+             std::vector<BaseMesh::MeshGroup> & meshGroups);
+  template <typename GetHeight>
+  bool BuildPatches(GetHeight const & getHeight, uint32_t heightmapWidth,
+                    uint32_t heightmapHeight, TerrainSettings const & settings);
+  bool InitLods(uint32_t heightmapWidth, uint32_t heightmapHeight,
+                TerrainSettings const & settings);
+  // onSelected(node) is called for every selected node.
+  template <typename OnSelected>
+  void SelectNode(uint32_t nodeIndex, glm::vec3 const & position,
+                  std::function<bool(AABB const &)> const & isVisible,
+                  OnSelected const & onSelected) const;
+
+  std::vector<Node> m_nodes;
+  std::vector<float> m_lodRanges;
+
+  // Streamed terrain.
+  HeightmapFile const * m_heightmap = nullptr;
+  TerrainSettings m_settings;
+  uint32_t m_componentsMask = 0;
+  std::unordered_map<int, BaseMesh::MeshGroup> m_chunks;
+  std::vector<uint8_t> m_selectedNodes;
+  std::vector<int> m_missingChunks;
+};
+}  // namespace rf
@@ -0,0 +1,814 @@
+#include "rf.hpp"
+#include "animation.hpp"
+#include "animation_lod.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+double constexpr kDuration = 100.0;
+
+// Chain of bones with a channel per every bone except the middle one. The bones of a rigid mesh
+// are not scaled.
+class TestSkinnedMesh : public rf::BaseMesh
+{
+public:
+  explicit TestSkinnedMesh(uint32_t bonesCount, uint32_t keysCount = 20, bool rigid = false)
+  {
+    std::mt19937 rnd(42);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    m_rootNode = std::make_unique<MeshNode>();
+    m_rootNode->m_groups.resize(1);
+    m_rootNode->m_groups[0].m_groupIndex = 0;
+    m_groupsCount = 1;
+
+    auto animation = std::make_unique<rf::MeshAnimation>();
+    animation->m_durationInTicks = kDuration;
+    animation->m_ticksPerSecond = 1.0;
+
+    MeshNode * parent = nullptr;
+    for (uint32_t i = 0; i < bonesCount; ++i)
+    {
+      auto node = std::make_unique<MeshNode>();
+      node->m_name = "bone" + std::to_string(i);
+      node->m_transform = glm::translate(glm::mat4x4(), glm::vec3(0.0f, 1.0f, 0.0f));
+      m_bonesIndices[node->m_name] = i;
+      m_rootNode->m_groups[0].m_boneOffsets[i] =
+        glm::translate(glm::mat4x4(), glm::vec3(0.0f, -static_cast<float>(i), 0.0f));
+
+      if (i != bonesCount / 2)
+      {
+        rf::BoneAnimation boneAnim;
+        boneAnim.m_boneIndex = i;
+        for (uint32_t k = 0; k < keysCount; ++k)
+        {
+          double const t = kDuration * k / (keysCount - 1);
+          boneAnim.m_translationKeys.emplace_back(t, glm::vec3(value(rnd), value(rnd), value(rnd)));
+          float const scale = 1.0f + 0.1f * value(rnd);
+          boneAnim.m_scaleKeys.emplace_back(t, glm::vec3(rigid ? 1.0f : scale));
+          boneAnim.m_rotationKeys.emplace_back(
+            t, glm::normalize(glm::quat(1.0f, value(rnd), value(rnd), value(rnd))));
+        }
+        animation->m_boneAnimations.push_back(std::move(boneAnim));
+      }
+
+      auto * const n = node.get();
+      if (parent == nullptr)
+        m_bonesRootNode = std::move(node);
+      else
+        parent->m_children.push_back(std::move(node));
+      parent = n;
+    }
+    animation->BuildChannelsTable(bonesCount);
+    m_animations.push_back(std::move(animation));
+    BuildSkeleton();
+  }
+
+  // The original recursive evaluation over the bones hierarchy.
+  std::vector<glm::mat4x4> GetReferenceTransforms(double animTime) const
+  {
+    std::vector<glm::mat4x4> result(GetBonesCount());
+    CalculateReference(m_bonesRootNode, animTime, glm::mat4x4(), result);
+    return result;
+  }
+
+private:
+  void CalculateReference(std::unique_ptr<MeshNode> const & meshNode, double animTime,
+                          glm::mat4x4 const & parentTransform,
+                          std::vector<glm::mat4x4> & result) const
+  {
+    glm::mat4x4 t = parentTransform * meshNode->m_transform;
+    auto const boneIndex = m_bonesIndices.at(meshNode->m_name);
+    for (auto const & boneAnim : m_animations[0]->m_boneAnimations)
+    {
+      if (boneAnim.m_boneIndex != boneIndex)
+        continue;
+      uint32_t cursor = 0;
+      glm::mat4x4 const r(rf::InterpolateKeys(animTime, boneAnim.m_rotationKeys,
+                                              glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                                              cursor));
+      cursor = 0;
+      glm::vec3 const p = rf::InterpolateKeys(animTime, boneAnim.m_translationKeys, glm::vec3(),
+                                              cursor);
+      cursor = 0;
+      glm::vec3 const s = rf::InterpolateKeys(animTime, boneAnim.m_scaleKeys, glm::vec3(1.0f),
+                                              cursor);
+      t = parentTransform * (glm::translate(glm::mat4x4(), p) * r * glm::scale(glm::mat4x4(), s));
+      break;
+    }
+    result[boneIndex] = t * m_rootNode->m_groups[0].m_boneOffsets.at(boneIndex);
+
+    for (auto const & c : meshNode->m_children)
+      CalculateReference(c, animTime, t, result);
+  }
+};
+
+// The original linear search.
+template <typename TKeys>
+bool FindInterpolationIndicesLinear(double animTime, TKeys const & keys, size_t & startIndex,
+                                    size_t & endIndex)
+{
+  if (keys.empty())
+    return false;
+
+  if (keys.size() == 1)
+  {
+    startIndex = 0;
+    endIndex = 0;
+    return true;
+  }
+
+  for (size_t i = 0; i + 1 < keys.size(); i++)
+  {
+    if (animTime <= keys[i + 1].first)
+    {
+      startIndex = i;
+      endIndex = i + 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+void CheckIndices(std::vector<std::pair<double, float>> const & keys, double t, uint32_t & cursor)
+{
+  size_t expectedStart = 0, expectedEnd = 0;
+  bool const expectedFound = FindInterpolationIndicesLinear(t, keys, expectedStart, expectedEnd);
+
+  size_t start = 0, end = 0;
+  ASSERT_EQ(rf::FindInterpolationIndices(t, keys, cursor, start, end), expectedFound) << t;
+  if (expectedFound)
+  {
+    EXPECT_EQ(start, expectedStart) << t;
+    EXPECT_EQ(end, expectedEnd) << t;
+  }
+}
+}  // namespace
+
+TEST(Animation, FindInterpolationIndices)
+{
+  std::mt19937 rnd(1);
+  std::uniform_real_distribution<double> step(0.1, 2.0);
+  for (size_t keysCount : {0, 1, 2, 3, 50})
+  {
+    std::vector<std::pair<double, float>> keys;
+    double t = 0.0;
+    for (size_t i = 0; i < keysCount; ++i)
+    {
+      keys.emplace_back(t, static_cast<float>(i));
+      t += step(rnd);
+    }
+    double const duration = keys.empty() ? 1.0 : keys.back().first;
+
+    // Forward and backward playback, including the times out of the keys range.
+    uint32_t cursor = 0;
+    for (double time = -1.0; time <= duration + 1.0; time += 0.05)
+      CheckIndices(keys, time, cursor);
+    for (double time = duration + 1.0; time >= -1.0; time -= 0.05)
+      CheckIndices(keys, time, cursor);
+
+    // The exact key times and random seeks.
+    for (auto const & k : keys)
+      CheckIndices(keys, k.first, cursor);
+    std::uniform_real_distribution<double> seek(-1.0, duration + 1.0);
+    for (int i = 0; i < 200; ++i)
+      CheckIndices(keys, seek(rnd), cursor);
+  }
+}
+
+TEST(Animation, CursorMatchesSearch)
+{
+  TestSkinnedMesh mesh(5);
+  rf::AnimationCursor cursor;
+  std::vector<glm::mat4x4> expected;
+  std::vector<glm::mat4x4> transforms;
+  for (double t = 0.0; t < 2.0 * kDuration; t += 0.7)
+  {
+    mesh.GetBonesTransforms(0, 0, t, true /* cycled */, expected);
+    mesh.GetBonesTransforms(0, 0, t, true /* cycled */, transforms, cursor);
+    ASSERT_EQ(expected.size(), transforms.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+      EXPECT_EQ(expected[i], transforms[i]) << t << " " << i;
+  }
+}
+
+TEST(Animation, ChannelsTable)
+{
+  rf::MeshAnimation animation;
+  for (uint32_t boneIndex : {3, 0, 3, 7})
+  {
+    rf::BoneAnimation boneAnim;
+    boneAnim.m_boneIndex = boneIndex;
+    animation.m_boneAnimations.push_back(std::move(boneAnim));
+  }
+  animation.BuildChannelsTable(5);
+
+  // The first channel of a bone wins, the bones out of the skeleton are ignored.
+  EXPECT_EQ(animation.FindChannel(0), 1);
+  EXPECT_EQ(animation.FindChannel(1), -1);
+  EXPECT_EQ(animation.FindChannel(3), 0);
+  EXPECT_EQ(animation.FindChannel(4), -1);
+  EXPECT_EQ(animation.FindChannel(7), -1);
+  EXPECT_EQ(animation.FindChannel(100), -1);
+}
+
+TEST(Animation, FlatSkeleton)
+{
+  TestSkinnedMesh mesh(7);
+  std::vector<glm::mat4x4> transforms;
+  for (double t = 0.0; t <= kDuration; t += 3.3)
+  {
+    mesh.GetBonesTransforms(0, 0, t, false /* cycled */, transforms);
+    auto const expected = mesh.GetReferenceTransforms(t);
+    ASSERT_EQ(expected.size(), transforms.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+      for (int c = 0; c < 4; ++c)
+      {
+        for (int r = 0; r < 4; ++r)
+          EXPECT_NEAR(expected[i][c][r], transforms[i][c][r], 1e-5f) << t << " " << i;
+      }
+    }
+  }
+}
+
+TEST(Animation, ManyBones)
+{
+  uint32_t constexpr kBonesCount = 200;
+  TestSkinnedMesh mesh(kBonesCount, 5);
+  EXPECT_EQ(kBonesCount, mesh.GetBonesCount());
+  std::vector<glm::mat4x4> transforms;
+  mesh.GetBonesTransforms(0, 0, 42.0, false /* cycled */, transforms);
+  auto const expected = mesh.GetReferenceTransforms(42.0);
+  ASSERT_EQ(kBonesCount, transforms.size());
+  for (size_t i = 0; i < expected.size(); ++i)
+  {
+    for (int c = 0; c < 4; ++c)
+    {
+      for (int r = 0; r < 4; ++r)
+      {
+        auto const tolerance = 1e-4f * std::max(1.0f, std::abs(expected[i][c][r]));
+        EXPECT_NEAR(expected[i][c][r], transforms[i][c][r], tolerance) << i;
+      }
+    }
+  }
+}
+
+TEST(Animation, BatchEvaluation)
+{
+  TestSkinnedMesh mesh1(5);
+  TestSkinnedMesh mesh2(9, 7);
+  uint32_t constexpr kRequestsCount = 100;
+  std::vector<rf::AnimationCursor> cursors(kRequestsCount);
+  std::vector<rf::BaseMesh::BonesTransformsRequest> requests(kRequestsCount);
+  for (uint32_t i = 0; i < kRequestsCount; ++i)
+  {
+    requests[i].m_mesh = (i % 3 == 0) ? &mesh2 : &mesh1;
+    requests[i].m_timeSinceStart = 1.7 * i;
+    requests[i].m_cycled = (i % 2 == 0);
+    requests[i].m_cursor = (i % 4 == 0) ? &cursors[i] : nullptr;
+  }
+  requests[1].m_mesh = nullptr;
+
+  std::vector<glm::mat4x4> transforms;
+  std::vector<uint32_t> offsets;
+  rf::BaseMesh::GetBonesTransforms(requests, transforms, offsets);
+  ASSERT_EQ(offsets.size(), kRequestsCount + 1);
+  ASSERT_EQ(transforms.size(), offsets.back());
+
+  std::vector<glm::mat4x4> expected;
+  for (uint32_t i = 0; i < kRequestsCount; ++i)
+  {
+    if (requests[i].m_mesh != nullptr)
+    {
+      requests[i].m_mesh->GetBonesTransforms(0, 0, requests[i].m_timeSinceStart,
+                                             requests[i].m_cycled, expected);
+    }
+    else
+    {
+      expected.clear();
+    }
+    ASSERT_EQ(expected.size(), offsets[i + 1] - offsets[i]) << i;
+    for (uint32_t j = 0; j < expected.size(); ++j)
+      EXPECT_EQ(expected[j], transforms[offsets[i] + j]) << i << " " << j;
+  }
+}
+
+TEST(Animation, PackedBatchEvaluation)
+{
+  TestSkinnedMesh mesh1(5);
+  TestSkinnedMesh mesh2(70, 7);
+  std::vector<rf::BaseMesh::BonesTransformsRequest> requests(40);
+  for (uint32_t i = 0; i < requests.size(); ++i)
+  {
+    requests[i].m_mesh = (i % 3 == 0) ? &mesh2 : &mesh1;
+    requests[i].m_timeSinceStart = 2.3 * i;
+  }
+  requests[5].m_mesh = nullptr;
+
+  std::vector<glm::mat4x4> transforms;
+  std::vector<uint32_t> offsets;
+  rf::BaseMesh::GetBonesTransforms(requests, transforms, offsets);
+
+  for (auto const format : {rf::BonesFormat::Matrix4x4, rf::BonesFormat::Matrix3x4,
+                            rf::BonesFormat::DualQuaternion})
+  {
+    std::vector<float> data;
+    std::vector<uint32_t> packedOffsets;
+    rf::BaseMesh::GetBonesTransforms(requests, format, data, packedOffsets);
+    EXPECT_EQ(offsets, packedOffsets);
+
+    std::vector<float> expected(transforms.size() * rf::GetBoneSize(format));
+    rf::PackBonesTransforms(transforms.data(), static_cast<uint32_t>(transforms.size()), format,
+                            expected.data());
+    EXPECT_EQ(expected, data);
+  }
+}
+
+TEST(Animation, PackQuaternion)
+{
+  std::mt19937 rnd(7);
+  std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+  for (int i = 0; i < 10000; ++i)
+  {
+    auto q = glm::normalize(glm::quat(value(rnd), value(rnd), value(rnd), value(rnd)));
+    if (i < 8)
+    {
+      // Exact axes, both signs.
+      float c[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+      c[i % 4] = i < 4 ? 1.0f : -1.0f;
+      q = glm::quat(c[3], c[0], c[1], c[2]);
+    }
+    uint16_t packed[3];
+    rf::PackQuaternion(q, packed);
+    auto const r = rf::UnpackQuaternion(packed);
+    // The same rotation up to the sign.
+    EXPECT_GT(std::fabs(glm::dot(q, r)), 1.0f - 1e-6f) << i;
+  }
+}
+
+TEST(Animation, Compression)
+{
+  // Whole ticks are stored in 16 bits, the other times in floats. The scales are uniform.
+  for (uint32_t keysCount : {101, 300})
+  {
+    TestSkinnedMesh mesh(7, keysCount);
+    TestSkinnedMesh compressedMesh(7, keysCount);
+
+    auto getKeysSize = [](rf::BaseMesh const & m)
+    {
+      size_t size = 0;
+      for (auto const & boneAnim : m.GetAnimation(0).m_boneAnimations)
+      {
+        size += boneAnim.m_translationKeys.size() * sizeof(boneAnim.m_translationKeys[0]) +
+                boneAnim.m_rotationKeys.size() * sizeof(boneAnim.m_rotationKeys[0]) +
+                boneAnim.m_scaleKeys.size() * sizeof(boneAnim.m_scaleKeys[0]);
+      }
+      return size;
+    };
+    auto const sourceSize = getKeysSize(compressedMesh);
+    compressedMesh.CompressAnimations();
+    EXPECT_EQ(getKeysSize(compressedMesh), 0);
+    EXPECT_LE(compressedMesh.GetAnimation(0).m_compressed.GetSizeInBytes() * 4, sourceSize);
+
+    rf::AnimationCursor cursor;
+    std::vector<glm::mat4x4> expected;
+    std::vector<glm::mat4x4> transforms;
+    for (double t = 0.0; t <= kDuration; t += 0.37)
+    {
+      mesh.GetBonesTransforms(0, 0, t, false /* cycled */, expected);
+      compressedMesh.GetBonesTransforms(0, 0, t, false /* cycled */, transforms, cursor);
+      for (size_t i = 0; i < expected.size(); ++i)
+      {
+        for (int c = 0; c < 4; ++c)
+        {
+          for (int r = 0; r < 4; ++r)
+            ASSERT_NEAR(expected[i][c][r], transforms[i][c][r], 2e-3f) << t << " " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(Animation, KeyframeReduction)
+{
+  rf::BoneAnimation boneAnim;
+  glm::vec3 const axis = glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f));
+  for (int i = 0; i <= 100; ++i)
+  {
+    double const t = i;
+    // Two linear segments, a constant scale and a rotation with a constant speed.
+    float const x = i <= 40 ? 0.1f * i : 4.0f - 0.05f * (i - 40);
+    boneAnim.m_translationKeys.emplace_back(t, glm::vec3(x, 1.0f, -2.0f));
+    boneAnim.m_scaleKeys.emplace_back(t, glm::vec3(2.0f));
+    boneAnim.m_rotationKeys.emplace_back(t, glm::angleAxis(0.01f * i, axis));
+  }
+  auto const source = boneAnim;
+
+  // The reduction is disabled by default.
+  rf::KeyframeReduction reduction;
+  rf::ReduceKeys(boneAnim, reduction);
+  EXPECT_EQ(boneAnim.m_translationKeys.size(), 101);
+
+  // The segments are limited by the maximal length.
+  reduction.m_enabled = true;
+  reduction.m_maxSegmentLength = 10;
+  rf::ReduceKeys(boneAnim, reduction);
+  EXPECT_EQ(boneAnim.m_rotationKeys.size(), 11);
+  boneAnim = source;
+
+  reduction.m_maxSegmentLength = rf::KeyframeReduction().m_maxSegmentLength;
+  rf::ReduceKeys(boneAnim, reduction);
+  EXPECT_EQ(boneAnim.m_translationKeys.size(), 3);
+  EXPECT_EQ(boneAnim.m_scaleKeys.size(), 1);
+  EXPECT_EQ(boneAnim.m_rotationKeys.size(), 2);
+
+  // All the source keys are reconstructed within the tolerances.
+  uint32_t cursors[3] = {0, 0, 0};
+  for (int i = 0; i <= 100; ++i)
+  {
+    double const t = i;
+    auto const p = rf::InterpolateKeys(t, boneAnim.m_translationKeys, glm::vec3(), cursors[0]);
+    EXPECT_LE(glm::length(p - source.m_translationKeys[i].second), 1e-4f) << i;
+    auto const s = rf::InterpolateKeys(t, boneAnim.m_scaleKeys, glm::vec3(), cursors[1]);
+    EXPECT_LE(glm::length(s - source.m_scaleKeys[i].second), 1e-4f) << i;
+    auto const q = rf::InterpolateKeys(t, boneAnim.m_rotationKeys, glm::quat(), cursors[2]);
+    EXPECT_GT(std::fabs(glm::dot(q, source.m_rotationKeys[i].second)), 1.0f - 1e-6f) << i;
+  }
+}
+
+TEST(Animation, PackTransforms)
+{
+  std::mt19937 rnd(3);
+  std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+  for (int i = 0; i < 100; ++i)
+  {
+    auto const q = glm::normalize(glm::quat(value(rnd), value(rnd), value(rnd), value(rnd)));
+    glm::vec3 const t(value(rnd) * 10.0f, value(rnd) * 10.0f, value(rnd) * 10.0f);
+    auto const m = glm::translate(glm::mat4x4(), t) * glm::mat4_cast(q);
+
+    float packed[16];
+    rf::PackBoneTransform(m, rf::BonesFormat::Matrix4x4, packed);
+    EXPECT_EQ(rf::UnpackBoneTransform(packed, rf::BonesFormat::Matrix4x4), m);
+
+    rf::PackMatrix3x4(m, packed);
+    EXPECT_EQ(rf::UnpackMatrix3x4(packed), m);
+
+    rf::PackDualQuaternion(m, packed);
+    auto const r = rf::UnpackDualQuaternion(packed);
+    for (int c = 0; c < 4; ++c)
+    {
+      for (int j = 0; j < 4; ++j)
+        EXPECT_NEAR(m[c][j], r[c][j], 1e-4f) << i;
+    }
+  }
+}
+
+TEST(Animation, Baking)
+{
+  TestSkinnedMesh mesh(5);
+  float constexpr kFps = 10.0f;
+  rf::BakedAnimation baked;
+  ASSERT_TRUE(mesh.BakeAnimation(0, 0, kFps, rf::BakedAnimation::Format::Matrix3x4, baked));
+  EXPECT_EQ(baked.GetFramesCount(), static_cast<uint32_t>(kDuration * kFps) + 1);
+  EXPECT_EQ(baked.GetSizeInBytes(),
+            baked.GetFramesCount() * mesh.GetBonesCount() * 12 * sizeof(float));
+
+  std::vector<glm::mat4x4> expected;
+  std::vector<glm::mat4x4> transforms;
+  for (uint32_t frame = 0; frame < baked.GetFramesCount(); frame += 7)
+  {
+    double const t = static_cast<double>(frame) / kFps;
+    mesh.GetBonesTransforms(0, 0, t, false /* cycled */, expected);
+    baked.GetBonesTransforms(t, false /* cycled */, false /* interpolate */, transforms);
+    ASSERT_EQ(expected.size(), transforms.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+      for (int c = 0; c < 4; ++c)
+      {
+        for (int r = 0; r < 4; ++r)
+          EXPECT_NEAR(expected[i][c][r], transforms[i][c][r], 1e-5f) << frame << " " << i;
+      }
+    }
+  }
+
+  // Interpolation in the middle of the frames.
+  baked.GetBonesTransforms(0.05, false /* cycled */, true /* interpolate */, transforms);
+  std::vector<glm::mat4x4> frame0;
+  std::vector<glm::mat4x4> frame1;
+  baked.GetBonesTransforms(0.0, false /* cycled */, false /* interpolate */, frame0);
+  baked.GetBonesTransforms(0.1, false /* cycled */, false /* interpolate */, frame1);
+  for (int c = 0; c < 4; ++c)
+  {
+    for (int r = 0; r < 4; ++r)
+      EXPECT_NEAR(transforms[1][c][r], 0.5f * (frame0[1][c][r] + frame1[1][c][r]), 1e-5f);
+  }
+
+  rf::BakedAnimation bakedDq;
+  ASSERT_TRUE(mesh.BakeAnimation(0, 0, kFps, rf::BakedAnimation::Format::DualQuaternion,
+                                 bakedDq));
+  EXPECT_EQ(bakedDq.GetSizeInBytes() * 3, baked.GetSizeInBytes() * 2);
+}
+
+TEST(Animation, BakingPartialLastFrame)
+{
+  // The duration is 6.25 frames, the last frame is at the end of the animation.
+  TestSkinnedMesh mesh(3);
+  float constexpr kFps = 0.0625f;
+  rf::BakedAnimation baked;
+  ASSERT_TRUE(mesh.BakeAnimation(0, 0, kFps, rf::BakedAnimation::Format::Matrix3x4, baked));
+  ASSERT_EQ(baked.GetFramesCount(), 8u);
+
+  uint32_t frame1 = 0;
+  uint32_t frame2 = 0;
+  float k = 0.0f;
+  baked.FindFrames(98.0, false /* cycled */, frame1, frame2, k);
+  EXPECT_EQ(frame1, 6u);
+  EXPECT_EQ(frame2, 7u);
+  EXPECT_NEAR(k, 0.5f, 1e-5f);
+  baked.FindFrames(kDuration, false /* cycled */, frame1, frame2, k);
+  EXPECT_EQ(frame2, 7u);
+  EXPECT_NEAR(k, frame1 == frame2 ? 0.0f : 1.0f, 1e-5f);
+
+  std::vector<glm::mat4x4> expected;
+  std::vector<glm::mat4x4> transforms;
+  mesh.GetBonesTransforms(0, 0, kDuration, false /* cycled */, expected);
+  baked.GetBonesTransforms(kDuration, false /* cycled */, true /* interpolate */, transforms);
+  ASSERT_EQ(expected.size(), transforms.size());
+  for (size_t i = 0; i < expected.size(); ++i)
+  {
+    for (int c = 0; c < 4; ++c)
+    {
+      for (int r = 0; r < 4; ++r)
+        EXPECT_NEAR(expected[i][c][r], transforms[i][c][r], 1e-5f) << i;
+    }
+  }
+}
+
+TEST(Animation, BakingDualQuaternions)
+{
+  // Dual quaternions represent only the rigid transforms.
+  TestSkinnedMesh mesh(5, 20, true /* rigid */);
+  float constexpr kFps = 10.0f;
+  rf::BakedAnimation baked;
+  ASSERT_TRUE(mesh.BakeAnimation(0, 0, kFps, rf::BakedAnimation::Format::DualQuaternion, baked));
+  EXPECT_EQ(baked.GetSizeInBytes(),
+            baked.GetFramesCount() * mesh.GetBonesCount() * 8 * sizeof(float));
+
+  std::vector<glm::mat4x4> expected;
+  std::vector<glm::mat4x4> transforms;
+  for (uint32_t frame = 0; frame < baked.GetFramesCount(); frame += 7)
+  {
+    double const t = static_cast<double>(frame) / kFps;
+    mesh.GetBonesTransforms(0, 0, t, false /* cycled */, expected);
+    baked.GetBonesTransforms(t, false /* cycled */, false /* interpolate */, transforms);
+
+    // The packed frame is converted back to the matrices as well.
+    float const * data = baked.GetFrame(frame);
+    ASSERT_EQ(expected.size(), transforms.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+      auto const unpacked = rf::UnpackDualQuaternion(data + i * 8);
+      for (int c = 0; c < 4; ++c)
+      {
+        for (int r = 0; r < 4; ++r)
+        {
+          EXPECT_NEAR(expected[i][c][r], transforms[i][c][r], 1e-4f) << frame << " " << i;
+          EXPECT_NEAR(expected[i][c][r], unpacked[c][r], 1e-4f) << frame << " " << i;
+        }
+      }
+    }
+  }
+}
+
+namespace
+{
+void ExpectNearPoses(rf::AnimationPose const & p1, rf::AnimationPose const & p2, float eps)
+{
+  ASSERT_EQ(p1.GetSize(), p2.GetSize());
+  for (size_t i = 0; i < p1.GetSize(); ++i)
+  {
+    EXPECT_LE(glm::length(p1.m_translations[i] - p2.m_translations[i]), eps) << i;
+    EXPECT_GT(std::fabs(glm::dot(p1.m_rotations[i], p2.m_rotations[i])), 1.0f - eps) << i;
+    EXPECT_LE(glm::length(p1.m_scales[i] - p2.m_scales[i]), eps) << i;
+  }
+}
+}  // namespace
+
+TEST(Animation, Poses)
+{
+  TestSkinnedMesh mesh(6);
+  rf::AnimationPose pose;
+  mesh.InitializePose(pose);
+  ASSERT_EQ(pose.GetSize(), 6);
+
+  std::vector<glm::mat4x4> expected;
+  std::vector<glm::mat4x4> transforms;
+  for (double t = 0.0; t <= kDuration; t += 9.1)
+  {
+    mesh.SamplePose(0, t, false /* cycled */, nullptr, pose);
+    mesh.GetBonesTransforms(0, pose, transforms);
+    mesh.GetBonesTransforms(0, 0, t, false /* cycled */, expected);
+    ASSERT_EQ(expected.size(), transforms.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+      for (int c = 0; c < 4; ++c)
+      {
+        for (int r = 0; r < 4; ++r)
+          EXPECT_NEAR(expected[i][c][r], transforms[i][c][r], 1e-5f) << t << " " << i;
+      }
+    }
+  }
+}
+
+TEST(Animation, Blending)
+{
+  TestSkinnedMesh mesh(6);
+  rf::AnimationPose pose1, pose2, pose3, result;
+  mesh.InitializePose(pose1);
+  mesh.InitializePose(pose2);
+  mesh.InitializePose(pose3);
+  mesh.InitializePose(result);
+  mesh.SamplePose(0, 10.0, true /* cycled */, nullptr, pose1);
+  mesh.SamplePose(0, 45.0, true /* cycled */, nullptr, pose2);
+  mesh.SamplePose(0, 80.0, true /* cycled */, nullptr, pose3);
+
+  // N-way cross-fade.
+  rf::AnimationPose const * poses[] = {&pose1, &pose2, &pose3};
+  float const weights1[] = {0.0f, 2.0f, 0.0f};
+  rf::CrossFadePoses(poses, weights1, 3, result);
+  ExpectNearPoses(result, pose2, 1e-6f);
+
+  float const weights2[] = {1.0f, 1.0f, 0.0f};
+  rf::CrossFadePoses(poses, weights2, 3, result);
+  rf::AnimationPose halfway;
+  mesh.InitializePose(halfway);
+  rf::BlendPoses(pose1, pose2, 0.5f, nullptr, halfway);
+  for (size_t i = 0; i < result.GetSize(); ++i)
+    EXPECT_LE(glm::length(result.m_translations[i] - halfway.m_translations[i]), 1e-6f);
+
+  // The mask of the third bone covers it and its descendants.
+  rf::BoneMask mask;
+  mesh.GetBoneMask("bone3", mask);
+  EXPECT_EQ(mask, rf::BoneMask({0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f}));
+  rf::BlendPoses(pose1, pose2, 1.0f, &mask, result);
+  for (size_t i = 0; i < result.GetSize(); ++i)
+  {
+    auto const & expected = i < 3 ? pose1 : pose2;
+    EXPECT_EQ(result.m_translations[i], expected.m_translations[i]) << i;
+  }
+
+  // Additive layer: the difference to the reference is applied to the base.
+  rf::AddPose(pose1, pose2, pose2, 1.0f, nullptr, result);
+  ExpectNearPoses(result, pose1, 1e-5f);
+  rf::AddPose(pose1, pose2, pose1, 1.0f, nullptr, result);
+  ExpectNearPoses(result, pose2, 1e-5f);
+  rf::AddPose(pose3, pose2, pose1, 0.0f, nullptr, result);
+  ExpectNearPoses(result, pose3, 1e-5f);
+}
+
+TEST(AnimationLod, SkeletonLod)
+{
+  TestSkinnedMesh mesh(7);
+  std::vector<rf::BaseMesh::BonesTransformsRequest> requests(2);
+  for (auto & r : requests)
+  {
+    r.m_mesh = &mesh;
+    r.m_timeSinceStart = 37.0;
+  }
+  requests[1].m_skippedLevels = 2;
+
+  std::vector<glm::mat4x4> transforms;
+  std::vector<uint32_t> offsets;
+  rf::BaseMesh::GetBonesTransforms(requests, transforms, offsets);
+
+  // The ancestors are evaluated, the last two bones of the chain keep the bind pose.
+  for (uint32_t i = 0; i < 5; ++i)
+    EXPECT_EQ(transforms[i], transforms[offsets[1] + i]) << i;
+
+  auto const bind = glm::translate(glm::mat4x4(), glm::vec3(0.0f, 1.0f, 0.0f));
+  auto const parent = transforms[offsets[1] + 4] *
+                      glm::translate(glm::mat4x4(), glm::vec3(0.0f, 4.0f, 0.0f));
+  auto const expected = parent * bind * bind;
+  auto const leaf = transforms[offsets[1] + 6] *
+                    glm::translate(glm::mat4x4(), glm::vec3(0.0f, 6.0f, 0.0f));
+  for (int c = 0; c < 4; ++c)
+  {
+    for (int r = 0; r < 4; ++r)
+      EXPECT_NEAR(expected[c][r], leaf[c][r], 1e-4f);
+  }
+}
+
+TEST(AnimationLod, Levels)
+{
+  rf::Camera camera;
+  camera.Initialize(1024, 768);
+
+  rf::AnimationLod lod;
+  auto const & levels = lod.GetSettings().m_levels;
+  AABB const nearBox(glm::vec3(-1.0f, -1.0f, 4.0f), glm::vec3(1.0f, 1.0f, 6.0f));
+  AABB const farBox(glm::vec3(-1.0f, -1.0f, 500.0f), glm::vec3(1.0f, 1.0f, 502.0f));
+  AABB const hiddenBox(glm::vec3(-1.0f, -1.0f, -6.0f), glm::vec3(1.0f, 1.0f, -4.0f));
+  EXPECT_GT(rf::AnimationLod::GetScreenSize(camera, nearBox),
+            rf::AnimationLod::GetScreenSize(camera, farBox));
+  EXPECT_EQ(0u, lod.SelectLevel(camera, nearBox));
+  EXPECT_EQ(levels.size() - 1, lod.SelectLevel(camera, farBox));
+  EXPECT_EQ(levels.size(), lod.SelectLevel(camera, hiddenBox));
+}
+
+TEST(AnimationLod, UpdateRate)
+{
+  TestSkinnedMesh mesh(5);
+  rf::Camera camera;
+  camera.Initialize(1024, 768);
+
+  uint32_t constexpr kInterval = 4;
+  rf::AnimationLodSettings settings;
+  settings.m_levels = {{0.0f, kInterval, 0}};
+  rf::AnimationLod lod(settings);
+
+  rf::AnimationLodState state;
+  std::vector<rf::AnimationLod::Request> requests(1);
+  requests[0].m_bones.m_mesh = &mesh;
+  requests[0].m_bones.m_cycled = false;
+  requests[0].m_boundingBox = AABB(glm::vec3(-1.0f, -1.0f, 4.0f), glm::vec3(1.0f, 1.0f, 6.0f));
+  requests[0].m_state = &state;
+
+  std::vector<glm::mat4x4> transforms;
+  std::vector<uint32_t> offsets;
+  std::vector<glm::mat4x4> expected1;
+  std::vector<glm::mat4x4> expected2;
+  for (uint32_t frame = 0; frame <= 2 * kInterval; ++frame)
+  {
+    requests[0].m_bones.m_timeSinceStart = frame;
+    lod.Update(camera, requests, transforms, offsets);
+    EXPECT_EQ(frame % kInterval == 0 ? 1u : 0u, lod.GetUpdatesCount()) << frame;
+    ASSERT_EQ(mesh.GetBonesCount(), transforms.size());
+
+    if (frame == 0)
+    {
+      mesh.GetBonesTransforms(0, 0, 0.0, false /* cycled */, expected1);
+      EXPECT_EQ(expected1, transforms);
+    }
+    else if (frame == kInterval)
+    {
+      mesh.GetBonesTransforms(0, 0, kInterval, false /* cycled */, expected2);
+    }
+
+    // Between the updates the transforms move from the previous evaluation to the last one.
+    if (frame == 2 * kInterval - 1)
+    {
+      for (size_t i = 0; i < transforms.size(); ++i)
+      {
+        for (int c = 0; c < 4; ++c)
+        {
+          for (int r = 0; r < 4; ++r)
+            EXPECT_NEAR(expected2[i][c][r], transforms[i][c][r], 1e-5f) << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(AnimationLod, Budget)
+{
+  TestSkinnedMesh mesh(5);
+  rf::Camera camera;
+  camera.Initialize(1024, 768);
+
+  rf::AnimationLodSettings settings;
+  settings.m_levels = {{0.0f, 1, 0}};
+  settings.m_maxUpdatesPerFrame = 3;
+  rf::AnimationLod lod(settings);
+
+  uint32_t constexpr kInstancesCount = 10;
+  std::vector<rf::AnimationLodState> states(kInstancesCount);
+  std::vector<rf::AnimationLod::Request> requests(kInstancesCount);
+  for (uint32_t i = 0; i < kInstancesCount; ++i)
+  {
+    requests[i].m_bones.m_mesh = &mesh;
+    float const z = 5.0f + 10.0f * i;
+    requests[i].m_boundingBox = AABB(glm::vec3(-1.0f, -1.0f, z), glm::vec3(1.0f, 1.0f, z + 2.0f));
+    requests[i].m_state = &states[i];
+  }
+
+  // The instances without the transforms are evaluated regardless of the budget.
+  std::vector<glm::mat4x4> transforms;
+  std::vector<uint32_t> offsets;
+  lod.Update(camera, requests, transforms, offsets);
+  EXPECT_EQ(kInstancesCount, lod.GetUpdatesCount());
+
+  // The nearest instances go first, the postponed ones are updated in the next frames.
+  lod.Update(camera, requests, transforms, offsets);
+  EXPECT_EQ(settings.m_maxUpdatesPerFrame, lod.GetUpdatesCount());
+  for (uint32_t i = 0; i < kInstancesCount; ++i)
+    EXPECT_EQ(i < settings.m_maxUpdatesPerFrame ? 0u : 1u, states[i].m_framesSinceUpdate) << i;
+
+  for (int frame = 0; frame < 10; ++frame)
+    lod.Update(camera, requests, transforms, offsets);
+  for (auto const & state : states)
+    EXPECT_LT(state.m_framesSinceUpdate, kInstancesCount);
+}
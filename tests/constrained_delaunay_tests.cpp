@@ -0,0 +1,115 @@
+#include "constrained_delaunay.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+double GetArea(std::vector<double> const & coords, uint32_t a, uint32_t b, uint32_t c)
+{
+  return 0.5 * fabs((coords[2 * b] - coords[2 * a]) * (coords[2 * c + 1] - coords[2 * a + 1]) -
+                    (coords[2 * b + 1] - coords[2 * a + 1]) * (coords[2 * c] - coords[2 * a]));
+}
+
+double GetPolygonArea(std::vector<double> const & coords, std::vector<uint32_t> const & polygon)
+{
+  double area = 0.0;
+  for (size_t i = 0; i < polygon.size(); ++i)
+  {
+    auto const a = polygon[i];
+    auto const b = polygon[(i + 1) % polygon.size()];
+    area += coords[2 * a] * coords[2 * b + 1] - coords[2 * b] * coords[2 * a + 1];
+  }
+  return 0.5 * fabs(area);
+}
+
+void CheckTriangulation(std::vector<double> const & coords, std::vector<uint32_t> const & polygon)
+{
+  rf::ConstrainedDelaunay triangulation(coords);
+  for (size_t i = 0; i < polygon.size(); ++i)
+    ASSERT_TRUE(triangulation.InsertConstraint(polygon[i], polygon[(i + 1) % polygon.size()]));
+  triangulation.RemoveOuterTriangles();
+
+  auto const & triangles = triangulation.GetTriangles();
+  ASSERT_FALSE(triangles.empty());
+  double area = 0.0;
+  for (size_t i = 0; i < triangles.size(); i += 3)
+    area += GetArea(coords, triangles[i], triangles[i + 1], triangles[i + 2]);
+
+  // The kept triangles cover the polygon exactly.
+  EXPECT_NEAR(area, GetPolygonArea(coords, polygon), 1e-6);
+
+  auto const & halfedges = triangulation.GetHalfedges();
+  for (uint32_t e = 0; e < static_cast<uint32_t>(halfedges.size()); ++e)
+  {
+    if (halfedges[e] != rf::ConstrainedDelaunay::kInvalidIndex)
+      EXPECT_EQ(halfedges[halfedges[e]], e);
+  }
+}
+}  // namespace
+
+TEST(ConstrainedDelaunay, ConcavePolygon)
+{
+  // Regular grid with an L-shaped border, which doesn't go through the grid points.
+  std::vector<double> coords;
+  for (int y = 0; y <= 10; ++y)
+  {
+    for (int x = 0; x <= 10; ++x)
+    {
+      coords.push_back(x);
+      coords.push_back(y);
+    }
+  }
+
+  std::vector<std::pair<double, double>> const border = {{0.5, 0.5}, {9.5, 0.7}, {9.3, 4.5},
+                                                         {4.5, 4.3}, {4.7, 9.5}, {0.6, 9.2}};
+  std::vector<uint32_t> polygon;
+  for (auto const & [x, y] : border)
+  {
+    polygon.push_back(static_cast<uint32_t>(coords.size() / 2));
+    coords.push_back(x);
+    coords.push_back(y);
+  }
+  CheckTriangulation(coords, polygon);
+}
+
+TEST(ConstrainedDelaunay, CollinearPoints)
+{
+  // The border goes through the grid points, constraints are split on them.
+  std::vector<double> coords;
+  for (int y = 0; y <= 8; ++y)
+  {
+    for (int x = 0; x <= 8; ++x)
+    {
+      coords.push_back(x);
+      coords.push_back(y);
+    }
+  }
+  std::vector<uint32_t> const polygon = {1 * 9 + 1, 1 * 9 + 7, 7 * 9 + 7, 4 * 9 + 4, 7 * 9 + 1};
+  CheckTriangulation(coords, polygon);
+}
+
+TEST(ConstrainedDelaunay, RandomStar)
+{
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  std::vector<double> coords;
+  for (int i = 0; i < 500; ++i)
+  {
+    coords.push_back(distribution(rng));
+    coords.push_back(distribution(rng));
+  }
+
+  std::vector<uint32_t> polygon;
+  uint32_t const kStarPoints = 40;
+  for (uint32_t i = 0; i < kStarPoints; ++i)
+  {
+    auto const angle = 2.0 * kPi * i / kStarPoints;
+    auto const r = (i % 2 == 0) ? 0.9 : 0.35;
+    polygon.push_back(static_cast<uint32_t>(coords.size() / 2));
+    coords.push_back(r * cos(angle));
+    coords.push_back(r * sin(angle));
+  }
+  CheckTriangulation(coords, polygon);
+}
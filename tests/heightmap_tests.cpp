@@ -0,0 +1,176 @@
+#include "heightmap.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <random>
+
+TEST(HeightmapGradients, Ramp)
+{
+  uint32_t const kWidth = 37;
+  uint32_t const kHeight = 11;
+  std::vector<uint8_t> heightmap(kWidth * kHeight);
+  for (uint32_t y = 0; y < kHeight; ++y)
+  {
+    for (uint32_t x = 0; x < kWidth; ++x)
+      heightmap[y * kWidth + x] = static_cast<uint8_t>(2 * x + 3 * y);
+  }
+
+  rf::HeightmapGradients gradients;
+  gradients.Calculate(heightmap, kWidth, kHeight);
+  for (uint32_t y = 1; y + 1 < kHeight; ++y)
+  {
+    for (uint32_t x = 1; x + 1 < kWidth; ++x)
+    {
+      EXPECT_FLOAT_EQ(gradients.Get(x, y).x, 2.0f);
+      EXPECT_FLOAT_EQ(gradients.Get(x, y).y, 3.0f);
+    }
+  }
+
+  // One-sided differences on the borders.
+  for (uint32_t y = 0; y < kHeight; ++y)
+  {
+    EXPECT_FLOAT_EQ(gradients.Get(0, y).x, 2.0f);
+    EXPECT_FLOAT_EQ(gradients.Get(kWidth - 1, y).x, 2.0f);
+  }
+  for (uint32_t x = 0; x < kWidth; ++x)
+  {
+    EXPECT_FLOAT_EQ(gradients.Get(x, 0).y, 3.0f);
+    EXPECT_FLOAT_EQ(gradients.Get(x, kHeight - 1).y, 3.0f);
+  }
+  EXPECT_EQ(gradients.Get(0, 0),
+            rf::HeightmapGradients::Calculate(heightmap, kWidth, kHeight, 0, 0));
+  EXPECT_EQ(gradients.Get(kWidth - 1, kHeight - 1),
+            rf::HeightmapGradients::Calculate(heightmap, kWidth, kHeight, kWidth - 1,
+                                              kHeight - 1));
+
+  auto const n = rf::HeightmapGradients::GetNormal(gradients.Sample(10.5f, 5.5f), 1.0f,
+                                                   1.0f, 1.0f);
+  EXPECT_NEAR(glm::dot(n, glm::normalize(glm::vec3(-2.0f, 1.0f, -3.0f))), 1.0f, 1e-5f);
+}
+
+TEST(HeightmapGradients, Sobel)
+{
+  uint32_t const kWidth = 53;
+  uint32_t const kHeight = 17;
+  std::vector<uint8_t> heightmap(kWidth * kHeight);
+  for (size_t i = 0; i < heightmap.size(); ++i)
+    heightmap[i] = static_cast<uint8_t>((i * 7919) % 251);
+
+  rf::HeightmapGradients gradients;
+  gradients.Calculate(heightmap, kWidth, kHeight);
+
+  auto h = [&](int x, int y)
+  {
+    x = std::clamp(x, 0, static_cast<int>(kWidth) - 1);
+    y = std::clamp(y, 0, static_cast<int>(kHeight) - 1);
+    return static_cast<float>(heightmap[y * kWidth + x]);
+  };
+  for (int y = 0; y < static_cast<int>(kHeight); ++y)
+  {
+    for (int x = 0; x < static_cast<int>(kWidth); ++x)
+    {
+      auto const dx = (h(x + 1, y - 1) + 2.0f * h(x + 1, y) + h(x + 1, y + 1)) -
+                      (h(x - 1, y - 1) + 2.0f * h(x - 1, y) + h(x - 1, y + 1));
+      auto const dy = (h(x - 1, y + 1) + 2.0f * h(x, y + 1) + h(x + 1, y + 1)) -
+                      (h(x - 1, y - 1) + 2.0f * h(x, y - 1) + h(x + 1, y - 1));
+      // The distance between the samples of the stencil, 1 on the borders.
+      float const distanceX = (x > 0 && x + 1 < static_cast<int>(kWidth)) ? 2.0f : 1.0f;
+      float const distanceY = (y > 0 && y + 1 < static_cast<int>(kHeight)) ? 2.0f : 1.0f;
+      ASSERT_FLOAT_EQ(gradients.Get(x, y).x, dx / (4.0f * distanceX));
+      ASSERT_FLOAT_EQ(gradients.Get(x, y).y, dy / (4.0f * distanceY));
+    }
+  }
+}
+
+TEST(Heightmap, MarkChangedSamples)
+{
+  std::mt19937 rnd(11);
+  for (uint32_t const width : {1u, 2u, 15u, 16u, 17u, 31u, 32u, 33u, 100u})
+  {
+    for (uint32_t const height : {1u, 2u, 3u, 5u})
+    {
+      for (uint8_t const tolerance : {0, 2, 255})
+      {
+        // A narrow range of values gives both changed and unchanged samples.
+        std::uniform_int_distribution<int> value(100, tolerance == 0 ? 101 : 104);
+        std::vector<uint8_t> heightmap(width * height);
+        for (auto & h : heightmap)
+          h = static_cast<uint8_t>(value(rnd));
+
+        std::vector<uint8_t> changed(width);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+          auto const row = heightmap.data() + y * width;
+          auto const prevRow = y > 0 ? row - width : row;
+          auto const nextRow = y + 1 < height ? row + width : row;
+          rf::MarkChangedSamples(prevRow, row, nextRow, width, tolerance, changed.data());
+
+          // Scalar scan of the neighbours inside the heightmap.
+          for (uint32_t x = 0; x < width; ++x)
+          {
+            bool expected = false;
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+              for (int dx = -1; dx <= 1; ++dx)
+              {
+                int const nx = static_cast<int>(x) + dx;
+                int const ny = static_cast<int>(y) + dy;
+                if (nx < 0 || ny < 0 || nx >= static_cast<int>(width) ||
+                    ny >= static_cast<int>(height))
+                {
+                  continue;
+                }
+                expected |= std::abs(heightmap[ny * width + nx] - row[x]) > tolerance;
+              }
+            }
+            ASSERT_EQ(expected ? 1 : 0, changed[x]) << width << "x" << height << " "
+                                                    << static_cast<int>(tolerance) << " ("
+                                                    << x << ", " << y << ")";
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(HeightmapFile, ReadTile)
+{
+  uint32_t const kWidth = 23;
+  uint32_t const kHeight = 19;
+  std::string const kFileName = "heightmap_file_test.raw";
+
+  std::vector<float> samples(kWidth * kHeight);
+  for (size_t i = 0; i < samples.size(); ++i)
+    samples[i] = 100.0f + static_cast<float>(i % 101);
+  auto f = fopen(kFileName.c_str(), "wb");
+  ASSERT_NE(f, nullptr);
+  fwrite(samples.data(), sizeof(float), samples.size(), f);
+  fclose(f);
+
+  {
+    rf::HeightmapFile heightmap;
+    EXPECT_FALSE(heightmap.Open(kFileName, kWidth + 1, kHeight, rf::HeightmapFile::Format::Float,
+                                100.0f, 200.0f));
+    ASSERT_TRUE(heightmap.Open(kFileName, kWidth, kHeight, rf::HeightmapFile::Format::Float,
+                               100.0f, 200.0f));
+    EXPECT_EQ(heightmap.Get(0, 0), 0);
+    EXPECT_EQ(heightmap.Get(100, 0), 65535);
+    EXPECT_EQ(heightmap.Get(50 % kWidth, 50 / kWidth), 32768);
+
+    // The tile is clamped by the heightmap borders.
+    std::vector<uint16_t> tile;
+    heightmap.ReadTile(kWidth - 3, kHeight - 2, 5, 4, tile);
+    ASSERT_EQ(tile.size(), 20u);
+    for (uint32_t y = 0; y < 4; ++y)
+    {
+      for (uint32_t x = 0; x < 5; ++x)
+      {
+        auto const sx = std::min(kWidth - 3 + x, kWidth - 1);
+        auto const sy = std::min(kHeight - 2 + y, kHeight - 1);
+        EXPECT_EQ(tile[y * 5 + x], heightmap.Get(sx, sy));
+      }
+    }
+  }
+  std::remove(kFileName.c_str());
+}
@@ -0,0 +1,318 @@
+#include "rf.hpp"
+#include "mesh_generator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+uint32_t GetUniquePositionsCount(rf::BaseMesh::MeshGroup const & group)
+{
+  auto const & buffer = group.m_vertexBuffers.at(rf::MeshVertexAttribute::Position);
+  auto const positions = reinterpret_cast<glm::vec3 const *>(buffer.data());
+  std::map<std::tuple<float, float, float>, uint32_t> unique;
+  for (uint32_t i = 0; i < group.m_verticesCount; ++i)
+    unique[std::make_tuple(positions[i].x, positions[i].y, positions[i].z)]++;
+  return static_cast<uint32_t>(unique.size());
+}
+
+// Altitude of the tiles at (x, z), every tile containing the point must agree.
+bool GetTilesAltitude(std::vector<rf::BaseMesh::MeshGroup> const & groups, float x, float z,
+                      float & altitude)
+{
+  bool found = false;
+  for (auto const & group : groups)
+  {
+    auto const & box = group.m_boundingBox;
+    if (x < box.getMin().x || x > box.getMax().x || z < box.getMin().z || z > box.getMax().z)
+      continue;
+
+    auto const positions = reinterpret_cast<glm::vec3 const *>(
+        group.m_vertexBuffers.at(rf::MeshVertexAttribute::Position).data());
+    auto const & indices = group.m_indexBuffer;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+      auto const & a = positions[indices[i]];
+      auto const & b = positions[indices[i + 1]];
+      auto const & c = positions[indices[i + 2]];
+      auto const area = (b.x - a.x) * (c.z - a.z) - (b.z - a.z) * (c.x - a.x);
+      auto const wb = ((x - a.x) * (c.z - a.z) - (z - a.z) * (c.x - a.x)) / area;
+      auto const wc = ((b.x - a.x) * (z - a.z) - (b.z - a.z) * (x - a.x)) / area;
+      if (wb < -1e-5f || wc < -1e-5f || wb + wc > 1.0f + 1e-5f)
+        continue;
+
+      auto const y = a.y + wb * (b.y - a.y) + wc * (c.y - a.y);
+      if (found && fabs(y - altitude) > 1e-3f)
+        return false;
+      altitude = y;
+      found = true;
+      break;
+    }
+  }
+  return found;
+}
+}  // namespace
+
+TEST(MeshGenerator, SphereSharedVertices)
+{
+  rf::MeshGenerator generator;
+  for (uint32_t level = 0; level <= 5; ++level)
+  {
+    rf::BaseMesh::MeshGroup group;
+    ASSERT_TRUE(generator.GenerateSphere(1.0f, rf::MeshVertexAttribute::Position, group, level));
+
+    // Icosphere: V = 10 * 4^n + 2, F = 20 * 4^n. Only the texture seam duplicates vertices.
+    uint32_t const expectedVertices = 10 * (1u << (2 * level)) + 2;
+    EXPECT_EQ(GetUniquePositionsCount(group), expectedVertices);
+    EXPECT_EQ(group.m_indicesCount, 60u * (1u << (2 * level)));
+    EXPECT_LT(group.m_verticesCount, expectedVertices + expectedVertices / 4 + 4);
+  }
+}
+
+TEST(MeshGenerator, SphereTesselationLevel)
+{
+  EXPECT_EQ(rf::MeshGenerator::GetSphereTesselationLevel(1.0f, 1.0f), 0u);
+  uint32_t prevLevel = 0;
+  for (float error = 0.1f; error > 1e-5f; error *= 0.5f)
+  {
+    auto const level = rf::MeshGenerator::GetSphereTesselationLevel(1.0f, error);
+    EXPECT_GE(level, prevLevel);
+    prevLevel = level;
+  }
+  EXPECT_EQ(rf::MeshGenerator::GetSphereTesselationLevel(1.0f, 0.0f),
+            rf::MeshGenerator::kMaxSphereTesselationLevel);
+
+  rf::MeshGenerator generator;
+  rf::BaseMesh::MeshGroup group;
+  EXPECT_FALSE(generator.GenerateSphere(1.0f, rf::MeshVertexAttribute::Position, group,
+                                        rf::MeshGenerator::kMaxSphereTesselationLevel + 1));
+}
+
+TEST(MeshGenerator, TiledTerrain)
+{
+  // Random points and a regular grid, which has lots of cocircular points on the seams.
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> distribution(0.0f, 100.0f);
+  auto getAltitude = [](float x, float z) { return 5.0f * sin(x * 0.1f) * cos(z * 0.07f); };
+  std::vector<glm::vec3> points;
+  for (int i = 0; i < 5000; ++i)
+  {
+    auto const x = distribution(rng);
+    auto const z = distribution(rng);
+    points.emplace_back(x, getAltitude(x, z), z);
+  }
+  for (int z = 0; z <= 100; z += 2)
+  {
+    for (int x = 0; x <= 100; x += 2)
+      points.emplace_back(x, getAltitude(x, z), z);
+  }
+
+  rf::MeshGenerator generator;
+  std::vector<rf::BaseMesh::MeshGroup> groups;
+  ASSERT_TRUE(generator.GenerateTiledTerrain(points, 30.0f, 0.05f,
+                                             rf::MeshVertexAttribute::Position |
+                                             rf::MeshVertexAttribute::Normal, groups));
+  ASSERT_EQ(groups.size(), 16u);
+
+  // Tiles cover the bounding box without holes and overlaps, every inner boundary edge of a tile
+  // is an edge of the neighbouring tile.
+  using Point = std::pair<float, float>;
+  std::map<std::pair<Point, Point>, int> boundaryEdges;
+  double area = 0.0;
+  for (auto const & group : groups)
+  {
+    auto const positions = reinterpret_cast<glm::vec3 const *>(
+        group.m_vertexBuffers.at(rf::MeshVertexAttribute::Position).data());
+    auto const normals = reinterpret_cast<glm::vec3 const *>(
+        group.m_vertexBuffers.at(rf::MeshVertexAttribute::Normal).data());
+    for (uint32_t i = 0; i < group.m_verticesCount; ++i)
+      EXPECT_GT(normals[i].y, 0.0f);
+
+    std::map<std::pair<Point, Point>, int> edges;
+    auto const & indices = group.m_indexBuffer;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+      glm::vec3 const p[3] = {positions[indices[i]], positions[indices[i + 1]],
+                              positions[indices[i + 2]]};
+      area += 0.5 * fabs((p[1].x - p[0].x) * (p[2].z - p[0].z) -
+                         (p[1].z - p[0].z) * (p[2].x - p[0].x));
+      for (int j = 0; j < 3; ++j)
+      {
+        Point a(p[j].x, p[j].z);
+        Point b(p[(j + 1) % 3].x, p[(j + 1) % 3].z);
+        edges[std::minmax(a, b)]++;
+      }
+    }
+    for (auto const & [edge, count] : edges)
+    {
+      if (count == 1)
+        boundaryEdges[edge]++;
+    }
+  }
+  EXPECT_NEAR(area, 100.0 * 100.0, 1e-1);
+
+  auto isOuter = [](Point const & a, Point const & b)
+  {
+    return (a.first == b.first && (a.first == 0.0f || a.first == 100.0f)) ||
+           (a.second == b.second && (a.second == 0.0f || a.second == 100.0f));
+  };
+  for (auto const & [edge, count] : boundaryEdges)
+    EXPECT_EQ(count, isOuter(edge.first, edge.second) ? 1 : 2);
+}
+
+TEST(MeshGenerator, TiledTerrainSeams)
+{
+  // Random points never fall on the seams at 25 and 75, the points on the seams at 50 must be
+  // kept within the error. The corners fix the bounds, so the seams are at the round numbers.
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> distribution(0.0f, 100.0f);
+  auto getAltitude = [](float x, float z) { return 5.0f * sin(x * 0.1f) * cos(z * 0.07f); };
+  std::vector<glm::vec3> points;
+  for (float z : {0.0f, 100.0f})
+  {
+    for (float x : {0.0f, 100.0f})
+      points.emplace_back(x, getAltitude(x, z), z);
+  }
+  for (int i = 0; i < 20000; ++i)
+  {
+    auto const x = distribution(rng);
+    auto const z = distribution(rng);
+    points.emplace_back(x, getAltitude(x, z), z);
+  }
+  for (int i = 0; i <= 100; ++i)
+  {
+    auto const v = distribution(rng);
+    points.emplace_back(50.0f, getAltitude(50.0f, v), v);
+    points.emplace_back(v, getAltitude(v, 50.0f), 50.0f);
+  }
+
+  float const kMaxError = 0.05f;
+  rf::MeshGenerator generator;
+  std::vector<rf::BaseMesh::MeshGroup> groups;
+  ASSERT_TRUE(generator.GenerateTiledTerrain(points, 30.0f, kMaxError,
+                                             rf::MeshVertexAttribute::Position, groups));
+  ASSERT_EQ(groups.size(), 16u);
+
+  for (auto const & p : points)
+  {
+    if (p.x != 50.0f && p.z != 50.0f)
+      continue;
+    float altitude = 0.0f;
+    ASSERT_TRUE(GetTilesAltitude(groups, p.x, p.z, altitude)) << p.x << " " << p.z;
+    EXPECT_LE(fabs(altitude - p.y), kMaxError + 1e-4f) << p.x << " " << p.z;
+  }
+
+  // Between the points the surface is known up to the linear interpolation of the points.
+  float const kInterpolationError = 0.05f;
+  for (float seam : {25.0f, 50.0f, 75.0f})
+  {
+    for (float v = 0.5f; v < 100.0f; v += 0.5f)
+    {
+      for (auto const & [x, z] : {std::make_pair(seam, v), std::make_pair(v, seam)})
+      {
+        float altitude = 0.0f;
+        ASSERT_TRUE(GetTilesAltitude(groups, x, z, altitude)) << x << " " << z;
+        EXPECT_LE(fabs(altitude - getAltitude(x, z)), kMaxError + kInterpolationError)
+          << x << " " << z;
+      }
+    }
+  }
+}
+
+TEST(MeshGenerator, Tangents)
+{
+  // Plane with rotated and mirrored texture coordinates, the tangent is the direction of U.
+  uint32_t const kSize = 100;
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<glm::vec2> uv;
+  for (uint32_t y = 0; y <= kSize; ++y)
+  {
+    for (uint32_t x = 0; x <= kSize; ++x)
+    {
+      positions.emplace_back(x, 0.0f, y);
+      normals.emplace_back(0.0f, 1.0f, 0.0f);
+      uv.emplace_back(-0.5f * y, 0.5f * x);
+    }
+  }
+  std::vector<uint32_t> indices;
+  for (uint32_t y = 0; y < kSize; ++y)
+  {
+    for (uint32_t x = 0; x < kSize; ++x)
+    {
+      auto const v = y * (kSize + 1) + x;
+      indices.insert(indices.end(), {v, v + kSize + 1, v + kSize + 2, v + kSize + 2, v + 1, v});
+    }
+  }
+
+  std::vector<glm::vec3> tangents;
+  rf::MeshGenerator::CalculateTangents(positions, normals, uv, indices, tangents);
+  ASSERT_EQ(tangents.size(), positions.size());
+  for (auto const & t : tangents)
+    EXPECT_NEAR(glm::distance(t, glm::vec3(0.0f, 0.0f, -1.0f)), 0.0f, 1e-5f);
+
+  // Tangents of the sphere follow the parallels.
+  rf::MeshGenerator generator;
+  rf::BaseMesh::MeshGroup group;
+  ASSERT_TRUE(generator.GenerateSphere(1.0f, rf::MeshVertexAttribute::Position |
+                                       rf::MeshVertexAttribute::Tangent, group, 5));
+  auto const p = reinterpret_cast<glm::vec3 const *>(
+    group.m_vertexBuffers.at(rf::MeshVertexAttribute::Position).data());
+  auto const t = reinterpret_cast<glm::vec3 const *>(
+    group.m_vertexBuffers.at(rf::MeshVertexAttribute::Tangent).data());
+  for (uint32_t i = 0; i < group.m_verticesCount; ++i)
+  {
+    auto const n = glm::normalize(p[i]);
+    EXPECT_NEAR(glm::length(t[i]), 1.0f, 1e-5f);
+    EXPECT_NEAR(glm::dot(t[i], n), 0.0f, 1e-5f);
+    if (fabs(n.y) < 0.9f)
+    {
+      auto const parallel = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), n));
+      EXPECT_GT(fabs(glm::dot(t[i], parallel)), 0.95f);
+    }
+  }
+}
+
+TEST(MeshGenerator, Terrain16Bit)
+{
+  // The same relief in 8 and 16 bits gives the same terrain.
+  uint32_t const kSize = 65;
+  std::mt19937 rnd(5);
+  std::uniform_int_distribution<int> value(0, 3);
+  std::vector<uint8_t> heightmap8(kSize * kSize);
+  for (uint32_t y = 0; y < kSize; ++y)
+  {
+    for (uint32_t x = 0; x < kSize; ++x)
+      heightmap8[y * kSize + x] = static_cast<uint8_t>((x < 20 ? 4 * x : 80) + value(rnd) / 3);
+  }
+  std::vector<uint16_t> heightmap16(heightmap8.size());
+  for (size_t i = 0; i < heightmap8.size(); ++i)
+    heightmap16[i] = static_cast<uint16_t>(heightmap8[i] * 257);
+
+  auto const mask = rf::MeshVertexAttribute::Position | rf::MeshVertexAttribute::Normal;
+  rf::MeshGenerator generator;
+  rf::BaseMesh::MeshGroup group8;
+  rf::BaseMesh::MeshGroup group16;
+  ASSERT_TRUE(generator.GenerateTerrain(heightmap8, kSize, kSize, mask, 0.0f, 10.0f, 64.0f,
+                                        64.0f, group8));
+  ASSERT_TRUE(generator.GenerateTerrain(heightmap16, kSize, kSize, mask, 0.0f, 10.0f, 64.0f,
+                                        64.0f, group16));
+  ASSERT_EQ(group8.m_verticesCount, group16.m_verticesCount);
+  EXPECT_EQ(group8.m_indexBuffer, group16.m_indexBuffer);
+  for (auto const attribute : {rf::MeshVertexAttribute::Position,
+                               rf::MeshVertexAttribute::Normal})
+  {
+    auto const v8 = reinterpret_cast<glm::vec3 const *>(
+      group8.m_vertexBuffers.at(attribute).data());
+    auto const v16 = reinterpret_cast<glm::vec3 const *>(
+      group16.m_vertexBuffers.at(attribute).data());
+    for (uint32_t i = 0; i < group8.m_verticesCount; ++i)
+      EXPECT_NEAR(glm::distance(v8[i], v16[i]), 0.0f, 1e-4f);
+  }
+
+  rf::BaseMesh::MeshGroup adaptive;
+  ASSERT_TRUE(generator.GenerateAdaptiveTerrain(heightmap16, kSize, kSize, mask, 0.0f, 10.0f,
+                                                64.0f, 64.0f, 0.1f, adaptive));
+  EXPECT_LT(adaptive.m_verticesCount, kSize * kSize);
+}
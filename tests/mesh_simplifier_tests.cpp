@@ -0,0 +1,66 @@
+#include "rf.hpp"
+#include "mesh_simplifier.hpp"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+rf::MeshSimplifier::MeshData MakeGrid(uint32_t size, std::function<float(float, float)> const & height)
+{
+  rf::MeshSimplifier::MeshData data;
+  for (uint32_t y = 0; y <= size; ++y)
+  {
+    for (uint32_t x = 0; x <= size; ++x)
+    {
+      auto const px = static_cast<float>(x) / size;
+      auto const pz = static_cast<float>(y) / size;
+      data.m_positions.emplace_back(px, height(px, pz), pz);
+    }
+  }
+
+  for (uint32_t y = 0; y < size; ++y)
+  {
+    for (uint32_t x = 0; x < size; ++x)
+    {
+      auto const i = y * (size + 1) + x;
+      data.m_indices.insert(data.m_indices.end(), {i, i + size + 1, i + size + 2,
+                                                   i + size + 2, i + 1, i});
+    }
+  }
+  return data;
+}
+}  // namespace
+
+TEST(MeshSimplifier, ErrorBoundFlat)
+{
+  auto const data = MakeGrid(16, [](float, float) { return 0.0f; });
+  rf::MeshSimplifier simplifier(data);
+  rf::MeshSimplifier::SimplificationError error;
+  auto const result = simplifier.SimplifyWithErrorBound(0.001, error);
+
+  EXPECT_LT(result.m_indices.size(), data.m_indices.size() / 4);
+  EXPECT_LE(error.m_maxDeviation, 0.001);
+  EXPECT_LE(error.m_meanDeviation, error.m_maxDeviation);
+}
+
+TEST(MeshSimplifier, ErrorBoundCurved)
+{
+  auto const data = MakeGrid(32, [](float x, float z) { return 0.1f * sin(x * 6.0f) * cos(z * 6.0f); });
+  for (double const bound : {0.002, 0.02})
+  {
+    rf::MeshSimplifier simplifier(data);
+    rf::MeshSimplifier::SimplificationError error;
+    auto const result = simplifier.SimplifyWithErrorBound(bound, error);
+
+    EXPECT_LT(result.m_indices.size(), data.m_indices.size());
+    EXPECT_LE(error.m_maxDeviation, bound);
+  }
+}
+
+TEST(MeshSimplifier, LodDistance)
+{
+  auto const d1 = rf::MeshSimplifier::CalculateLodDistance(0.01, DegToRad(60.0f), 1080);
+  auto const d2 = rf::MeshSimplifier::CalculateLodDistance(0.02, DegToRad(60.0f), 1080);
+  EXPECT_GT(d1, 0.0f);
+  EXPECT_FLOAT_EQ(d2, 2.0f * d1);
+}
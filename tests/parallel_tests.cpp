@@ -0,0 +1,39 @@
+#include "parallel.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+TEST(Parallel, EveryIndexOnce)
+{
+  // The pool is reused by the calls of different sizes.
+  for (uint32_t count : {0u, 1u, 2u, 7u, 1000u, 3u, 100000u})
+  {
+    std::vector<std::atomic<uint32_t>> visits(count);
+    rf::ParallelFor(count, [&visits](uint32_t i) { visits[i]++; });
+    for (uint32_t i = 0; i < count; ++i)
+      ASSERT_EQ(visits[i].load(), 1u) << count << " " << i;
+  }
+}
+
+TEST(Parallel, NestedAndConcurrentCalls)
+{
+  uint32_t constexpr kCount = 64;
+  std::atomic<uint32_t> sum(0);
+  auto nested = [&sum]()
+  {
+    rf::ParallelFor(kCount, [&sum](uint32_t)
+    {
+      rf::ParallelFor(kCount, [&sum](uint32_t i) { sum += i; });
+    });
+  };
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < 3; ++i)
+    threads.emplace_back(nested);
+  nested();
+  for (auto & t : threads)
+    t.join();
+  EXPECT_EQ(sum.load(), 4 * kCount * (kCount * (kCount - 1) / 2));
+}
@@ -0,0 +1,158 @@
+#include "rf.hpp"
+#include "progressive_mesh.hpp"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+rf::BaseMesh::MeshGroup MakeGrid(uint32_t size)
+{
+  std::vector<glm::vec3> positions;
+  for (uint32_t y = 0; y <= size; ++y)
+  {
+    for (uint32_t x = 0; x <= size; ++x)
+    {
+      auto const px = static_cast<float>(x) / size;
+      auto const pz = static_cast<float>(y) / size;
+      positions.emplace_back(px, 0.1f * sin(px * 5.0f) * cos(pz * 5.0f), pz);
+    }
+  }
+
+  rf::BaseMesh::MeshGroup group;
+  for (uint32_t y = 0; y < size; ++y)
+  {
+    for (uint32_t x = 0; x < size; ++x)
+    {
+      auto const i = y * (size + 1) + x;
+      group.m_indexBuffer.insert(group.m_indexBuffer.end(), {i, i + size + 1, i + size + 2,
+                                                             i + size + 2, i + 1, i});
+    }
+  }
+
+  auto & buffer = group.m_vertexBuffers[rf::MeshVertexAttribute::Position];
+  buffer.resize(positions.size() * sizeof(glm::vec3));
+  memcpy(buffer.data(), positions.data(), buffer.size());
+  group.m_groupIndex = 0;
+  group.m_verticesCount = static_cast<uint32_t>(positions.size());
+  group.m_indicesCount = static_cast<uint32_t>(group.m_indexBuffer.size());
+  return group;
+}
+
+void CheckIndices(rf::BaseMesh::MeshGroup const & group)
+{
+  for (uint32_t i = 0; i < group.m_indicesCount; ++i)
+    ASSERT_LT(group.m_indexBuffer[i], group.m_verticesCount);
+}
+}  // namespace
+
+TEST(ProgressiveMesh, RefineAndCoarsen)
+{
+  auto group = MakeGrid(16);
+  auto const fullTrianglesCount = group.m_indicesCount / 3;
+
+  rf::ProgressiveMesh mesh;
+  ASSERT_TRUE(mesh.Build(group, 20));
+  ASSERT_GT(mesh.GetLevelsCount(), 0);
+  EXPECT_EQ(mesh.GetLevel(), mesh.GetLevelsCount());
+  EXPECT_EQ(group.m_indicesCount / 3, fullTrianglesCount);
+  auto const fullGroup = group;
+
+  mesh.SetTrianglesCount(group, 0);
+  EXPECT_EQ(mesh.GetLevel(), 0);
+  EXPECT_EQ(group.m_indicesCount / 3, mesh.GetBaseTrianglesCount());
+  EXPECT_EQ(group.m_verticesCount, mesh.GetBaseVerticesCount());
+  CheckIndices(group);
+
+  mesh.SetTrianglesCount(group, fullTrianglesCount / 2);
+  EXPECT_LE(group.m_indicesCount / 3, fullTrianglesCount / 2);
+  EXPECT_GT(group.m_indicesCount / 3, mesh.GetBaseTrianglesCount());
+  CheckIndices(group);
+
+  // Full refinement restores the original mesh exactly.
+  mesh.SetTrianglesCount(group, fullTrianglesCount);
+  EXPECT_EQ(mesh.GetLevel(), mesh.GetLevelsCount());
+  EXPECT_EQ(group.m_indexBuffer, fullGroup.m_indexBuffer);
+  EXPECT_EQ(group.m_vertexBuffers, fullGroup.m_vertexBuffers);
+}
+
+TEST(ProgressiveMesh, Streaming)
+{
+  auto group = MakeGrid(8);
+  rf::ProgressiveMesh mesh;
+  ASSERT_TRUE(mesh.Build(group));
+  auto const fullGroup = group;
+  auto const fullTrianglesCount = group.m_indicesCount / 3;
+
+  // Send the base mesh and the vertex splits only.
+  mesh.SetTrianglesCount(group, 0);
+  rf::BaseMesh::MeshGroup streamed;
+  auto const & positions = group.m_vertexBuffers[rf::MeshVertexAttribute::Position];
+  streamed.m_vertexBuffers[rf::MeshVertexAttribute::Position] =
+      ByteArray(positions.begin(), positions.begin() + group.m_verticesCount * sizeof(glm::vec3));
+  streamed.m_indexBuffer = rf::IndexBuffer32(group.m_indexBuffer.begin(),
+                                             group.m_indexBuffer.begin() + group.m_indicesCount);
+  streamed.m_verticesCount = group.m_verticesCount;
+  streamed.m_indicesCount = group.m_indicesCount;
+
+  rf::ProgressiveMesh receiver;
+  auto splits = mesh.GetVertexSplits();
+  receiver.SetVertexSplits(std::move(splits), mesh.GetBaseVerticesCount(),
+                           mesh.GetBaseTrianglesCount());
+  while (receiver.Refine(streamed))
+  {}
+
+  EXPECT_EQ(streamed.m_indicesCount / 3, fullTrianglesCount);
+  EXPECT_EQ(streamed.m_indexBuffer, fullGroup.m_indexBuffer);
+  EXPECT_EQ(streamed.m_vertexBuffers, fullGroup.m_vertexBuffers);
+}
+
+TEST(ProgressiveMesh, StreamingAttributes)
+{
+  auto group = MakeGrid(8);
+  std::vector<glm::vec3> normals(group.m_verticesCount);
+  std::vector<glm::vec2> uvs(group.m_verticesCount);
+  for (uint32_t i = 0; i < group.m_verticesCount; ++i)
+  {
+    normals[i] = glm::normalize(glm::vec3(0.1f * i, 1.0f, 0.0f));
+    uvs[i] = glm::vec2(static_cast<float>(i), 1.0f / (i + 1));
+  }
+  auto & normalsBuffer = group.m_vertexBuffers[rf::MeshVertexAttribute::Normal];
+  normalsBuffer.resize(normals.size() * sizeof(glm::vec3));
+  memcpy(normalsBuffer.data(), normals.data(), normalsBuffer.size());
+  auto & uvsBuffer = group.m_vertexBuffers[rf::MeshVertexAttribute::UV0];
+  uvsBuffer.resize(uvs.size() * sizeof(glm::vec2));
+  memcpy(uvsBuffer.data(), uvs.data(), uvsBuffer.size());
+
+  rf::ProgressiveMesh mesh;
+  ASSERT_TRUE(mesh.Build(group));
+  ASSERT_GT(mesh.GetLevelsCount(), 0);
+  auto const fullGroup = group;
+
+  // The base mesh only, every attribute is truncated.
+  mesh.SetTrianglesCount(group, 0);
+  rf::BaseMesh::MeshGroup streamed;
+  for (auto const & [attr, buffer] : group.m_vertexBuffers)
+  {
+    auto const size = group.m_verticesCount * rf::GetAttributeSizeInBytes(attr);
+    streamed.m_vertexBuffers[attr] = ByteArray(buffer.begin(), buffer.begin() + size);
+  }
+  streamed.m_indexBuffer = rf::IndexBuffer32(group.m_indexBuffer.begin(),
+                                             group.m_indexBuffer.begin() + group.m_indicesCount);
+  streamed.m_verticesCount = group.m_verticesCount;
+  streamed.m_indicesCount = group.m_indicesCount;
+
+  rf::ProgressiveMesh receiver;
+  auto splits = mesh.GetVertexSplits();
+  receiver.SetVertexSplits(std::move(splits), mesh.GetBaseVerticesCount(),
+                           mesh.GetBaseTrianglesCount());
+  while (receiver.Refine(streamed))
+  {
+    for (auto const & [attr, buffer] : streamed.m_vertexBuffers)
+      ASSERT_EQ(buffer.size(), streamed.m_verticesCount * rf::GetAttributeSizeInBytes(attr));
+  }
+
+  EXPECT_EQ(streamed.m_vertexBuffers.size(), 3);
+  EXPECT_EQ(streamed.m_verticesCount, fullGroup.m_verticesCount);
+  EXPECT_EQ(streamed.m_indexBuffer, fullGroup.m_indexBuffer);
+  EXPECT_EQ(streamed.m_vertexBuffers, fullGroup.m_vertexBuffers);
+}
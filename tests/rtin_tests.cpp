@@ -0,0 +1,134 @@
+#include "rtin.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+template <typename T>
+void CheckTriangulation(std::vector<T> const & heightmap, uint32_t width, uint32_t height,
+                        float maxError)
+{
+  rf::Rtin rtin;
+  ASSERT_TRUE(rtin.Initialize(heightmap, width, height));
+  std::vector<uint32_t> vertices;
+  std::vector<uint32_t> indices;
+  rtin.Triangulate(maxError, vertices, indices);
+  ASSERT_FALSE(indices.empty());
+  ASSERT_EQ(indices.size() % 3, 0u);
+
+  std::vector<float> maxDeviation(heightmap.size(), -1.0f);
+  int64_t doubleArea = 0;
+  for (size_t i = 0; i < indices.size(); i += 3)
+  {
+    int x[3], y[3];
+    float h[3];
+    for (int k = 0; k < 3; ++k)
+    {
+      auto const sample = vertices[indices[i + k]];
+      x[k] = static_cast<int>(sample % width);
+      y[k] = static_cast<int>(sample / width);
+      h[k] = heightmap[sample];
+    }
+
+    // The same orientation as in MeshGenerator::GeneratePlane.
+    auto const orientation = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    ASSERT_LT(orientation, 0);
+    doubleArea -= orientation;
+
+    for (int sy = std::min({y[0], y[1], y[2]}); sy <= std::max({y[0], y[1], y[2]}); ++sy)
+    {
+      for (int sx = std::min({x[0], x[1], x[2]}); sx <= std::max({x[0], x[1], x[2]}); ++sx)
+      {
+        auto const w0 = static_cast<float>((x[1] - sx) * (y[2] - sy) - (y[1] - sy) * (x[2] - sx));
+        auto const w1 = static_cast<float>((x[2] - sx) * (y[0] - sy) - (y[2] - sy) * (x[0] - sx));
+        auto const w2 = static_cast<float>((x[0] - sx) * (y[1] - sy) - (y[0] - sy) * (x[1] - sx));
+        if (w0 > 0 || w1 > 0 || w2 > 0)
+          continue;
+
+        auto const interpolated = (w0 * h[0] + w1 * h[1] + w2 * h[2]) / (w0 + w1 + w2);
+        auto & deviation = maxDeviation[sy * width + sx];
+        deviation = std::max(deviation, std::fabs(interpolated - heightmap[sy * width + sx]));
+      }
+    }
+  }
+
+  // No holes and no overlaps.
+  EXPECT_EQ(doubleArea, 2 * static_cast<int64_t>(width - 1) * (height - 1));
+  for (auto const d : maxDeviation)
+  {
+    EXPECT_GE(d, 0.0f);
+    EXPECT_LE(d, maxError + 1e-3f);
+  }
+}
+}  // namespace
+
+TEST(Rtin, FlatHeightmap)
+{
+  std::vector<uint8_t> const heightmap(33 * 33, 100);
+  rf::Rtin rtin;
+  ASSERT_TRUE(rtin.Initialize(heightmap, 33, 33));
+  std::vector<uint32_t> vertices;
+  std::vector<uint32_t> indices;
+  rtin.Triangulate(0.0f, vertices, indices);
+  EXPECT_EQ(vertices.size(), 4u);
+  EXPECT_EQ(indices.size(), 6u);
+
+  // Sizes which are not 2^k + 1 are covered by a bigger grid.
+  CheckTriangulation(std::vector<uint8_t>(20 * 13, 7), 20, 13, 0.0f);
+}
+
+TEST(Rtin, MaxError)
+{
+  uint32_t const kWidth = 71;
+  uint32_t const kHeight = 45;
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> noise(-3, 3);
+  std::vector<uint8_t> heightmap(kWidth * kHeight);
+  for (uint32_t y = 0; y < kHeight; ++y)
+  {
+    for (uint32_t x = 0; x < kWidth; ++x)
+    {
+      auto const h = 120.0 + 60.0 * sin(x * 0.15) * cos(y * 0.2) + noise(rng);
+      heightmap[y * kWidth + x] = static_cast<uint8_t>(h);
+    }
+  }
+
+  for (float const maxError : {0.0f, 1.0f, 5.0f, 20.0f})
+    CheckTriangulation(heightmap, kWidth, kHeight, maxError);
+
+  // The mesh is coarser with a bigger error.
+  rf::Rtin rtin;
+  ASSERT_TRUE(rtin.Initialize(heightmap, kWidth, kHeight));
+  std::vector<uint32_t> vertices1, vertices2;
+  std::vector<uint32_t> indices;
+  rtin.Triangulate(1.0f, vertices1, indices);
+  rtin.Triangulate(20.0f, vertices2, indices);
+  EXPECT_LT(vertices2.size(), vertices1.size());
+}
+
+TEST(Rtin, Heightmap16)
+{
+  uint32_t const kWidth = 50;
+  uint32_t const kHeight = 33;
+  std::vector<uint16_t> heightmap(kWidth * kHeight);
+  for (uint32_t y = 0; y < kHeight; ++y)
+  {
+    for (uint32_t x = 0; x < kWidth; ++x)
+    {
+      auto const h = 30000.0 + 20000.0 * sin(x * 0.13) * cos(y * 0.17) + (x * 7 + y * 13) % 5;
+      heightmap[y * kWidth + x] = static_cast<uint16_t>(h);
+    }
+  }
+
+  for (float const maxError : {0.0f, 3.0f, 100.0f, 1000.0f})
+    CheckTriangulation(heightmap, kWidth, kHeight, maxError);
+}
+
+TEST(Rtin, InvalidHeightmap)
+{
+  rf::Rtin rtin;
+  EXPECT_FALSE(rtin.Initialize(std::vector<uint8_t>(10), 1, 10));
+  EXPECT_FALSE(rtin.Initialize(std::vector<uint8_t>(10), 4, 4));
+}
@@ -0,0 +1,170 @@
+#include "rf.hpp"
+#include "skinning_avx.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+template <typename T>
+void SetBuffer(rf::BaseMesh::MeshGroup & group, rf::MeshVertexAttribute attr,
+               std::vector<T> const & data)
+{
+  auto & buffer = group.m_vertexBuffers[attr];
+  buffer.resize(data.size() * sizeof(T));
+  memcpy(buffer.data(), data.data(), buffer.size());
+}
+}  // namespace
+
+TEST(Skinning, MatchesReference)
+{
+  std::mt19937 rnd(5);
+  std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+  uint32_t constexpr kBonesCount = 20;
+  // Blocks of the workers and the tail after the last 8 vertices.
+  uint32_t constexpr kVerticesCount = 10007;
+
+  std::vector<glm::mat4x4> bones(kBonesCount);
+  for (auto & b : bones)
+  {
+    auto const q = glm::normalize(glm::quat(value(rnd), value(rnd), value(rnd), value(rnd)));
+    b = glm::translate(glm::mat4x4(), glm::vec3(value(rnd), value(rnd), value(rnd))) *
+        glm::mat4_cast(q);
+  }
+
+  std::vector<glm::vec3> positions(kVerticesCount);
+  std::vector<glm::vec3> normals(kVerticesCount);
+  std::vector<uint32_t> indices(kVerticesCount * rf::kMaxBonesPerVertex);
+  std::vector<float> weights(kVerticesCount * rf::kMaxBonesPerVertex);
+  std::uniform_int_distribution<uint32_t> boneIndex(0, kBonesCount);
+  for (uint32_t v = 0; v < kVerticesCount; ++v)
+  {
+    positions[v] = glm::vec3(value(rnd), value(rnd), value(rnd)) * 5.0f;
+    normals[v] = glm::normalize(glm::vec3(value(rnd), value(rnd), value(rnd)));
+    float sum = 0.0f;
+    for (uint32_t k = 0; k < rf::kMaxBonesPerVertex; ++k)
+    {
+      // kBonesCount is out of the transforms and must not deform the vertex.
+      indices[v * rf::kMaxBonesPerVertex + k] = boneIndex(rnd);
+      weights[v * rf::kMaxBonesPerVertex + k] = value(rnd) + 1.0f;
+      sum += weights[v * rf::kMaxBonesPerVertex + k];
+    }
+    for (uint32_t k = 0; k < rf::kMaxBonesPerVertex; ++k)
+      weights[v * rf::kMaxBonesPerVertex + k] /= sum;
+  }
+
+  rf::BaseMesh::MeshGroup group;
+  group.m_verticesCount = kVerticesCount;
+  SetBuffer(group, rf::MeshVertexAttribute::Position, positions);
+  SetBuffer(group, rf::MeshVertexAttribute::BoneIndices, indices);
+  SetBuffer(group, rf::MeshVertexAttribute::BoneWeights, weights);
+
+  std::vector<glm::vec3> skinnedPositions;
+  std::vector<glm::vec3> skinnedNormals;
+  ASSERT_TRUE(rf::SkinMeshGroup(group, bones, skinnedPositions, skinnedNormals));
+  EXPECT_EQ(skinnedPositions.size(), kVerticesCount);
+  EXPECT_TRUE(skinnedNormals.empty());
+
+  SetBuffer(group, rf::MeshVertexAttribute::Normal, normals);
+  ASSERT_TRUE(rf::SkinMeshGroup(group, bones, skinnedPositions, skinnedNormals));
+  ASSERT_EQ(skinnedNormals.size(), kVerticesCount);
+
+  for (uint32_t v = 0; v < kVerticesCount; ++v)
+  {
+    glm::mat4x4 m(0.0f);
+    for (uint32_t k = 0; k < rf::kMaxBonesPerVertex; ++k)
+    {
+      auto const i = indices[v * rf::kMaxBonesPerVertex + k];
+      auto const & b = i < kBonesCount ? bones[i] : glm::mat4x4();
+      for (int c = 0; c < 4; ++c)
+        m[c] += b[c] * weights[v * rf::kMaxBonesPerVertex + k];
+    }
+    auto const p = glm::vec3(m * glm::vec4(positions[v], 1.0f));
+    auto const n = glm::normalize(glm::vec3(m * glm::vec4(normals[v], 0.0f)));
+    EXPECT_LE(glm::length(p - skinnedPositions[v]), 1e-4f) << v;
+    EXPECT_LE(glm::length(n - skinnedNormals[v]), 1e-4f) << v;
+  }
+
+  rf::BaseMesh::MeshGroup empty;
+  EXPECT_FALSE(rf::SkinMeshGroup(empty, bones, skinnedPositions, skinnedNormals));
+}
+
+TEST(Skinning, AvxKernel)
+{
+  // The kernel is built by default on x86, the scalar path is covered by MatchesReference.
+  if (!rf::IsAvxSkinningAvailable())
+    return;
+
+  std::mt19937 rnd(7);
+  std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+  uint32_t constexpr kBonesCount = 5;
+  uint32_t constexpr kVerticesCount = 21;
+
+  // The last bone is the identity one for the invalid indices.
+  std::vector<float> bones((kBonesCount + 1) * rf::kSkinningBoneSize);
+  for (auto & e : bones)
+    e = value(rnd);
+  for (uint32_t i = 0; i < rf::kSkinningBoneSize; ++i)
+    bones[kBonesCount * rf::kSkinningBoneSize + i] = (i % 5 == 0) ? 1.0f : 0.0f;
+
+  std::vector<float> positions(kVerticesCount * 3);
+  std::vector<float> normals(kVerticesCount * 3);
+  for (auto & e : positions)
+    e = value(rnd) * 5.0f;
+  for (auto & e : normals)
+    e = value(rnd);
+  std::vector<uint32_t> indices(kVerticesCount * rf::kSkinningBonesPerVertex);
+  std::vector<float> weights(kVerticesCount * rf::kSkinningBonesPerVertex);
+  std::uniform_int_distribution<uint32_t> boneIndex(0, kBonesCount + 1);
+  for (uint32_t i = 0; i < indices.size(); ++i)
+  {
+    indices[i] = boneIndex(rnd);
+    weights[i] = 0.5f * (value(rnd) + 1.0f);
+  }
+
+  rf::SkinningData data;
+  data.m_positions = positions.data();
+  data.m_normals = normals.data();
+  data.m_boneIndices = indices.data();
+  data.m_boneWeights = weights.data();
+  data.m_bones = bones.data();
+  data.m_bonesCount = kBonesCount;
+  std::vector<float> outPositions(positions.size(), 0.0f);
+  std::vector<float> outNormals(normals.size(), 0.0f);
+  data.m_outPositions = outPositions.data();
+  data.m_outNormals = outNormals.data();
+
+  // The tail is left for the scalar code.
+  ASSERT_EQ(rf::SkinVerticesAvx(data, 1, kVerticesCount), 17u);
+  for (uint32_t v = 0; v < kVerticesCount; ++v)
+  {
+    if (v == 0 || v >= 17)
+    {
+      EXPECT_EQ(outPositions[v * 3], 0.0f) << v;
+      continue;
+    }
+
+    float m[rf::kSkinningBoneSize] = {};
+    for (uint32_t k = 0; k < rf::kSkinningBonesPerVertex; ++k)
+    {
+      auto const i = v * rf::kSkinningBonesPerVertex + k;
+      auto const bone = std::min(indices[i], kBonesCount) * rf::kSkinningBoneSize;
+      for (uint32_t e = 0; e < rf::kSkinningBoneSize; ++e)
+        m[e] += weights[i] * bones[bone + e];
+    }
+    glm::vec3 p(m[3], m[7], m[11]);
+    glm::vec3 n(0.0f);
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+      p += glm::vec3(m[c], m[4 + c], m[8 + c]) * positions[v * 3 + c];
+      n += glm::vec3(m[c], m[4 + c], m[8 + c]) * normals[v * 3 + c];
+    }
+    n = glm::normalize(n);
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+      EXPECT_NEAR(outPositions[v * 3 + c], p[c], 1e-4f) << v;
+      EXPECT_NEAR(outNormals[v * 3 + c], n[c], 1e-4f) << v;
+    }
+  }
+}
@@ -0,0 +1,240 @@
+#include "rf.hpp"
+#include "heightmap.hpp"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+std::vector<uint8_t> MakeHeightmap(uint32_t width, uint32_t height)
+{
+  std::vector<uint8_t> heightmap(width * height);
+  for (uint32_t y = 0; y < height; ++y)
+  {
+    for (uint32_t x = 0; x < width; ++x)
+      heightmap[y * width + x] =
+        static_cast<uint8_t>(127.0f + 120.0f * sin(x * 0.05f) * cos(y * 0.07f));
+  }
+  return heightmap;
+}
+
+// Selected chunks must cover the terrain exactly once.
+float GetCoveredArea(rf::TerrainQuadtree const & quadtree, std::vector<int> const & drawList)
+{
+  float area = 0.0f;
+  for (auto const index : drawList)
+  {
+    for (auto const & node : quadtree.GetNodes())
+    {
+      if (node.m_groupIndex == index)
+      {
+        auto const d = node.m_boundingBox.getDiagonal();
+        area += d.x * d.z;
+      }
+    }
+  }
+  return area;
+}
+}  // namespace
+
+TEST(TerrainQuadtree, Selection)
+{
+  uint32_t const kSize = 257;
+  auto const heightmap = MakeHeightmap(kSize, kSize);
+  rf::TerrainSettings settings;
+  settings.m_width = 256.0f;
+  settings.m_height = 256.0f;
+  settings.m_maxAltitude = 20.0f;
+  settings.m_chunkSize = 32;
+
+  rf::TerrainQuadtree quadtree;
+  std::vector<rf::BaseMesh::MeshGroup> groups;
+  ASSERT_TRUE(quadtree.Build(heightmap, kSize, kSize, settings, rf::MeshVertexAttribute::Position,
+                             groups));
+  EXPECT_EQ(quadtree.GetLodsCount(), 4u);
+  EXPECT_EQ(quadtree.GetNodes().size(), 1u + 4u + 16u + 64u);
+  EXPECT_EQ(groups.size(), quadtree.GetNodes().size());
+
+  auto const allVisible = [](AABB const &) { return true; };
+  std::vector<int> drawList;
+
+  // Far away, the root chunk only.
+  quadtree.Select(glm::vec3(0.0f, 10000.0f, 0.0f), allVisible, drawList);
+  ASSERT_EQ(drawList.size(), 1u);
+  EXPECT_EQ(drawList[0], 0);
+
+  // Near the corner, the finest chunks around the viewer, the coarser ones far away.
+  quadtree.Select(glm::vec3(-128.0f, 10.0f, -128.0f), allVisible, drawList);
+  EXPECT_GT(drawList.size(), 4u);
+  EXPECT_LT(drawList.size(), 64u);
+  // Tile size is width / heightmapWidth, like in MeshGenerator::GenerateTerrain.
+  float const extent = settings.m_width * (kSize - 1) / kSize;
+  EXPECT_NEAR(GetCoveredArea(quadtree, drawList), extent * extent, 1.0f);
+  bool hasFinest = false;
+  bool hasCoarse = false;
+  for (auto const index : drawList)
+  {
+    auto const lod = quadtree.GetNodes()[index].m_lod;
+    hasFinest |= (lod == 0);
+    hasCoarse |= (lod >= 2);
+  }
+  EXPECT_TRUE(hasFinest);
+  EXPECT_TRUE(hasCoarse);
+}
+
+TEST(TerrainQuadtree, FrustumCulling)
+{
+  uint32_t const kSize = 129;
+  auto const heightmap = MakeHeightmap(kSize, kSize);
+  rf::TerrainSettings settings;
+  settings.m_width = 1024.0f;
+  settings.m_height = 1024.0f;
+  settings.m_chunkSize = 16;
+
+  rf::TerrainQuadtree quadtree;
+  std::vector<rf::BaseMesh::MeshGroup> groups;
+  ASSERT_TRUE(quadtree.Build(heightmap, kSize, kSize, settings, rf::MeshVertexAttribute::Position,
+                             groups));
+
+  rf::Camera camera;
+  camera.Initialize(1024, 768);
+  camera.SetPosition(glm::vec3(0.0f, 5.0f, 0.0f));
+
+  // Looking along +Z, the chunks behind the camera are culled.
+  std::vector<int> drawList;
+  quadtree.Select(camera, drawList);
+  ASSERT_FALSE(drawList.empty());
+  for (auto const index : drawList)
+    EXPECT_GT(quadtree.GetNodes()[index].m_boundingBox.getMax().z, 0.0f);
+}
+
+TEST(TerrainQuadtree, Patches)
+{
+  uint32_t const kSize = 200;
+  auto const heightmap = MakeHeightmap(kSize, kSize);
+  rf::TerrainSettings settings;
+  settings.m_width = 200.0f;
+  settings.m_height = 200.0f;
+  settings.m_maxAltitude = 20.0f;
+  settings.m_chunkSize = 16;
+
+  rf::TerrainQuadtree quadtree;
+  ASSERT_TRUE(quadtree.BuildPatches(heightmap, kSize, kSize, settings));
+  EXPECT_EQ(quadtree.GetLodsCount(), 5u);
+
+  // The same nodes as the chunks built with the geometry. Boxes of the patches are calculated
+  // from the full resolution samples, so they contain the boxes of the coarse chunks.
+  rf::TerrainQuadtree chunks;
+  std::vector<rf::BaseMesh::MeshGroup> groups;
+  ASSERT_TRUE(chunks.Build(heightmap, kSize, kSize, settings, rf::MeshVertexAttribute::Position,
+                           groups));
+  ASSERT_EQ(quadtree.GetNodes().size(), chunks.GetNodes().size());
+  for (size_t i = 0; i < chunks.GetNodes().size(); ++i)
+  {
+    auto const & node = quadtree.GetNodes()[i];
+    EXPECT_EQ(node.m_groupIndex, -1);
+    EXPECT_EQ(node.m_lod, chunks.GetNodes()[i].m_lod);
+    auto const & box = chunks.GetNodes()[i].m_boundingBox;
+    EXPECT_NEAR(node.m_boundingBox.getMin().x, box.getMin().x, 1e-4f);
+    EXPECT_NEAR(node.m_boundingBox.getMin().z, box.getMin().z, 1e-4f);
+    EXPECT_NEAR(node.m_boundingBox.getMax().x, box.getMax().x, 1e-4f);
+    EXPECT_NEAR(node.m_boundingBox.getMax().z, box.getMax().z, 1e-4f);
+    EXPECT_GE(node.m_boundingBox.getMax().y, box.getMax().y - 1e-4f);
+  }
+
+  // Selected patches cover the heightmap exactly once.
+  std::vector<rf::TerrainQuadtree::PatchInstance> patches;
+  quadtree.Select(glm::vec3(-100.0f, 10.0f, 50.0f), [](AABB const &) { return true; }, patches);
+  EXPECT_GT(patches.size(), 4u);
+  std::vector<uint32_t> coverage((kSize - 1) * (kSize - 1), 0);
+  for (auto const & patch : patches)
+  {
+    auto const size = static_cast<uint32_t>(settings.m_chunkSize * patch.m_scale);
+    EXPECT_EQ(patch.m_scale, static_cast<float>(1u << static_cast<uint32_t>(patch.m_lod)));
+    for (uint32_t y = 0; y < size; ++y)
+    {
+      for (uint32_t x = 0; x < size; ++x)
+      {
+        auto const sx = static_cast<uint32_t>(patch.m_offset.x) + x;
+        auto const sy = static_cast<uint32_t>(patch.m_offset.y) + y;
+        if (sx + 1 < kSize && sy + 1 < kSize)
+          coverage[sy * (kSize - 1) + sx]++;
+      }
+    }
+  }
+  for (auto const c : coverage)
+    ASSERT_EQ(c, 1u);
+
+  // Invisible patches are culled.
+  quadtree.Select(glm::vec3(-100.0f, 10.0f, 50.0f),
+                  [](AABB const & box) { return box.getMax().x < 0.0f; }, patches);
+  for (auto const & patch : patches)
+    EXPECT_LT(patch.m_offset.x, kSize / 2);
+}
+
+TEST(TerrainQuadtree, Streaming)
+{
+  uint32_t const kWidth = 201;
+  uint32_t const kHeight = 173;
+  std::string const kFileName = "terrain_streaming_test.raw";
+  auto const heightmap8 = MakeHeightmap(kWidth, kHeight);
+  std::vector<uint16_t> heightmap(heightmap8.size());
+  for (size_t i = 0; i < heightmap.size(); ++i)
+    heightmap[i] = static_cast<uint16_t>(heightmap8[i] * 257 + i % 7);
+  auto f = fopen(kFileName.c_str(), "wb");
+  ASSERT_NE(f, nullptr);
+  fwrite(heightmap.data(), sizeof(uint16_t), heightmap.size(), f);
+  fclose(f);
+
+  rf::TerrainSettings settings;
+  settings.m_width = 200.0f;
+  settings.m_height = 172.0f;
+  settings.m_maxAltitude = 20.0f;
+  settings.m_chunkSize = 16;
+  auto const componentsMask = rf::MeshVertexAttribute::Position |
+                              rf::MeshVertexAttribute::Normal | rf::MeshVertexAttribute::UV0;
+
+  // The reference chunks are built from the resident heightmap.
+  rf::TerrainQuadtree reference;
+  std::vector<rf::BaseMesh::MeshGroup> groups;
+  ASSERT_TRUE(reference.Build(heightmap, kWidth, kHeight, settings, componentsMask, groups));
+
+  {
+    rf::HeightmapFile file;
+    ASSERT_TRUE(file.Open(kFileName, kWidth, kHeight, rf::HeightmapFile::Format::UInt16));
+    rf::TerrainQuadtree quadtree;
+    ASSERT_TRUE(quadtree.Build(file, settings, componentsMask));
+    ASSERT_EQ(quadtree.GetNodes().size(), groups.size());
+    EXPECT_EQ(quadtree.GetChunksCount(), 0u);
+
+    // Only the selected chunks are generated, they match the reference ones.
+    auto const allVisible = [](AABB const &) { return true; };
+    std::vector<int> drawList;
+    quadtree.UpdateChunks(glm::vec3(-100.0f, 10.0f, -86.0f), allVisible, drawList);
+    EXPECT_GT(drawList.size(), 4u);
+    EXPECT_LT(drawList.size(), groups.size() / 2);
+    EXPECT_EQ(quadtree.GetChunksCount(), drawList.size());
+    for (auto const index : drawList)
+    {
+      auto const * chunk = quadtree.GetChunk(index);
+      ASSERT_NE(chunk, nullptr);
+      EXPECT_EQ(chunk->m_groupIndex, index);
+      EXPECT_EQ(chunk->m_vertexBuffers, groups[index].m_vertexBuffers) << index;
+      EXPECT_EQ(chunk->m_indexBuffer, groups[index].m_indexBuffer) << index;
+    }
+
+    // Culled chunks are not generated.
+    quadtree.UpdateChunks(glm::vec3(-100.0f, 10.0f, -86.0f),
+                          [](AABB const & box) { return box.getMin().x < -90.0f; }, drawList);
+    EXPECT_FALSE(drawList.empty());
+    for (auto const index : drawList)
+      EXPECT_LT(quadtree.GetNodes()[index].m_boundingBox.getMin().x, -90.0f);
+
+    // Far away, the finer chunks are released.
+    quadtree.UpdateChunks(glm::vec3(0.0f, 10000.0f, 0.0f), allVisible, drawList);
+    ASSERT_EQ(drawList.size(), 1u);
+    EXPECT_EQ(drawList.front(), 0);
+    EXPECT_EQ(quadtree.GetChunksCount(), 1u);
+    EXPECT_EQ(quadtree.GetChunk(0)->m_vertexBuffers, groups[0].m_vertexBuffers);
+  }
+  std::remove(kFileName.c_str());
+}